@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <chrono>
+#include <thread>
 
 // By using the OpenGL types (like GLint) GLEW ensures we are using the most optimized implementations (memory allocation, for instance)
 const GLint WIDTH = 800, HEIGHT = 600;
@@ -17,10 +18,21 @@ const GLint WIDTH = 800, HEIGHT = 600;
 GLuint VAO, VBO, pShader; // Unsigned integer
 
 bool direction = true, sizeDirection = true, angleDirection = true; // True: translate right; False: translate left
-float triOffset = 0.0f, triOffsetMax = 0.7f, triIncrement = 0.005f; // Increment is related to local FPS if not limited
+float triOffset = 0.0f, triOffsetMax = 0.7f, triIncrement = 0.005f; // Increments are applied once per animation step (see STEP_RATE)
 float size = 0.4f, sizeMax = 0.8f, sizeMin = 0.1f, sizeIncrement = 0.005f;
 float angle = 0.0f, angleMax = 360.0, angleMin = 0.0f, angleIncrement = 0.1f;
 
+// Fixed-step animation: the movement rules run STEP_RATE times per second whatever the frame rate, so the
+// increments above are per step. Each frame draws the state interpolated between the last two steps
+const double STEP_RATE = 60.0;
+const double MAX_FRAME_TIME = 0.25; // Longer frames (a stall, a moved window) are clamped instead of caught up
+float previousOffset = 0.0f, previousSize = 0.4f, previousAngle = 0.0f; // State before the last step
+
+// Frame limiter: vsync caps the frame rate, but drivers may ignore it, so frames are also paced to TARGET_FPS.
+// Sleep for most of the wait (cheap) and spin the last SPIN_TIME (sleeps can wake up late)
+const double TARGET_FPS = 60.0;
+const double SPIN_TIME = 0.002;
+
 // Vertex shader. Version 3.3.0 of GLSL (OpenGL Shading Language)
 // Through the matrix model we can pass x, y and z movement all at once in a single variable
 static const char *vShader = "                               \n\
@@ -150,6 +162,43 @@ void CompileShader() {
 	}
 }
 
+// One fixed step of the movement rules
+void AnimationStep() {
+	previousOffset = triOffset;
+	previousSize = size;
+	previousAngle = angle;
+
+	/********************************
+	*	Translate and Scale
+	*********************************/
+	// Movement rule
+	if (direction)
+		triOffset += triIncrement; // Translate right
+	else
+		triOffset -= triIncrement; // Translate left
+
+	if (abs(triOffset) >= triOffsetMax) // If predetermined max offset was reached, change direction
+		direction = !direction;
+
+	// Scaling rule
+	if (sizeDirection)
+		size += sizeIncrement; // Scale up
+	else
+		size -= sizeIncrement; // Scale down
+
+	if (size >= sizeMax || size <= sizeMin) // If predetermined max/min scaling was reached, change scaling direction
+		sizeDirection = !sizeDirection;
+
+	// Rotation rule
+	if (angleDirection)
+		angle += angleIncrement; // Rotate left
+	else
+		angle -= angleIncrement; // Rotate right
+
+	if (angle >= angleMax || angle <= angleMin) // If predetermined max/min angle was reached, change rotation direction
+		angleDirection = !angleDirection;
+}
+
 int main() {
 
 	/********************************
@@ -204,6 +253,9 @@ int main() {
 		return 1;
 	}
 
+	// Swap once per screen refresh (vsync) instead of as fast as possible
+	glfwSwapInterval(1);
+
 	// VIEWPORT configuration, passing framebuffer size in pixels
 	glViewport(0, 0, bufferWidth, bufferHeight); 
 
@@ -212,12 +264,32 @@ int main() {
 	CompileShader();
 
 	auto t_start = std::chrono::high_resolution_clock::now();
+	auto t_last = t_start;
+	double accumulator = 0.0; // Real time not simulated yet
+	auto nextFrame = t_start; // When the next frame may be shown
 
 	// Run till window gets closed
 	while (!glfwWindowShouldClose(mainWindow)) {
 		// Activate inputs and events (mouse and keyboard input, for instance)
 		glfwPollEvents();
 
+		/********************************
+		*	Fixed-step animation
+		*********************************/
+		auto t_now = std::chrono::high_resolution_clock::now();
+		double frameTime = std::chrono::duration_cast<std::chrono::duration<double>>(t_now - t_last).count();
+		t_last = t_now;
+		if (frameTime > MAX_FRAME_TIME)
+			frameTime = MAX_FRAME_TIME;
+		accumulator += frameTime;
+		while (accumulator >= 1.0 / STEP_RATE) {
+			AnimationStep();
+			accumulator -= 1.0 / STEP_RATE;
+		}
+		// How far this frame is between the last two steps (0 to 1)
+		float alpha = (float)(accumulator * STEP_RATE);
+		float renderAngle = previousAngle + (angle - previousAngle) * alpha;
+
 		/********************************
 		*	Background Color
 		*********************************/
@@ -233,7 +305,6 @@ int main() {
 		glUseProgram(pShader); // Use the program which we put in the GPU memory
 			glBindVertexArray(VAO); // Binds ID to VAO
 
-			auto t_now = std::chrono::high_resolution_clock::now();
 			float time = std::chrono::duration_cast<std::chrono::duration<float>>(t_now - t_start).count();
 				
 				// GPU memory works with *int*
@@ -243,45 +314,15 @@ int main() {
 				float b = 0.0f;
 				glUniform3f(uniColor, r, g, b); // Assigns the color read above
 
-				/********************************
-				*	Translate and Scale
-				*********************************/
-				// Movement rule
-				if (direction)
-					triOffset += triIncrement; // Translate right
-				else
-					triOffset -= triIncrement; // Translate left
-
-				if (abs(triOffset) >= triOffsetMax) // If predetermined max offset was reached, change direction
-					direction = !direction;
-
-				// Scaling rule
-				if (sizeDirection)
-					size += sizeIncrement; // Scale up
-				else
-					size -= sizeIncrement; // Scale down
-
-				if (size >= sizeMax || size <= sizeMin) // If predetermined max/min scaling was reached, change scaling direction
-					sizeDirection = !sizeDirection;
-
-				// Rotation rule
-				if (angleDirection)
-					angle += angleIncrement; // Rotate left
-				else
-					angle -= angleIncrement; // Rotate right
-
-				if (angle >= angleMax || angle <= angleMin) // If predetermined max/min angle was reached, change rotation direction
-					angleDirection = !angleDirection;
-				
 				GLint uniModel = glGetUniformLocation(pShader, "model"); // Searches for the 'model' variable in the pShader program
 				glm::mat4 model(1.0f); // glm::mat4 get the 'mat4' function inside the class 'glm'.
 									   // Fill the (4x4) model matrix with 1's
 
 				// Movement: model gets updated by the translate function
-				//model = glm::translate(model, glm::vec3(triOffset, 0.0f, 0.0f)); // glm::vec3 returns the specified vector in the correct format
+				//model = glm::translate(model, glm::vec3(previousOffset + (triOffset - previousOffset) * alpha, 0.0f, 0.0f)); // glm::vec3 returns the specified vector in the correct format
 				
 				// Rotate: model gets updated by the rotation funtion
-				model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f)); // glm::vec3 returns the specified vector in the correct format
+				model = glm::rotate(model, glm::radians(renderAngle), glm::vec3(0.0f, 0.0f, 1.0f)); // glm::vec3 returns the specified vector in the correct format
 
 				// Scale: model gets updated by the scaling function
 				model = glm::scale(model, glm::vec3(0.4f, 0.4f, 1.0f)); // glm::vec3 returns the specified vector in the correct format
@@ -299,6 +340,17 @@ int main() {
 		/********************************
 		*	Update Screen
 		*********************************/
+		// Wait for this frame's slot: sleep, then spin the last bit
+		nextFrame += std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(1.0 / TARGET_FPS));
+		auto frameNow = std::chrono::high_resolution_clock::now();
+		if (nextFrame < frameNow) {
+			nextFrame = frameNow; // Missed the slot: start over instead of rushing the next frames
+		}
+		std::this_thread::sleep_until(nextFrame - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(SPIN_TIME)));
+		while (std::chrono::high_resolution_clock::now() < nextFrame) {
+			std::this_thread::yield();
+		}
+
 		// Swap buffer -> Executes the instructions queued in the memory buffer
 		glfwSwapBuffers(mainWindow);
 	}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include "Archetype.h"
+
+static std::vector<ComponentInfo>& ComponentRegistry() {
+	static std::vector<ComponentInfo> registry;
+	return registry;
+}
+
+unsigned int RegisterComponentType(const ComponentInfo& info) {
+	std::vector<ComponentInfo>& registry = ComponentRegistry();
+	if (registry.size() >= MAX_COMPONENT_TYPES) {
+		printf("Too many component types (max %u)\n", MAX_COMPONENT_TYPES);
+	}
+	registry.push_back(info);
+	return (unsigned int)registry.size() - 1;
+}
+
+const ComponentInfo& GetComponentInfo(unsigned int typeID) {
+	return ComponentRegistry()[typeID];
+}
+
+static size_t AlignUp(size_t value, size_t align) {
+	return (value + align - 1) / align * align;
+}
+
+Archetype::Archetype(ComponentMask componentMask) {
+	mask = componentMask;
+	size_t rowSize = sizeof(Entity);
+	for (unsigned int typeID = 0; typeID < MAX_COMPONENT_TYPES; typeID++) {
+		offsets[typeID] = 0;
+		if (mask & ((ComponentMask)1 << typeID)) {
+			typeIDs.push_back(typeID);
+			rowSize += GetComponentInfo(typeID).size;
+		}
+	}
+
+	// Worst case padding between arrays is one alignment (16 bytes) per array
+	capacity = (GLuint)((Chunk::CHUNK_SIZE - 16 * (typeIDs.size() + 1)) / rowSize);
+	if (capacity == 0) {
+		capacity = 1;
+		printf("Archetype row (%zu bytes) larger than a chunk\n", rowSize);
+	}
+
+	size_t offset = AlignUp(sizeof(Entity) * capacity, 16);
+	for (size_t i = 0; i < typeIDs.size(); i++) {
+		const ComponentInfo& info = GetComponentInfo(typeIDs[i]);
+		offset = AlignUp(offset, info.align);
+		offsets[typeIDs[i]] = offset;
+		offset += info.size * capacity;
+	}
+	chunkBytes = offset > Chunk::CHUNK_SIZE ? offset : Chunk::CHUNK_SIZE;
+}
+
+void Archetype::allocateRow(Entity entity, Chunk*& chunk, GLuint& row) {
+	// Rows are kept packed, so only the last chunk can have free rows
+	if (chunks.empty() || chunks.back()->count == capacity) {
+		Chunk* newChunk = new Chunk();
+		newChunk->data = (unsigned char*)::operator new(chunkBytes);
+		newChunk->count = 0;
+		chunks.push_back(newChunk);
+	}
+	chunk = chunks.back();
+	row = chunk->count++;
+	getEntities(chunk)[row] = entity;
+}
+
+bool Archetype::removeRow(Chunk* chunk, GLuint row, bool destroyComponents, Entity& movedEntity) {
+	// The hole is filled with the very last row of the archetype, which keeps every chunk but the last one full
+	Chunk* lastChunk = chunks.back();
+	GLuint lastRow = lastChunk->count - 1;
+	bool moved = chunk != lastChunk || row != lastRow;
+
+	for (size_t i = 0; i < typeIDs.size(); i++) {
+		const ComponentInfo& info = GetComponentInfo(typeIDs[i]);
+		void* component = getComponent(chunk, row, typeIDs[i]);
+		if (destroyComponents) {
+			info.destroy(component);
+		}
+		if (moved) {
+			info.moveConstruct(component, getComponent(lastChunk, lastRow, typeIDs[i]));
+		}
+	}
+
+	if (moved) {
+		movedEntity = getEntities(lastChunk)[lastRow];
+		getEntities(chunk)[row] = movedEntity;
+	}
+	lastChunk->count--;
+
+	if (lastChunk->count == 0) {
+		::operator delete(lastChunk->data);
+		delete lastChunk;
+		chunks.pop_back();
+	}
+	return moved;
+}
+
+Archetype::~Archetype() {
+	for (size_t c = 0; c < chunks.size(); c++) {
+		for (GLuint row = 0; row < chunks[c]->count; row++) {
+			for (size_t i = 0; i < typeIDs.size(); i++) {
+				GetComponentInfo(typeIDs[i]).destroy(getComponent(chunks[c], row, typeIDs[i]));
+			}
+		}
+		::operator delete(chunks[c]->data);
+		delete chunks[c];
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <GL\glew.h>
+
+// Entity handle: slot in the scene's entity table + generation (detects stale handles)
+struct Entity
+{
+	GLuint index;
+	GLuint generation;
+};
+
+// How to move/destroy a component type without knowing it (filled by ComponentTypeID<T>)
+struct ComponentInfo
+{
+	size_t size;
+	size_t align;
+	void (*moveConstruct)(void* dst, void* src); // Placement-moves src into dst and destroys src
+	void (*destroy)(void* component);
+};
+
+typedef unsigned long long ComponentMask; // One bit per component type (64 types max)
+const unsigned int MAX_COMPONENT_TYPES = 64;
+
+// Registry of every component type used by the program
+unsigned int RegisterComponentType(const ComponentInfo& info);
+const ComponentInfo& GetComponentInfo(unsigned int typeID);
+
+template <typename T>
+static void MoveConstructComponent(void* dst, void* src) {
+	new (dst) T(static_cast<T&&>(*static_cast<T*>(src)));
+	static_cast<T*>(src)->~T();
+}
+
+template <typename T>
+static void DestroyComponent(void* component) {
+	static_cast<T*>(component)->~T();
+}
+
+// Unique ID of the component type T (assigned the first time the type is used)
+template <typename T>
+unsigned int ComponentTypeID() {
+	static const unsigned int typeID = RegisterComponentType({ sizeof(T), alignof(T), &MoveConstructComponent<T>, &DestroyComponent<T> });
+	return typeID;
+}
+
+template <typename T>
+ComponentMask ComponentBit() {
+	return (ComponentMask)1 << ComponentTypeID<T>();
+}
+
+/*
+Fixed-size block of memory holding up to 'capacity' entities of one archetype, stored SoA: the entity
+handles first, then one contiguous array per component type. Iterating a component is a linear walk
+*/
+struct Chunk
+{
+	static const size_t CHUNK_SIZE = 16 * 1024;
+
+	unsigned char* data;
+	GLuint count;
+};
+
+// Every entity with exactly the same set of component types lives in the same archetype
+class Archetype
+{
+public:
+	Archetype(ComponentMask componentMask);
+	~Archetype();
+
+	ComponentMask getMask() { return mask; };
+	GLuint getCapacity() { return capacity; };
+	size_t getChunkCount() { return chunks.size(); };
+	Chunk* getChunk(size_t index) { return chunks[index]; };
+	bool hasComponent(unsigned int typeID) { return (mask & ((ComponentMask)1 << typeID)) != 0; };
+
+	Entity* getEntities(Chunk* chunk) { return (Entity*)chunk->data; };
+	// Start of the component array of 'typeID' inside the chunk (the type must belong to the archetype)
+	void* getComponentArray(Chunk* chunk, unsigned int typeID) { return chunk->data + offsets[typeID]; };
+	void* getComponent(Chunk* chunk, GLuint row, unsigned int typeID) {
+		return chunk->data + offsets[typeID] + GetComponentInfo(typeID).size * row;
+	};
+
+	// Reserves a row (components left uninitialized) and returns its location
+	void allocateRow(Entity entity, Chunk*& chunk, GLuint& row);
+	// Removes a row by moving the last row of the archetype into it. Returns true (and the entity) if a row was moved
+	bool removeRow(Chunk* chunk, GLuint row, bool destroyComponents, Entity& movedEntity);
+
+private:
+	ComponentMask mask;
+	std::vector<unsigned int> typeIDs;
+	size_t offsets[MAX_COMPONENT_TYPES]; // Byte offset of each component array inside a chunk
+	GLuint capacity; // Entities per chunk
+	size_t chunkBytes; // CHUNK_SIZE, unless a single row does not fit in it
+	std::vector<Chunk*> chunks;
+};
+
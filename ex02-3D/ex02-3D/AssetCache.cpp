@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "AssetCache.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#endif
+
+AssetCache* AssetCache::mounted = NULL;
+
+AssetCache::AssetCache() {
+	maxBytes = 0;
+	usedBytes = 0;
+	hits = 0;
+	misses = 0;
+	stores = 0;
+	tempCounter = 0;
+	trimming = false;
+}
+
+/********************************
+*	Files
+*********************************/
+struct CacheFile
+{
+	std::string location;
+	long long bytes;
+	long long modified; // Seconds
+	bool temporary;
+};
+
+// Every entry (and temporary file) of the directory
+static void ListCacheFiles(const std::string& directory, std::vector<CacheFile>& files) {
+	files.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE search = FindFirstFileA((directory + "/*").c_str(), &found);
+	if (search == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			continue;
+		}
+		CacheFile file;
+		file.location = directory + "/" + found.cFileName;
+		file.bytes = (long long)found.nFileSizeHigh << 32 | found.nFileSizeLow;
+		// 100 ns intervals since 1601
+		file.modified = (long long)(((unsigned long long)found.ftLastWriteTime.dwHighDateTime << 32 | found.ftLastWriteTime.dwLowDateTime) / 10000000ULL) - 11644473600LL;
+		file.temporary = file.location.size() > 4 && file.location.compare(file.location.size() - 4, 4, ".tmp") == 0;
+		files.push_back(file);
+	} while (FindNextFileA(search, &found));
+	FindClose(search);
+#else
+	DIR* listing = opendir(directory.c_str());
+	if (!listing) {
+		return;
+	}
+	while (struct dirent* found = readdir(listing)) {
+		CacheFile file;
+		file.location = directory + "/" + found->d_name;
+		struct stat status;
+		if (stat(file.location.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) {
+			continue;
+		}
+		file.bytes = (long long)status.st_size;
+		file.modified = (long long)status.st_mtime;
+		file.temporary = file.location.size() > 4 && file.location.compare(file.location.size() - 4, 4, ".tmp") == 0;
+		files.push_back(file);
+	}
+	closedir(listing);
+#endif
+}
+
+static bool FileExists(const char* fileLocation, long long& bytes) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileLocation, GetFileExInfoStandard, &attributes) || (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		return false;
+	}
+	bytes = (long long)attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+	return true;
+#else
+	struct stat status;
+	if (stat(fileLocation, &status) != 0 || !S_ISREG(status.st_mode)) {
+		return false;
+	}
+	bytes = (long long)status.st_size;
+	return true;
+#endif
+}
+
+bool AssetCache::open(const char* directoryLocation, size_t maxBytes) {
+	close();
+#ifdef _WIN32
+	if (!CreateDirectoryA(directoryLocation, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+#else
+	if (mkdir(directoryLocation, 0755) != 0 && errno != EEXIST) {
+#endif
+		printf("Failed to create the asset cache directory '%s'\n", directoryLocation);
+		return false;
+	}
+	directory = directoryLocation;
+	this->maxBytes = maxBytes;
+
+	std::vector<CacheFile> files;
+	ListCacheFiles(directory, files);
+	long long bytes = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		bytes += files[i].bytes;
+	}
+	usedBytes = bytes;
+	trim();
+	return true;
+}
+
+void AssetCache::close() {
+	if (mounted == this) {
+		mounted = NULL;
+	}
+	directory.clear();
+	maxBytes = 0;
+	usedBytes = 0;
+}
+
+std::string AssetCache::getEntryLocation(uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.apak", (unsigned long long)key);
+	return directory + name;
+}
+
+/********************************
+*	Hashing
+*********************************/
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static inline uint64_t RotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const unsigned char* bytes) {
+	uint64_t value;
+	memcpy(&value, bytes, sizeof(value)); // Unaligned
+	return value;
+}
+
+static inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+	return RotateLeft(accumulator + input * PRIME2, 31) * PRIME1;
+}
+
+static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+	return (accumulator ^ Round(0, value)) * PRIME1 + PRIME4;
+}
+
+uint64_t AssetCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	const unsigned char* end = bytes + size;
+	uint64_t hash;
+	if (size >= 32) {
+		// 4 independent lanes of 8 bytes, 32 bytes per iteration
+		uint64_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+		for (; bytes + 32 <= end; bytes += 32) {
+			for (int lane = 0; lane < 4; lane++) {
+				lanes[lane] = Round(lanes[lane], Read64(bytes + lane * 8));
+			}
+		}
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+		for (int lane = 0; lane < 4; lane++) {
+			hash = MergeRound(hash, lanes[lane]);
+		}
+	}
+	else {
+		hash = seed + PRIME5;
+	}
+	hash += (uint64_t)size;
+
+	// The last 0 to 31 bytes
+	for (; bytes + 8 <= end; bytes += 8) {
+		hash = RotateLeft(hash ^ Round(0, Read64(bytes)), 27) * PRIME1 + PRIME4;
+	}
+	if (bytes + 4 <= end) {
+		uint32_t value;
+		memcpy(&value, bytes, sizeof(value));
+		hash = RotateLeft(hash ^ (value * PRIME1), 23) * PRIME2 + PRIME3;
+		bytes += 4;
+	}
+	for (; bytes < end; bytes++) {
+		hash = RotateLeft(hash ^ (*bytes * PRIME5), 11) * PRIME1;
+	}
+
+	// Final mix, every input bit affects every output bit
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+uint64_t AssetCache::hashString(const char* text, uint64_t seed) {
+	return hashBytes(text, strlen(text), seed);
+}
+
+bool AssetCache::hashFile(const char* fileLocation, uint64_t& key) {
+	// Mapped, the hash streams through the pages
+	MappedFile file;
+	if (!file.open(fileLocation, true)) {
+		return false;
+	}
+	key = hashBytes(file.getData(), file.getSize(), key);
+	return true;
+}
+
+/********************************
+*	Entries
+*********************************/
+bool AssetCache::find(uint64_t key, AssetPack& entry) {
+	if (directory.empty()) {
+		return false;
+	}
+	std::string location = getEntryLocation(key);
+	long long bytes;
+	if (!FileExists(location.c_str(), bytes)) {
+		misses++;
+		return false;
+	}
+	if (!entry.open(location.c_str())) {
+		// Damaged (or from an older version of the pack format): processed again and replaced
+		remove(location.c_str());
+		usedBytes -= bytes;
+		misses++;
+		return false;
+	}
+	// Used now: the modification time orders the entries for trim()
+#ifdef _WIN32
+	_utime(location.c_str(), NULL);
+#else
+	utime(location.c_str(), NULL);
+#endif
+	hits++;
+	return true;
+}
+
+bool AssetCache::store(uint64_t key, AssetPackWriter& writer, AssetPack* entry) {
+	if (directory.empty()) {
+		return false;
+	}
+	// Unique per process and per store: concurrent writers of the same key never share a temporary file
+	char suffix[48];
+#ifdef _WIN32
+	snprintf(suffix, sizeof(suffix), ".%lu-%u.tmp", (unsigned long)GetCurrentProcessId(), tempCounter++);
+#else
+	snprintf(suffix, sizeof(suffix), ".%ld-%u.tmp", (long)getpid(), tempCounter++);
+#endif
+	std::string location = getEntryLocation(key);
+	std::string tempLocation = location + suffix;
+	if (!writer.write(tempLocation.c_str())) {
+		remove(tempLocation.c_str());
+		return false;
+	}
+	long long bytes = 0, replacedBytes = 0;
+	FileExists(tempLocation.c_str(), bytes);
+	if ((size_t)bytes > maxBytes) {
+		remove(tempLocation.c_str()); // Would evict everything else
+		return false;
+	}
+	bool replaced = FileExists(location.c_str(), replacedBytes);
+
+	// Atomic: readers see the old entry or the new one, never a partial file
+#ifdef _WIN32
+	bool renamed = MoveFileExA(tempLocation.c_str(), location.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool renamed = rename(tempLocation.c_str(), location.c_str()) == 0;
+#endif
+	if (!renamed) {
+		printf("Failed to store '%s' in the asset cache\n", location.c_str());
+		remove(tempLocation.c_str());
+		return false;
+	}
+	stores++;
+	if ((usedBytes += bytes - (replaced ? replacedBytes : 0)) > (long long)maxBytes) {
+		trim();
+	}
+	return !entry || entry->open(location.c_str());
+}
+
+/********************************
+*	Size cap
+*********************************/
+void AssetCache::trim() {
+	bool expected = false;
+	if (!trimming.compare_exchange_strong(expected, true)) {
+		return; // Another thread is at it
+	}
+	std::vector<CacheFile> files;
+	ListCacheFiles(directory, files);
+	// Oldest first. Temporary files are only deleted once they are clearly abandoned (a store takes milliseconds)
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.modified < b.modified; });
+	long long bytes = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		bytes += files[i].bytes;
+	}
+	long long now = (long long)time(NULL);
+	long long target = (long long)maxBytes / 4 * 3;
+	unsigned int deleted = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		bool abandoned = files[i].temporary && now - files[i].modified > 3600;
+		if ((bytes > target && !files[i].temporary) || abandoned) {
+			// Fails while another process has the entry mapped on Windows, it is then kept for now
+			if (remove(files[i].location.c_str()) == 0) {
+				bytes -= files[i].bytes;
+				deleted++;
+			}
+		}
+	}
+	usedBytes = bytes;
+	if (deleted > 0) {
+		printf("Asset cache: %u least recently used entries deleted, %.1f MB left\n", deleted, bytes / (1024.0 * 1024.0));
+	}
+	trimming = false;
+}
+
+void AssetCache::printSummary() {
+	printf("Asset cache '%s': %u hits, %u misses, %u stored, %.1f of %.0f MB used\n", directory.c_str(), (unsigned int)hits,
+		(unsigned int)misses, (unsigned int)stores, usedBytes / (1024.0 * 1024.0), maxBytes / (1024.0 * 1024.0));
+}
+
+AssetCache::~AssetCache() {
+	close();
+}
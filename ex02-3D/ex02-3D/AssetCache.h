@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include "AssetPack.h"
+
+/*
+Processed assets kept on the disk between runs (the AssetCache directory by default, --cache <dir> to move it,
+--cache-size <MB> to cap it, --no-cache to skip it):
+
+	uint64_t key = AssetCache::hashString("texture rgba8 mipmaps");
+	if (AssetCache::hashFile("Textures/brick.png", key) && !cache->find(key, entry)) {
+		AssetPackWriter writer; // Processed once...
+		writer.addTexture("Textures/brick.png", false);
+		cache->store(key, writer, &entry); // ...and loaded from the cache like any asset pack
+	}
+
+Every entry is a small asset pack named after its key, the hash of the source bytes and of whatever else changes the
+result (processing parameters, GL renderer). A source that changes gets a new key, old entries are simply never
+asked for again and age out.
+
+No lock anywhere, lookups and stores can run on every worker at once: an entry is written to a temporary file and
+renamed into place, so a reader sees the whole entry or none. Each hit refreshes the modification time of the entry,
+and once the directory grows over its cap the entries used the longest time ago are deleted
+*/
+class AssetCache
+{
+public:
+	AssetCache();
+	~AssetCache();
+
+	// Creates the directory when needed and trims it to 'maxBytes'
+	bool open(const char* directoryLocation, size_t maxBytes);
+	void close();
+
+	// Loaders look processed assets up in the mounted cache (NULL: none, everything is processed at load)
+	static void mount(AssetCache* cache) { mounted = cache; };
+	static AssetCache* getMounted() { return mounted; };
+
+	// Keys: hashes chained through 'seed' (xxHash64 mixing)
+	static uint64_t hashBytes(const void* data, size_t size, uint64_t seed);
+	static uint64_t hashString(const char* text, uint64_t seed = 0);
+	// Hash of the content of a file, chained into 'key'. False (key unchanged) when it cannot be read
+	static bool hashFile(const char* fileLocation, uint64_t& key);
+
+	// Maps the entry of 'key' into 'entry'. False on a miss (or a damaged entry, which is deleted)
+	bool find(uint64_t key, AssetPack& entry);
+	// Writes the assets of 'writer' as the entry of 'key', replacing any entry of that key. When 'entry' is given,
+	// the stored entry is mapped into it
+	bool store(uint64_t key, AssetPackWriter& writer, AssetPack* entry = NULL);
+
+	unsigned int getHits() { return hits; };
+	unsigned int getMisses() { return misses; };
+	unsigned int getStores() { return stores; };
+	long long getUsedBytes() { return usedBytes; };
+	void printSummary();
+
+private:
+	static AssetCache* mounted;
+
+	std::string directory;
+	size_t maxBytes;
+	std::atomic<long long> usedBytes;
+	std::atomic<unsigned int> hits, misses, stores, tempCounter;
+	std::atomic<bool> trimming;
+
+	std::string getEntryLocation(uint64_t key);
+	// Deletes the least recently used entries until the directory is back under 3/4 of its cap (one thread at a time,
+	// the others skip it). Temporary files left by a crash are removed too
+	void trim();
+};
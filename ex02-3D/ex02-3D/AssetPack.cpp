@@ -0,0 +1,460 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "AssetPack.h"
+#include "TextureArray.h"
+#include "FrameArena.h"
+#include "stb_image.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char PACK_MAGIC[4] = { 'A', 'P', 'A', 'K' };
+
+AssetPack* AssetPack::mounted = NULL;
+
+AssetPack::AssetPack() {
+	data = NULL;
+	fileSize = 0;
+	entries = NULL;
+	assetCount = 0;
+}
+
+/********************************
+*	Mapping
+*********************************/
+bool AssetPack::open(const char* fileLocation) {
+	close();
+	// Everything is uploaded during startup: read ahead
+	if (!file.open(fileLocation, true)) {
+		return false;
+	}
+	data = file.getData();
+	fileSize = file.getSize();
+
+	// Only the table of contents is checked, the data is not read until a loader uses it
+	const AssetPackHeader* header = (const AssetPackHeader*)data;
+	if (fileSize < sizeof(AssetPackHeader) || memcmp(header->magic, PACK_MAGIC, 4) != 0) {
+		printf("'%s' is not an asset pack\n", fileLocation);
+		close();
+		return false;
+	}
+	if (header->version != VERSION) {
+		printf("Asset pack '%s' has version %u, expected %u (rebuild it with --build-pack)\n", fileLocation, header->version, VERSION);
+		close();
+		return false;
+	}
+	if (header->fileSize != fileSize || header->tocOffset > fileSize ||
+		(fileSize - header->tocOffset) / sizeof(AssetPackEntry) < header->assetCount) {
+		printf("Asset pack '%s' is truncated\n", fileLocation);
+		close();
+		return false;
+	}
+	entries = (const AssetPackEntry*)(data + header->tocOffset);
+	assetCount = header->assetCount;
+	for (uint32_t i = 0; i < assetCount; i++) {
+		if (entries[i].offset > fileSize || entries[i].size > fileSize - entries[i].offset || entries[i].name[sizeof(entries[i].name) - 1] != '\0') {
+			printf("Asset pack '%s': entry %u is corrupted\n", fileLocation, i);
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void AssetPack::close() {
+	if (mounted == this) {
+		mounted = NULL;
+	}
+	file.close();
+	data = NULL;
+	fileSize = 0;
+	entries = NULL;
+	assetCount = 0;
+}
+
+bool AssetPack::evictFromCache(const char* fileLocation) {
+#ifdef _WIN32
+	// Opening a file without buffering makes the cache manager drop its cached pages
+	HANDLE file = CreateFileA(fileLocation, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	CloseHandle(file);
+	return true;
+#else
+	int file = ::open(fileLocation, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(file);
+	return evicted;
+#endif
+}
+
+/********************************
+*	Lookup
+*********************************/
+const AssetPackEntry* AssetPack::findAsset(const char* name, AssetType type) const {
+	// The table of contents is sorted by name
+	uint32_t low = 0, high = assetCount;
+	while (low < high) {
+		uint32_t middle = (low + high) / 2;
+		int order = strcmp(entries[middle].name, name);
+		if (order == 0) {
+			return entries[middle].type == (uint32_t)type ? &entries[middle] : NULL;
+		}
+		if (order < 0) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return NULL;
+}
+
+bool AssetPack::getMesh(const char* name, MeshData& mesh) const {
+	const AssetPackEntry* entry = findAsset(name, ASSET_MESH);
+	if (!entry) {
+		return false;
+	}
+	// Vertices, then the indices on the next 16-byte boundary. Read-only pages: the pointers are only read from
+	size_t vertexBytes = (entry->width * sizeof(GLfloat) + 15) & ~(size_t)15;
+	mesh.vertices = (GLfloat*)(data + entry->offset);
+	mesh.indices = (unsigned int*)(data + entry->offset + vertexBytes);
+	mesh.vertexCount = entry->width;
+	mesh.indexCount = entry->height;
+	return true;
+}
+
+const char* AssetPack::getShaderSource(const char* name) const {
+	const AssetPackEntry* entry = findAsset(name, ASSET_SHADER);
+	return entry && entry->size > 0 ? (const char*)(data + entry->offset) : NULL;
+}
+
+const void* AssetPack::getProgramBinary(const char* name, GLenum& binaryFormat, GLsizei& binarySize) const {
+	const AssetPackEntry* entry = findAsset(name, ASSET_PROGRAM);
+	if (!entry || entry->size == 0) {
+		return NULL;
+	}
+	binaryFormat = (GLenum)entry->format;
+	binarySize = (GLsizei)entry->size;
+	return data + entry->offset;
+}
+
+const void* AssetPack::getTextureLevel(const AssetPackEntry* entry, unsigned int level, GLsizei& levelSize, GLsizei& levelWidth, GLsizei& levelHeight) const {
+	if (level >= entry->mipCount) {
+		return NULL;
+	}
+	size_t offset = 0;
+	GLsizei w = (GLsizei)entry->width, h = (GLsizei)entry->height;
+	for (unsigned int i = 0; i < level; i++) {
+		offset += getLevelSize(entry->format, w, h) * entry->layers;
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
+	levelSize = (GLsizei)(getLevelSize(entry->format, w, h) * entry->layers);
+	levelWidth = w;
+	levelHeight = h;
+	return offset + levelSize <= entry->size ? data + entry->offset + offset : NULL;
+}
+
+bool AssetPack::isTextureSupported(const AssetPackEntry* entry) {
+	return entry->format == ASSET_TEXTURE_RGBA8 || (entry->format == ASSET_TEXTURE_BC1 && GLEW_EXT_texture_compression_s3tc);
+}
+
+GLenum AssetPack::getInternalFormat(const AssetPackEntry* entry) {
+	return entry->format == ASSET_TEXTURE_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
+}
+
+size_t AssetPack::getLevelSize(uint32_t format, GLsizei width, GLsizei height) {
+	if (format == ASSET_TEXTURE_BC1) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+	}
+	return (size_t)width * height * 4;
+}
+
+AssetPack::~AssetPack() {
+	close();
+}
+
+/********************************
+*	Writer
+*********************************/
+AssetPackWriter::AssetPackWriter() {
+}
+
+AssetPackWriter::PendingAsset& AssetPackWriter::addAsset(const char* name, AssetType type) {
+	assets.push_back(PendingAsset());
+	PendingAsset& asset = assets.back();
+	memset(&asset.entry, 0, sizeof(asset.entry));
+	if (strlen(name) >= sizeof(asset.entry.name)) {
+		printf("Asset name '%s' is too long for the pack, truncated\n", name);
+	}
+	strncpy(asset.entry.name, name, sizeof(asset.entry.name) - 1);
+	asset.entry.type = type;
+	return asset;
+}
+
+void AssetPackWriter::addMesh(const char* name, const MeshData& mesh) {
+	PendingAsset& asset = addAsset(name, ASSET_MESH);
+	asset.entry.width = mesh.vertexCount;
+	asset.entry.height = mesh.indexCount;
+	size_t vertexBytes = (mesh.vertexCount * sizeof(GLfloat) + 15) & ~(size_t)15;
+	asset.data.resize(vertexBytes + mesh.indexCount * sizeof(unsigned int), 0);
+	memcpy(asset.data.data(), mesh.vertices, mesh.vertexCount * sizeof(GLfloat));
+	memcpy(asset.data.data() + vertexBytes, mesh.indices, mesh.indexCount * sizeof(unsigned int));
+}
+
+bool AssetPackWriter::addShader(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "rb");
+	if (!file) {
+		printf("Failed to open shader '%s'\n", fileLocation);
+		return false;
+	}
+	PendingAsset& asset = addAsset(fileLocation, ASSET_SHADER);
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	asset.data.resize((size_t)(size > 0 ? size : 0) + 1, 0); // Null-terminated, glShaderSource reads it in place
+	size_t read = fread(asset.data.data(), 1, asset.data.size() - 1, file);
+	fclose(file);
+	asset.data.resize(read + 1);
+	asset.data[read] = '\0';
+	return true;
+}
+
+void AssetPackWriter::addProgram(const char* name, GLenum binaryFormat, const void* binary, size_t binarySize) {
+	PendingAsset& asset = addAsset(name, ASSET_PROGRAM);
+	asset.entry.format = (uint32_t)binaryFormat;
+	asset.data.assign((const unsigned char*)binary, (const unsigned char*)binary + binarySize);
+}
+
+// Next mip level (RGBA8), each texel the average of the 2x2 texels above it. Odd sizes repeat the last row/column
+static void Downsample(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight) {
+	for (int y = 0; y < dstHeight; y++) {
+		int y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+		for (int x = 0; x < dstWidth; x++) {
+			int x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+			for (int c = 0; c < 4; c++) {
+				int sum = src[(y0 * srcWidth + x0) * 4 + c] + src[(y0 * srcWidth + x1) * 4 + c] +
+					src[(y1 * srcWidth + x0) * 4 + c] + src[(y1 * srcWidth + x1) * 4 + c];
+				dst[(y * dstWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+static uint16_t PackRgb565(const int* color) {
+	return (uint16_t)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void UnpackRgb565(uint16_t packed, int* color) {
+	color[0] = ((packed >> 11) & 31) * 255 / 31;
+	color[1] = ((packed >> 5) & 63) * 255 / 63;
+	color[2] = (packed & 31) * 255 / 31;
+}
+
+// One 4x4 block to BC1: the endpoints are the corners of the color bounding box (inset a little, the extremes are
+// rarely the best fit), every texel takes the closest of the 4 palette colors. Texels outside the image repeat the edge
+static void EncodeBc1Block(const unsigned char* image, int width, int height, int blockX, int blockY, unsigned char* block) {
+	int texels[16][3];
+	int minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		int x = std::min(blockX * 4 + i % 4, width - 1), y = std::min(blockY * 4 + i / 4, height - 1);
+		for (int c = 0; c < 3; c++) {
+			texels[i][c] = image[(y * width + x) * 4 + c];
+			minColor[c] = std::min(minColor[c], texels[i][c]);
+			maxColor[c] = std::max(maxColor[c], texels[i][c]);
+		}
+	}
+	for (int c = 0; c < 3; c++) {
+		int inset = (maxColor[c] - minColor[c]) / 16;
+		minColor[c] += inset;
+		maxColor[c] -= inset;
+	}
+
+	uint16_t color0 = PackRgb565(maxColor), color1 = PackRgb565(minColor);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		// color0 > color1 selects the 4 color mode: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+		int palette[4][3];
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestDistance = INT32_MAX;
+			for (int p = 0; p < 4; p++) {
+				int dr = texels[i][0] - palette[p][0], dg = texels[i][1] - palette[p][1], db = texels[i][2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (uint32_t)best << (i * 2);
+		}
+	}
+	block[0] = (unsigned char)(color0 & 0xFF);
+	block[1] = (unsigned char)(color0 >> 8);
+	block[2] = (unsigned char)(color1 & 0xFF);
+	block[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; i++) {
+		block[4 + i] = (unsigned char)(indices >> (i * 8));
+	}
+}
+
+bool AssetPackWriter::addTextureLevels(const char* name, std::vector<unsigned char*>& images, int width, int height, bool compress) {
+	PendingAsset& asset = addAsset(name, ASSET_TEXTURE);
+	asset.entry.format = compress ? ASSET_TEXTURE_BC1 : ASSET_TEXTURE_RGBA8;
+	asset.entry.width = (uint32_t)width;
+	asset.entry.height = (uint32_t)height;
+	asset.entry.layers = (uint32_t)images.size();
+
+	// Same chain as glGenerateMipmap, down to 1x1. Each level holds every layer, the way glTexImage3D takes it
+	std::vector<std::vector<unsigned char>> levels(images.size());
+	for (size_t layer = 0; layer < images.size(); layer++) {
+		levels[layer].assign(images[layer], images[layer] + (size_t)width * height * 4);
+		stbi_image_free(images[layer]);
+	}
+	std::vector<unsigned char> next;
+	int levelWidth = width, levelHeight = height;
+	while (true) {
+		size_t layerSize = AssetPack::getLevelSize(asset.entry.format, levelWidth, levelHeight);
+		for (size_t layer = 0; layer < levels.size(); layer++) {
+			size_t offset = asset.data.size();
+			asset.data.resize(offset + layerSize);
+			if (compress) {
+				for (int blockY = 0; blockY < (levelHeight + 3) / 4; blockY++) {
+					for (int blockX = 0; blockX < (levelWidth + 3) / 4; blockX++) {
+						EncodeBc1Block(levels[layer].data(), levelWidth, levelHeight, blockX, blockY,
+							&asset.data[offset + ((size_t)blockY * ((levelWidth + 3) / 4) + blockX) * 8]);
+					}
+				}
+			}
+			else {
+				memcpy(&asset.data[offset], levels[layer].data(), layerSize);
+			}
+		}
+		asset.entry.mipCount++;
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+		int nextWidth = std::max(levelWidth / 2, 1), nextHeight = std::max(levelHeight / 2, 1);
+		for (size_t layer = 0; layer < levels.size(); layer++) {
+			next.resize((size_t)nextWidth * nextHeight * 4);
+			Downsample(levels[layer].data(), levelWidth, levelHeight, next.data(), nextWidth, nextHeight);
+			levels[layer].swap(next);
+		}
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+	return true;
+}
+
+bool AssetPackWriter::addTexture(const char* fileLocation, bool compress) {
+	int width, height, bitDepth;
+	// 4 channels: the pack only has RGBA8 (or BC1 made from it)
+	std::vector<unsigned char*> images(1, stbi_load(fileLocation, &width, &height, &bitDepth, 4));
+	if (!images[0]) {
+		printf("Failed to load image: '%s'\n", fileLocation);
+		return false;
+	}
+	return addTextureLevels(fileLocation, images, width, height, compress);
+}
+
+bool AssetPackWriter::addTextureArray(const char* name, const std::vector<const char*>& layerLocations, bool compress) {
+	std::vector<unsigned char*> images(layerLocations.size(), NULL);
+	int width = 0, height = 0;
+	bool success = !layerLocations.empty();
+	for (size_t layer = 0; layer < layerLocations.size() && success; layer++) {
+		int layerWidth, layerHeight, bitDepth;
+		images[layer] = stbi_load(layerLocations[layer], &layerWidth, &layerHeight, &bitDepth, 4);
+		if (!images[layer]) {
+			printf("Failed to load image: '%s'\n", layerLocations[layer]);
+			success = false;
+		}
+		else if (layer == 0) {
+			width = layerWidth;
+			height = layerHeight;
+		}
+		else if (layerWidth != width || layerHeight != height) {
+			unsigned char* resized = (unsigned char*)FrameArena::scratchMalloc((size_t)width * height * 4);
+			TextureArray::resizeLayer(images[layer], layerWidth, layerHeight, resized, width, height);
+			stbi_image_free(images[layer]);
+			images[layer] = resized;
+		}
+	}
+	if (!success) {
+		for (size_t layer = 0; layer < images.size(); layer++) {
+			stbi_image_free(images[layer]);
+		}
+		return false;
+	}
+	return addTextureLevels(name, images, width, height, compress);
+}
+
+bool AssetPackWriter::write(const char* fileLocation) {
+	// Sorted by name: the reader looks assets up with a binary search
+	std::sort(assets.begin(), assets.end(), [](const PendingAsset& a, const PendingAsset& b) {
+		return strcmp(a.entry.name, b.entry.name) < 0;
+	});
+	for (size_t i = 1; i < assets.size(); i++) {
+		if (strcmp(assets[i - 1].entry.name, assets[i].entry.name) == 0) {
+			printf("Asset '%s' was added twice\n", assets[i].entry.name);
+			return false;
+		}
+	}
+
+	// Table of contents right after the header, then every asset on its own page
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PACK_MAGIC, 4);
+	header.version = AssetPack::VERSION;
+	header.assetCount = (uint32_t)assets.size();
+	header.tocOffset = sizeof(AssetPackHeader);
+	uint64_t offset = header.tocOffset + assets.size() * sizeof(AssetPackEntry);
+	for (size_t i = 0; i < assets.size(); i++) {
+		offset = (offset + AssetPack::ALIGNMENT - 1) & ~(uint64_t)(AssetPack::ALIGNMENT - 1);
+		assets[i].entry.offset = offset;
+		assets[i].entry.size = assets[i].data.size();
+		offset += assets[i].data.size();
+	}
+	header.fileSize = offset;
+
+	FILE* file = fopen(fileLocation, "wb");
+	if (!file) {
+		printf("Failed to create asset pack '%s'\n", fileLocation);
+		return false;
+	}
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (size_t i = 0; i < assets.size() && success; i++) {
+		success = fwrite(&assets[i].entry, sizeof(AssetPackEntry), 1, file) == 1;
+	}
+	static const unsigned char padding[AssetPack::ALIGNMENT] = {};
+	for (size_t i = 0; i < assets.size() && success; i++) {
+		long position = ftell(file);
+		size_t paddingSize = (size_t)(assets[i].entry.offset - (uint64_t)position);
+		success = (paddingSize == 0 || fwrite(padding, paddingSize, 1, file) == 1) &&
+			(assets[i].data.empty() || fwrite(assets[i].data.data(), assets[i].data.size(), 1, file) == 1);
+	}
+	success = fclose(file) == 0 && success;
+	if (!success) {
+		printf("Failed to write asset pack '%s'\n", fileLocation);
+	}
+	return success;
+}
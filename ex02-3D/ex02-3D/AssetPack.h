@@ -0,0 +1,144 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+
+#include "Mesh.h"
+#include "MappedFile.h"
+
+/*
+Every asset of the scene in one file, stored the way the GPU takes it (--build-pack <file> writes it, --pack <file>
+loads from it):
+
+	header | table of contents (sorted by name) | data of each asset, page aligned
+
+The file is memory-mapped, nothing is read or copied up front: loaders hand the mapped pointers straight to
+glBufferData / glTexImage2D / glShaderSource and the pages are only read when the driver touches them.
+- Meshes: interleaved vertices (x, y, z, u, v, nx, ny, nz, normals already computed), then the indices
+- Textures: RGBA8 or BC1 (--compress), every mip level, largest first. A texture array is one entry whose levels
+  hold every layer, fitted to the size of the first one (see TextureArray::getPackName)
+- Shaders: the GLSL source, null-terminated
+- Programs: a linked program as glGetProgramBinary returned it (only in the AssetCache, the binary is only valid
+  for the driver that made it)
+
+Assets are found by the path they were packed from ("Textures/brick.png"), so the loaders only have to ask the
+mounted pack before opening the file themselves
+*/
+
+enum AssetType
+{
+	ASSET_MESH = 1,
+	ASSET_TEXTURE,
+	ASSET_SHADER,
+	ASSET_PROGRAM
+};
+
+enum AssetTextureFormat
+{
+	ASSET_TEXTURE_RGBA8 = 1,
+	ASSET_TEXTURE_BC1 // DXT1, 8 bytes per 4x4 block, no alpha. Needs EXT_texture_compression_s3tc
+};
+
+// On disk, little endian. Layouts are fixed: any change bumps AssetPack::VERSION
+struct AssetPackHeader
+{
+	char magic[4]; // "APAK"
+	uint32_t version;
+	uint32_t assetCount;
+	uint32_t reserved;
+	uint64_t tocOffset; // AssetPackEntry[assetCount]
+	uint64_t fileSize;
+};
+
+struct AssetPackEntry
+{
+	char name[64];
+	uint32_t type; // AssetType
+	uint32_t format; // AssetTextureFormat (textures), binary format (programs)
+	uint32_t width; // Textures. Meshes: vertex count in floats (as Mesh::CreateMesh takes it)
+	uint32_t height; // Textures. Meshes: index count
+	uint32_t mipCount; // Textures
+	uint32_t layers; // Textures: 1, or the layer count of a texture array
+	uint64_t offset; // From the start of the file, multiple of AssetPack::ALIGNMENT
+	uint64_t size;
+};
+
+class AssetPack
+{
+public:
+	static const uint32_t VERSION = 1;
+	static const size_t ALIGNMENT = 4096; // Every asset starts on its own page
+
+	AssetPack();
+	~AssetPack();
+
+	bool open(const char* fileLocation); // Maps the file and checks its table of contents
+	void close(); // Unmaps it (also done by the destructor). Nothing uploaded from it may still be pending
+
+	// Loaders look assets up in the mounted pack (NULL: none, everything comes from the loose files)
+	static void mount(AssetPack* pack) { mounted = pack; };
+	static AssetPack* getMounted() { return mounted; };
+
+	// NULL when the pack has no asset of that name and type
+	const AssetPackEntry* findAsset(const char* name, AssetType type) const;
+
+	// Typed access to the mapped data. False / NULL when missing
+	bool getMesh(const char* name, MeshData& mesh) const;
+	const char* getShaderSource(const char* name) const;
+	const void* getProgramBinary(const char* name, GLenum& binaryFormat, GLsizei& binarySize) const;
+	// Level 'level' of a texture entry (every layer of it) and its size (bytes of all the layers, texels)
+	const void* getTextureLevel(const AssetPackEntry* entry, unsigned int level, GLsizei& levelSize, GLsizei& levelWidth, GLsizei& levelHeight) const;
+
+	// Whether this GL context can sample the texture format (BC1 needs S3TC)
+	static bool isTextureSupported(const AssetPackEntry* entry);
+	static GLenum getInternalFormat(const AssetPackEntry* entry);
+	static size_t getLevelSize(uint32_t format, GLsizei width, GLsizei height);
+
+	// Drops the file from the OS file cache, so the next read comes from the disk (cold start measurements)
+	static bool evictFromCache(const char* fileLocation);
+
+	size_t getFileSize() { return fileSize; };
+	uint32_t getAssetCount() { return assetCount; };
+
+private:
+	static AssetPack* mounted;
+
+	MappedFile file;
+	const unsigned char* data;
+	size_t fileSize;
+	const AssetPackEntry* entries;
+	uint32_t assetCount;
+};
+
+// Builds a pack in memory and writes it (the packer side, CPU only)
+class AssetPackWriter
+{
+public:
+	AssetPackWriter();
+
+	void addMesh(const char* name, const MeshData& mesh);
+	// Decodes the image, builds its mip chain and (if 'compress') encodes every level to BC1
+	bool addTexture(const char* fileLocation, bool compress);
+	// Same for the layers of a texture array, resized to the first one like TextureArray::loadTextures does
+	bool addTextureArray(const char* name, const std::vector<const char*>& layerLocations, bool compress);
+	bool addShader(const char* fileLocation);
+	void addProgram(const char* name, GLenum binaryFormat, const void* binary, size_t binarySize);
+	bool write(const char* fileLocation);
+
+	size_t getAssetCount() { return assets.size(); };
+
+private:
+	struct PendingAsset
+	{
+		AssetPackEntry entry;
+		std::vector<unsigned char> data;
+	};
+
+	std::vector<PendingAsset> assets;
+
+	PendingAsset& addAsset(const char* name, AssetType type);
+	// RGBA8 images of width x height from stbi_load (freed here), one per layer
+	bool addTextureLevels(const char* name, std::vector<unsigned char*>& images, int width, int height, bool compress);
+};
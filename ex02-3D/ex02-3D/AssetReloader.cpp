@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <algorithm>
+#include "AssetReloader.h"
+#include "FrameArena.h"
+#include "RedrawTracker.h"
+#include "stb_image.h"
+
+AssetReloader::AssetReloader() {
+	reloadCount = 0;
+	scratchUsed = false;
+}
+
+/********************************
+*	Watches
+*********************************/
+bool AssetReloader::addTarget(Target& target) {
+	int fileCount = target.type == TARGET_SHADER ? 2 : 1;
+	for (int i = 0; i < fileCount; i++) {
+		target.watchedFiles.push_back(target.fileLocations[i]);
+		// The includes too, as the loose files are now (up to the broken one when it does not expand)
+		std::string expanded;
+		std::vector<std::string> dependencies;
+		if (target.type == TARGET_SHADER || target.type == TARGET_COMPUTE_SHADER) {
+			ShaderPreprocessor::expandFile(target.fileLocations[i], target.shader->getVariantDefines().c_str(), expanded, &dependencies, false);
+		}
+		if (dependencies.size() > 1) {
+			target.watchedFiles.insert(target.watchedFiles.end(), dependencies.begin() + 1, dependencies.end());
+		}
+	}
+	for (size_t i = 0; i < target.watchedFiles.size(); i++) {
+		if (!watcher.watchFile(target.watchedFiles[i].c_str())) {
+			return false;
+		}
+	}
+	targets.push_back(target);
+	return true;
+}
+
+void AssetReloader::watchFiles(Target& target, const std::vector<std::string>& fileLocations) {
+	for (size_t i = 0; i < fileLocations.size(); i++) {
+		if (std::find(target.watchedFiles.begin(), target.watchedFiles.end(), fileLocations[i]) == target.watchedFiles.end()) {
+			target.watchedFiles.push_back(fileLocations[i]);
+			watcher.watchFile(fileLocations[i].c_str());
+		}
+	}
+}
+
+bool AssetReloader::watchShader(Shader* target, const char* vertexLocation, const char* fragmentLocation, std::function<void()> swapped) {
+	Target watched = { TARGET_SHADER, target, NULL, NULL, 0, { vertexLocation, fragmentLocation }, {}, swapped, 0 };
+	return addTarget(watched);
+}
+
+bool AssetReloader::watchComputeShader(Shader* target, const char* computeLocation, std::function<void()> swapped) {
+	Target watched = { TARGET_COMPUTE_SHADER, target, NULL, NULL, 0, { computeLocation, NULL }, {}, swapped, 0 };
+	return addTarget(watched);
+}
+
+bool AssetReloader::watchTexture(Texture* target, const char* fileLocation) {
+	Target watched = { TARGET_TEXTURE, NULL, target, NULL, 0, { fileLocation, NULL }, {}, nullptr, 0 };
+	return addTarget(watched);
+}
+
+bool AssetReloader::watchTextureLayer(TextureArray* target, GLint layer, const char* fileLocation) {
+	Target watched = { TARGET_TEXTURE_LAYER, NULL, NULL, target, layer, { fileLocation, NULL }, {}, nullptr, 0 };
+	return addTarget(watched);
+}
+
+/********************************
+*	Reloads
+*********************************/
+void AssetReloader::update() {
+	changedFiles.clear();
+	watcher.pollChanges(changedFiles);
+	for (size_t t = 0; t < targets.size() && !changedFiles.empty(); t++) {
+		// Several files of a target written at once (both shaders, a shader and its include): one reload
+		const std::vector<std::string>& watchedFiles = targets[t].watchedFiles;
+		bool changed = false;
+		for (size_t i = 0; i < changedFiles.size(); i++) {
+			changed = changed || std::find(watchedFiles.begin(), watchedFiles.end(), changedFiles[i]) != watchedFiles.end();
+		}
+		if (changed) {
+			startReload(t);
+		}
+	}
+
+	// In start order, so two reloads of one target finish oldest first
+	size_t kept = 0;
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (advanceReload(pending[i])) {
+			delete pending[i];
+		}
+		else {
+			pending[kept++] = pending[i];
+		}
+	}
+	pending.resize(kept);
+
+	// The decoded images are on the GPU and no decode job is running: the scratch memory can go
+	bool decoding = false;
+	for (size_t i = 0; i < pending.size(); i++) {
+		decoding = decoding || pending[i]->stage == STAGE_READING;
+	}
+	if (scratchUsed && !decoding) {
+		FrameArena::releaseScratch();
+		scratchUsed = false;
+	}
+}
+
+void AssetReloader::startReload(size_t targetIndex) {
+	Target& target = targets[targetIndex];
+	Reload* reload = new Reload();
+	reload->target = targetIndex;
+	reload->generation = ++target.generation;
+	reload->stage = STAGE_READING;
+	reload->changed = std::chrono::high_resolution_clock::now();
+	reload->frames = 0;
+	reload->readSucceeded = false;
+	pending.push_back(reload);
+
+	// Reading and decoding on a worker, nothing here touches GL
+	switch (target.type) {
+	case TARGET_SHADER:
+	case TARGET_COMPUTE_SHADER:
+	{
+		const char* fileLocations[2] = { target.fileLocations[0], target.fileLocations[1] };
+		std::string variantDefines = target.shader->getVariantDefines();
+		JobSystem::Run("Reload shader", [reload, fileLocations, variantDefines]() {
+			reload->readSucceeded = true;
+			for (int i = 0; i < 2 && fileLocations[i]; i++) {
+				// The files that changed, not the pack. Unchanged stages come from the preprocessor's cache
+				reload->readSucceeded = ShaderPreprocessor::expandFile(fileLocations[i], variantDefines.c_str(), reload->sources[i],
+					&reload->dependencies[i], false) && reload->readSucceeded;
+			}
+		}, &reload->counter);
+		break;
+	}
+	case TARGET_TEXTURE:
+		reload->texture = Texture((char*)target.fileLocations[0]);
+		scratchUsed = true;
+		JobSystem::Run("Reload texture", [reload]() {
+			reload->readSucceeded = reload->texture.decodeTexture(false); // The file that changed, not the pack
+		}, &reload->counter);
+		break;
+	case TARGET_TEXTURE_LAYER:
+	{
+		scratchUsed = true;
+		// Fitted to the array like TextureArray::loadTextures does
+		const char* fileLocation = target.fileLocations[0];
+		int arrayWidth = target.textureArray->getWidth(), arrayHeight = target.textureArray->getHeight();
+		JobSystem::Run("Reload texture layer", [reload, fileLocation, arrayWidth, arrayHeight]() {
+			int width, height, bitDepth;
+			unsigned char* image = stbi_load(fileLocation, &width, &height, &bitDepth, 4);
+			if (!image) {
+				printf("Failed to load image: '%s'\n", fileLocation);
+				return;
+			}
+			reload->layerPixels.resize((size_t)arrayWidth * arrayHeight * 4);
+			TextureArray::resizeLayer(image, width, height, reload->layerPixels.data(), arrayWidth, arrayHeight);
+			stbi_image_free(image);
+			reload->readSucceeded = true;
+		}, &reload->counter);
+		break;
+	}
+	}
+}
+
+bool AssetReloader::advanceReload(Reload* reload) {
+	Target& target = targets[reload->target];
+	reload->frames++;
+	if (!reload->counter.isDone()) {
+		return false; // Still reading / decoding
+	}
+	if (reload->generation != target.generation) {
+		return true; // The file changed again since, the newer reload will swap
+	}
+	if (reload->stage == STAGE_READING) {
+		// Includes added since the last build are watched as well (also when this one does not compile)
+		watchFiles(target, reload->dependencies[0]);
+		watchFiles(target, reload->dependencies[1]);
+	}
+	if (!reload->readSucceeded) {
+		finishReload(reload, false);
+		return true;
+	}
+
+	switch (target.type) {
+	case TARGET_SHADER:
+	case TARGET_COMPUTE_SHADER:
+		if (reload->stage == STAGE_READING) {
+			// Not through the program binary cache: its lookups and stores are file work the frame would wait for
+			bool started = target.type == TARGET_SHADER ?
+				reload->shader.startCreate(reload->sources[0].c_str(), reload->sources[1].c_str(), target.fileLocations[0], false) :
+				reload->shader.startCreateCompute(reload->sources[0].c_str(), target.fileLocations[0], false);
+			if (!started) {
+				finishReload(reload, false);
+				return true;
+			}
+			reload->stage = STAGE_LINKING;
+		}
+		if (!reload->shader.isBuildComplete()) {
+			return false; // Compiling on the driver's threads
+		}
+		if (!reload->shader.finishCreate()) {
+			if (target.type == TARGET_SHADER) {
+				printf("Vertex shader sources: %s\nFragment shader sources: %s\n", ShaderPreprocessor::describeSources(reload->dependencies[0]).c_str(),
+					ShaderPreprocessor::describeSources(reload->dependencies[1]).c_str());
+			}
+			else {
+				printf("Compute shader sources: %s\n", ShaderPreprocessor::describeSources(reload->dependencies[0]).c_str());
+			}
+			finishReload(reload, false);
+			return true;
+		}
+		target.shader->adoptProgram(reload->shader);
+		if (target.swapped) {
+			target.swapped();
+		}
+		break;
+	case TARGET_TEXTURE:
+		reload->texture.uploadTexture();
+		target.texture->adoptTexture(reload->texture);
+		break;
+	case TARGET_TEXTURE_LAYER:
+		if (!target.textureArray->replaceLayer(target.layer, reload->layerPixels.data())) {
+			printf("Hot reload: '%s' is in a compressed texture array, rebuild the asset pack instead\n", target.fileLocations[0]);
+			finishReload(reload, false);
+			return true;
+		}
+		break;
+	}
+	finishReload(reload, true);
+	return true;
+}
+
+void AssetReloader::finishReload(Reload* reload, bool succeeded) {
+	const Target& target = targets[reload->target];
+	char name[160];
+	snprintf(name, sizeof(name), target.type == TARGET_SHADER ? "'%s' + '%s'" : target.type == TARGET_TEXTURE_LAYER ? "'%s' (array layer)" : "'%s'",
+		target.fileLocations[0], target.fileLocations[1]);
+	double latency = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - reload->changed).count();
+	if (succeeded) {
+		reloadCount++;
+		RedrawTracker::markDirty(); // On-demand rendering: the picture changed
+		printf("Hot reload: %s swapped in %.1f ms after the change (%u frames)\n", name, latency, reload->frames);
+	}
+	else {
+		printf("Hot reload: %s failed after %.1f ms, the previous version stays\n", name, latency);
+	}
+}
+
+void AssetReloader::clearReloader() {
+	for (size_t i = 0; i < pending.size(); i++) {
+		JobSystem::Wait(&pending[i]->counter);
+		delete pending[i];
+	}
+	pending.clear();
+	if (scratchUsed) {
+		FrameArena::releaseScratch();
+		scratchUsed = false;
+	}
+	watcher.clearWatcher();
+	targets.clear();
+}
+
+AssetReloader::~AssetReloader() {
+	clearReloader();
+}
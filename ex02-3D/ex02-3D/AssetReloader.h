@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+
+#include "FileWatcher.h"
+#include "JobSystem.h"
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+#include "Texture.h"
+#include "TextureArray.h"
+
+/*
+Hot reload (--hot-reload): the shader and texture files of the scene are watched, and a file that is written again
+is reloaded into the object that was made from it, while the application keeps running.
+
+	reloader.watchShader(&shaderList[0], vertexLocation, fragmentLocation);
+	reloader.watchTexture(&brickTexture, brickLocation);
+	...
+	reloader.update(); // Once per frame, on the GL thread
+
+A reload never makes a frame wait:
+- Files are read and images decoded on the job system. update() only checks whether the jobs are done
+- Shaders are compiled and linked into a new Shader with the driver's compiler threads (ARB_parallel_shader_compile).
+  The new program replaces the old one in the frame its link completes, so a frame draws with either the whole old
+  program or the whole new one. A shader that does not compile is reported and the old program stays
+- Textures are uploaded to a new texture that then replaces the old one (texture array layers are rewritten in place)
+
+A shader is also reloaded when one of the files it includes changes, and the includes it gains are watched from
+then on. Reloads read the loose files, a mounted asset pack is not updated (rebuild it with --build-pack). The time
+from the change to the swap is printed for every reload
+*/
+class AssetReloader
+{
+public:
+	AssetReloader();
+	~AssetReloader();
+
+	// The file locations are kept, not copied. 'swapped' runs on the GL thread after the new program was swapped in
+	// (for uniforms looked up outside the Shader)
+	bool watchShader(Shader* target, const char* vertexLocation, const char* fragmentLocation, std::function<void()> swapped = nullptr);
+	bool watchComputeShader(Shader* target, const char* computeLocation, std::function<void()> swapped = nullptr);
+	bool watchTexture(Texture* target, const char* fileLocation);
+	bool watchTextureLayer(TextureArray* target, GLint layer, const char* fileLocation);
+
+	// Starts the reloads of the files changed since the last call and swaps in the reloads that are done. GL thread
+	void update();
+	// Reloads still running (update() keeps being needed every frame until they are done)
+	bool isBusy() { return !pending.empty(); };
+	void clearReloader(); // Waits for the running jobs and drops every watch
+
+	unsigned int getReloadCount() { return reloadCount; };
+
+private:
+	enum TargetType { TARGET_SHADER, TARGET_COMPUTE_SHADER, TARGET_TEXTURE, TARGET_TEXTURE_LAYER };
+
+	struct Target
+	{
+		TargetType type;
+		Shader* shader;
+		Texture* texture;
+		TextureArray* textureArray;
+		GLint layer;
+		const char* fileLocations[2]; // Vertex and fragment shader, or the only file
+		std::vector<std::string> watchedFiles; // The files above and the ones they include
+		std::function<void()> swapped;
+		unsigned int generation; // Reloads started. A reload that is not the latest one is dropped when done
+	};
+
+	enum ReloadStage { STAGE_READING, STAGE_LINKING };
+
+	struct Reload
+	{
+		size_t target;
+		unsigned int generation;
+		ReloadStage stage;
+		JobCounter counter; // The reading / decoding job
+		std::chrono::high_resolution_clock::time_point changed; // When the change was seen
+		unsigned int frames; // update() calls since then
+		bool readSucceeded;
+		std::string sources[2]; // Preprocessed
+		std::vector<std::string> dependencies[2]; // Of each source, for the watches and the compile errors
+		Shader shader;
+		Texture texture;
+		std::vector<unsigned char> layerPixels; // RGBA8 at the size of the array
+	};
+
+	FileWatcher watcher;
+	std::vector<Target> targets;
+	std::vector<Reload*> pending;
+	std::vector<std::string> changedFiles;
+	unsigned int reloadCount;
+	bool scratchUsed; // Images were decoded through the scratch arena since it was last released
+
+	bool addTarget(Target& target);
+	void watchFiles(Target& target, const std::vector<std::string>& fileLocations);
+	void startReload(size_t targetIndex);
+	// Moves a reload forward. True once it is finished (swapped in, failed or replaced by a newer one)
+	bool advanceReload(Reload* reload);
+	void finishReload(Reload* reload, bool succeeded);
+};
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+#include "BenchmarkRecorder.h"
+
+BenchmarkRecorder::BenchmarkRecorder() {
+	for (unsigned int i = 0; i < QUERY_LATENCY; i++) {
+		queries[i] = 0;
+		queryFrame[i] = 0;
+		queryPending[i] = false;
+	}
+}
+
+/********************************
+*	Recording
+*********************************/
+void BenchmarkRecorder::beginFrame() {
+	if (queries[0] == 0) {
+		glGenQueries(QUERY_LATENCY, queries); // Needs the GL context, so not in the constructor
+	}
+	unsigned int slot = (unsigned int)(frames.size() % QUERY_LATENCY);
+	if (queryPending[slot]) {
+		resolveQuery(slot); // Issued QUERY_LATENCY frames ago, normally done by now
+	}
+	queryFrame[slot] = frames.size();
+	queryPending[slot] = true;
+	glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+	frameStart = std::chrono::high_resolution_clock::now();
+}
+
+void BenchmarkRecorder::endFrame(unsigned int drawCalls, unsigned int triangles) {
+	glEndQuery(GL_TIME_ELAPSED);
+	FrameSample sample;
+	sample.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+	sample.gpuMs = -1.0;
+	sample.drawCalls = drawCalls;
+	sample.triangles = triangles;
+	frames.push_back(sample);
+}
+
+void BenchmarkRecorder::finish() {
+	for (unsigned int slot = 0; slot < QUERY_LATENCY; slot++) {
+		if (queryPending[slot]) {
+			resolveQuery(slot);
+		}
+	}
+}
+
+void BenchmarkRecorder::resolveQuery(unsigned int slot) {
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds); // Waits if the GPU is that far behind
+	if (queryFrame[slot] < frames.size()) {
+		frames[queryFrame[slot]].gpuMs = nanoseconds / 1000000.0;
+	}
+	queryPending[slot] = false;
+}
+
+/********************************
+*	Results
+*********************************/
+// Nearest rank percentile, 'values' gets reordered
+static double Percentile(std::vector<double>& values, double percent) {
+	if (values.empty()) {
+		return -1.0;
+	}
+	size_t rank = (size_t)ceil(percent / 100.0 * values.size());
+	size_t index = rank > 0 ? std::min(rank - 1, values.size() - 1) : 0;
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+BenchmarkRecorder::Summary BenchmarkRecorder::summarize() {
+	Summary summary;
+	std::vector<double> cpu, gpu;
+	double cpuSum = 0.0, gpuSum = 0.0, drawCallSum = 0.0, triangleSum = 0.0;
+	for (size_t i = WARMUP_FRAMES; i < frames.size(); i++) {
+		cpu.push_back(frames[i].cpuMs);
+		cpuSum += frames[i].cpuMs;
+		if (frames[i].gpuMs >= 0.0) {
+			gpu.push_back(frames[i].gpuMs);
+			gpuSum += frames[i].gpuMs;
+		}
+		drawCallSum += frames[i].drawCalls;
+		triangleSum += frames[i].triangles;
+	}
+
+	// Unavailable values are -1
+	summary.cpuMean = cpu.empty() ? -1.0 : cpuSum / cpu.size();
+	summary.cpuP50 = Percentile(cpu, 50.0);
+	summary.cpuP95 = Percentile(cpu, 95.0);
+	summary.cpuP99 = Percentile(cpu, 99.0);
+	summary.cpuMax = Percentile(cpu, 100.0);
+	summary.gpuMean = gpu.empty() ? -1.0 : gpuSum / gpu.size();
+	summary.gpuP50 = Percentile(gpu, 50.0);
+	summary.gpuP95 = Percentile(gpu, 95.0);
+	summary.gpuP99 = Percentile(gpu, 99.0);
+	summary.gpuMax = Percentile(gpu, 100.0);
+	summary.drawCalls = cpu.empty() ? 0.0 : drawCallSum / cpu.size();
+	summary.triangles = cpu.empty() ? 0.0 : triangleSum / cpu.size();
+	return summary;
+}
+
+bool BenchmarkRecorder::writeJson(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write benchmark results to '%s'\n", fileLocation);
+		return false;
+	}
+	Summary s = summarize();
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"frames\": %u,\n\t\"warmup_frames\": %u,\n", getFrameCount(), WARMUP_FRAMES);
+	fprintf(file, "\t\"cpu_mean_ms\": %.4f,\n\t\"cpu_p50_ms\": %.4f,\n\t\"cpu_p95_ms\": %.4f,\n\t\"cpu_p99_ms\": %.4f,\n\t\"cpu_max_ms\": %.4f,\n",
+		s.cpuMean, s.cpuP50, s.cpuP95, s.cpuP99, s.cpuMax);
+	fprintf(file, "\t\"gpu_mean_ms\": %.4f,\n\t\"gpu_p50_ms\": %.4f,\n\t\"gpu_p95_ms\": %.4f,\n\t\"gpu_p99_ms\": %.4f,\n\t\"gpu_max_ms\": %.4f,\n",
+		s.gpuMean, s.gpuP50, s.gpuP95, s.gpuP99, s.gpuMax);
+	fprintf(file, "\t\"draw_calls\": %.2f,\n\t\"triangles\": %.2f\n", s.drawCalls, s.triangles);
+	fprintf(file, "}\n");
+	fclose(file);
+	return true;
+}
+
+bool BenchmarkRecorder::writeCsv(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write benchmark frames to '%s'\n", fileLocation);
+		return false;
+	}
+	fprintf(file, "frame,cpu_ms,gpu_ms,draw_calls,triangles\n");
+	for (size_t i = 0; i < frames.size(); i++) {
+		fprintf(file, "%zu,%.4f,%.4f,%u,%u\n", i, frames[i].cpuMs, frames[i].gpuMs, frames[i].drawCalls, frames[i].triangles);
+	}
+	fclose(file);
+	return true;
+}
+
+// Value of "key": number in a file written by writeJson(). Not a general JSON parser
+static bool FindJsonNumber(const std::string& json, const char* key, double& value) {
+	std::string quoted = std::string("\"") + key + "\"";
+	size_t position = json.find(quoted);
+	if (position == std::string::npos) {
+		return false;
+	}
+	position = json.find(':', position + quoted.size());
+	if (position == std::string::npos) {
+		return false;
+	}
+	char* end;
+	value = strtod(json.c_str() + position + 1, &end);
+	return end != json.c_str() + position + 1;
+}
+
+bool BenchmarkRecorder::compareBaseline(const char* fileLocation, double tolerancePercent) {
+	FILE* file = fopen(fileLocation, "rb");
+	if (!file) {
+		printf("Failed to read baseline '%s'\n", fileLocation);
+		return false;
+	}
+	std::string json;
+	char buffer[1024];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		json.append(buffer, read);
+	}
+	fclose(file);
+
+	Summary s = summarize();
+	struct Check { const char* key; double value; bool exact; };
+	const Check checks[] = {
+		{ "cpu_mean_ms", s.cpuMean, false },
+		{ "cpu_p95_ms", s.cpuP95, false },
+		{ "cpu_p99_ms", s.cpuP99, false },
+		{ "gpu_mean_ms", s.gpuMean, false },
+		{ "gpu_p95_ms", s.gpuP95, false },
+		{ "draw_calls", s.drawCalls, true },
+		{ "triangles", s.triangles, true },
+	};
+
+	bool pass = true;
+	printf("Baseline '%s' (%.1f%% tolerance on times):\n", fileLocation, tolerancePercent);
+	for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+		double expected;
+		if (!FindJsonNumber(json, checks[i].key, expected)) {
+			printf("  %-12s missing from the baseline\n", checks[i].key);
+			pass = false;
+			continue;
+		}
+		if (expected < 0.0 || checks[i].value < 0.0) {
+			printf("  %-12s skipped (not measured)\n", checks[i].key);
+			continue;
+		}
+		bool ok;
+		if (checks[i].exact) {
+			ok = fabs(checks[i].value - expected) < 0.01;
+		}
+		else {
+			// Only slower fails, faster is fine
+			ok = checks[i].value <= expected * (1.0 + tolerancePercent / 100.0);
+		}
+		printf("  %-12s %10.3f, baseline %10.3f  %s\n", checks[i].key, checks[i].value, expected, ok ? "ok" : "FAIL");
+		pass = pass && ok;
+	}
+	printf("Benchmark %s\n", pass ? "PASSED" : "FAILED");
+	return pass;
+}
+
+BenchmarkRecorder::~BenchmarkRecorder() {
+	if (queries[0] != 0) {
+		glDeleteQueries(QUERY_LATENCY, queries);
+	}
+}
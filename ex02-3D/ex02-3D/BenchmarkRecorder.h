@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <GL\glew.h>
+
+/*
+Per-frame measurements of a benchmark run: CPU frame time, GPU time of the frame (GL_TIME_ELAPSED queries),
+draw calls and triangles.
+
+	recorder.beginFrame();
+	... simulate, draw, swap ...
+	recorder.endFrame(RenderStats::getDrawCalls(), RenderStats::getTriangles());
+
+GPU results are read QUERY_LATENCY frames later so the readback never waits for the GPU.
+The first WARMUP_FRAMES (shader compiles, first uploads, first queries) are left out of the summary.
+The summary can be written as JSON, every frame as CSV, and a run can be checked against a stored summary
+*/
+class BenchmarkRecorder
+{
+public:
+	BenchmarkRecorder();
+
+	void beginFrame();
+	void endFrame(unsigned int drawCalls, unsigned int triangles);
+	// Reads the queries still in flight. Call once after the last frame, before writing results
+	void finish();
+
+	unsigned int getFrameCount() { return (unsigned int)frames.size(); };
+
+	// Summary (means and percentiles) as JSON. Returns false when the file cannot be written
+	bool writeJson(const char* fileLocation);
+	// One line per frame
+	bool writeCsv(const char* fileLocation);
+	// Compares this run with a summary written by writeJson(). Times may be up to 'tolerancePercent' % slower,
+	// draw calls and triangles have to match (the run is deterministic). Prints every check, returns true on pass
+	bool compareBaseline(const char* fileLocation, double tolerancePercent);
+
+	~BenchmarkRecorder();
+
+private:
+	static const unsigned int QUERY_LATENCY = 4; // Frames between issuing a query and reading it
+	static const unsigned int WARMUP_FRAMES = 10;
+
+	struct FrameSample
+	{
+		double cpuMs;
+		double gpuMs; // -1 until the query result arrives
+		unsigned int drawCalls;
+		unsigned int triangles;
+	};
+
+	struct Summary
+	{
+		double cpuMean, cpuP50, cpuP95, cpuP99, cpuMax;
+		double gpuMean, gpuP50, gpuP95, gpuP99, gpuMax;
+		double drawCalls, triangles; // Per frame
+	};
+
+	std::vector<FrameSample> frames;
+	std::chrono::high_resolution_clock::time_point frameStart;
+
+	GLuint queries[QUERY_LATENCY];
+	size_t queryFrame[QUERY_LATENCY]; // Frame each query belongs to
+	bool queryPending[QUERY_LATENCY];
+
+	void resolveQuery(unsigned int slot);
+	Summary summarize();
+};
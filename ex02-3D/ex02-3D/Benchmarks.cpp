@@ -0,0 +1,571 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <math.h>
+
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\type_ptr.hpp>
+
+#include "Benchmarks.h"
+#include "CommonValues.h"
+#include "Shader.h"
+#include "Material.h"
+#include "UniformRingBuffer.h"
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include "MeshUtils.h"
+#include "Frustum.h"
+#include "RenderCommandBuffer.h"
+#include "GpuMemoryTracker.h"
+#include "MeshImporter.h"
+#include "MappedFile.h"
+
+static double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+/********************************
+*	Uniform upload benchmark
+*********************************/
+// Per-draw glUniform* calls (the way the main loop used to do it)
+static const char* uniformVertexCode = "\n\
+#version 330\n\
+layout(location=0) in vec3 pos;\n\
+uniform mat4 model;\n\
+uniform mat4 projection;\n\
+void main() { gl_Position = projection * model * vec4(pos, 1.0); }\n";
+
+static const char* uniformFragmentCode = "\n\
+#version 330\n\
+struct Material { float specularIntensity; float shininess; };\n\
+uniform Material material;\n\
+out vec4 color;\n\
+void main() { color = vec4(material.specularIntensity, material.shininess * 0.01, 0.0, 1.0); }\n";
+
+// Same shaders reading the per-object block bound from the ring buffer
+static const char* blockVertexCode = "\n\
+#version 330\n\
+layout(location=0) in vec3 pos;\n\
+struct Material { float specularIntensity; float shininess; };\n\
+layout(std140) uniform ObjectBlock { mat4 model; Material material; };\n\
+uniform mat4 projection;\n\
+void main() { gl_Position = projection * model * vec4(pos, 1.0); }\n";
+
+static const char* blockFragmentCode = "\n\
+#version 330\n\
+struct Material { float specularIntensity; float shininess; };\n\
+layout(std140) uniform ObjectBlock { mat4 model; Material material; };\n\
+out vec4 color;\n\
+void main() { color = vec4(material.specularIntensity, material.shininess * 0.01, 0.0, 1.0); }\n";
+
+int RunUniformBenchmark(Mesh* mesh, int drawCount) {
+	const int frames = 60;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	Material material(1.0f, 32.0f);
+
+	std::vector<glm::mat4> models(drawCount);
+	for (int i = 0; i < drawCount; i++) {
+		models[i] = glm::translate(glm::mat4(1.0f), glm::vec3((i % 100) * 0.1f - 5.0f, (i / 100) * 0.1f - 5.0f, -20.0f));
+	}
+
+	Shader uniformShader, blockShader;
+	uniformShader.CreateFromString(uniformVertexCode, uniformFragmentCode);
+	blockShader.CreateFromString(blockVertexCode, blockFragmentCode);
+
+	UniformRingBuffer ring;
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	GLsizeiptr blockStride = (sizeof(ObjectBlock) + alignment - 1) / alignment * alignment;
+	if (!ring.Initialize(blockStride * drawCount, FRAMES_IN_FLIGHT)) {
+		return 1;
+	}
+
+	// 1) glUniformMatrix4fv + Material::useMaterial per draw
+	double uniformMs = 0.0;
+	for (int frame = 0; frame < frames; frame++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		auto start = std::chrono::high_resolution_clock::now();
+		uniformShader.UseProgram();
+		glUniformMatrix4fv(uniformShader.getUniformProjection(), 1, GL_FALSE, glm::value_ptr(projection));
+		for (int i = 0; i < drawCount; i++) {
+			glUniformMatrix4fv(uniformShader.getUniformModel(), 1, GL_FALSE, glm::value_ptr(models[i]));
+			material.useMaterial(uniformShader.getUniformSpecularIntensity(), uniformShader.getUniformShininess());
+			mesh->RenderMesh();
+		}
+		uniformMs += ElapsedMs(start);
+		glFinish(); // GPU time is not part of the measurement
+	}
+
+	// 2) Linear writes into the ring + glBindBufferRange per draw
+	double ringMs = 0.0;
+	std::vector<GLintptr> offsets(drawCount);
+	for (int frame = 0; frame < frames; frame++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		auto start = std::chrono::high_resolution_clock::now();
+		blockShader.UseProgram();
+		glUniformMatrix4fv(blockShader.getUniformProjection(), 1, GL_FALSE, glm::value_ptr(projection));
+		ring.beginFrame();
+		for (int i = 0; i < drawCount; i++) {
+			ObjectBlock block;
+			block.model = models[i];
+			block.specularIntensity = material.getSpecularIntensity();
+			block.shininess = material.getShininess();
+			offsets[i] = ring.write(&block, sizeof(ObjectBlock));
+		}
+		ring.flush();
+		for (int i = 0; i < drawCount; i++) {
+			ring.bindRange(OBJECT_BLOCK_BINDING, offsets[i], sizeof(ObjectBlock));
+			mesh->RenderMesh();
+		}
+		ring.endFrame();
+		ringMs += ElapsedMs(start);
+		glFinish();
+	}
+	glUseProgram(0);
+
+	printf("Uniform upload benchmark (%d frames, CPU submission time per %d draws)\n", frames, drawCount);
+	printf("  glUniform* per draw : %8.3f ms\n", uniformMs / frames);
+	printf("  uniform ring buffer : %8.3f ms (%s, %d frames in flight, %u fence waits)\n", ringMs / frames,
+		ring.isPersistent() ? "persistent map" : "unsynchronized map", FRAMES_IN_FLIGHT, ring.getFenceWaits());
+	return 0;
+}
+
+/********************************
+*	Transform hierarchy benchmark
+*********************************/
+int RunTransformBenchmark(unsigned int nodeCount, float movingFraction) {
+	const int frames = 200;
+	TransformHierarchy hierarchy;
+	hierarchy.reserve(nodeCount);
+
+	// 4-ary tree: node i is a child of node (i - 1) / 4, so parents always come first
+	srand(1234);
+	hierarchy.createNode(TransformHierarchy::NO_PARENT);
+	for (unsigned int i = 1; i < nodeCount; i++) {
+		glm::vec3 offset((rand() % 200) * 0.01f - 1.0f, (rand() % 200) * 0.01f - 1.0f, (rand() % 200) * 0.01f - 1.0f);
+		hierarchy.createNode((i - 1) / 4, offset, glm::quat(glm::vec3(0.0f, (rand() % 360) * 0.0174533f, 0.0f)), glm::vec3(0.9f));
+	}
+	hierarchy.updateAll();
+
+	unsigned int movingCount = (unsigned int)(nodeCount * movingFraction);
+	double dirtyMs = 0.0, fullMs = 0.0;
+	unsigned long long updatedNodes = 0;
+	// RAND_MAX differs between platforms (15 or 31 bits), a fixed generator picks evenly from the whole hierarchy
+	std::mt19937 generator(1234);
+	std::uniform_int_distribution<GLuint> pickNode(0, nodeCount - 1);
+	for (int frame = 0; frame < frames; frame++) {
+		for (unsigned int i = 0; i < movingCount; i++) {
+			GLuint node = pickNode(generator);
+			glm::vec3 position = hierarchy.getLocalPosition(node);
+			position.y += (frame % 2 == 0) ? 0.01f : -0.01f;
+			hierarchy.setLocalPosition(node, position);
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+		hierarchy.update();
+		dirtyMs += ElapsedMs(start);
+		updatedNodes += hierarchy.getUpdatedCount();
+
+		start = std::chrono::high_resolution_clock::now();
+		hierarchy.updateAll();
+		fullMs += ElapsedMs(start);
+	}
+
+	printf("Transform benchmark (%u nodes, %u moving per frame, %d frames)\n", nodeCount, movingCount, frames);
+	printf("  dirty propagation : %8.3f ms/frame (%llu world matrices recomputed per frame)\n",
+		dirtyMs / frames, updatedNodes / frames);
+	printf("  full recompute    : %8.3f ms/frame (%u world matrices per frame)\n", fullMs / frames, nodeCount);
+	return 0;
+}
+
+/********************************
+*	Job system scaling benchmark
+*********************************/
+// Trace hook: every job of the last run ends up in a Chrome trace (chrome://tracing or ui.perfetto.dev)
+struct TracedJob
+{
+	const char* name;
+	unsigned int worker;
+	double startMs, endMs;
+};
+static std::vector<TracedJob> tracedJobs;
+static std::mutex tracedJobsLock;
+
+static void RecordJob(const char* name, unsigned int worker, double startMs, double endMs) {
+	TracedJob job = { name, worker, startMs, endMs };
+	std::lock_guard<std::mutex> lock(tracedJobsLock);
+	tracedJobs.push_back(job);
+}
+
+static void WriteJobTrace(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write the job trace: '%s'\n", fileLocation);
+		return;
+	}
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t i = 0; i < tracedJobs.size(); i++) {
+		// Complete events ("X"), times in microseconds
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n", tracedJobs[i].name,
+			tracedJobs[i].worker, tracedJobs[i].startMs * 1000.0, (tracedJobs[i].endMs - tracedJobs[i].startMs) * 1000.0,
+			i + 1 < tracedJobs.size() ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	fclose(file);
+}
+
+int RunJobBenchmark(bool pinThreads) {
+	const int iterations = 10;
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) {
+		maxThreads = 1;
+	}
+
+	// Normal generation: 512x512 vertex grid with a bumpy height (x, y, z, u, v, nx, ny, nz)
+	const unsigned int gridSize = 512;
+	std::vector<GLfloat> vertices(gridSize * gridSize * 8, 0.0f);
+	std::vector<unsigned int> indices;
+	for (unsigned int z = 0; z < gridSize; z++) {
+		for (unsigned int x = 0; x < gridSize; x++) {
+			GLfloat* v = &vertices[(z * gridSize + x) * 8];
+			v[0] = (GLfloat)x;
+			v[1] = sinf(x * 0.3f) * cosf(z * 0.2f);
+			v[2] = (GLfloat)z;
+			if (x + 1 < gridSize && z + 1 < gridSize) {
+				unsigned int i = z * gridSize + x;
+				unsigned int quad[] = { i, i + gridSize, i + 1, i + 1, i + gridSize, i + gridSize + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	// Transform update: wide 4-ary tree where every node moves (each level is one parallel batch)
+	const unsigned int nodeCount = 200000;
+	TransformHierarchy hierarchy;
+	hierarchy.reserve(nodeCount);
+	hierarchy.createNode(TransformHierarchy::NO_PARENT);
+	for (unsigned int i = 1; i < nodeCount; i++) {
+		hierarchy.createNode((i - 1) / 4, glm::vec3(0.1f * (i % 7), 0.2f, 0.0f), glm::quat(glm::vec3(0.0f, 0.01f * i, 0.0f)));
+	}
+
+	// Culling: bounding spheres against a frustum
+	const size_t sphereCount = 1000000;
+	std::vector<glm::vec4> spheres(sphereCount);
+	for (size_t i = 0; i < sphereCount; i++) {
+		spheres[i] = glm::vec4((GLfloat)(i % 1000) - 500.0f, 0.0f, (GLfloat)(i / 1000) - 500.0f, 1.0f);
+	}
+	std::vector<unsigned char> visible(sphereCount);
+	Frustum frustum;
+	frustum.update(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+	printf("Job system scaling (%d iterations, %s)\n", iterations, pinThreads ? "pinned threads" : "unpinned threads");
+	printf("  threads | normals (%u tris) | transforms (%u nodes) | culling (%u spheres)\n",
+		(unsigned int)indices.size() / 3, nodeCount, (unsigned int)sphereCount);
+	double baseNormalMs = 0.0, baseTransformMs = 0.0, baseCullMs = 0.0;
+	for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+		JobSystem::Initialize((int)threads - 1, pinThreads);
+		if (threads == maxThreads) {
+			tracedJobs.clear();
+			JobSystem::setTraceCallback(RecordJob); // Only the widest run is traced
+		}
+
+		double normalMs = 0.0, transformMs = 0.0, cullMs = 0.0;
+		for (int it = 0; it < iterations; it++) {
+			for (size_t v = 0; v < vertices.size(); v += 8) {
+				vertices[v + 5] = vertices[v + 6] = vertices[v + 7] = 0.0f;
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			CalcAverageNormal(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), 8, 5);
+			normalMs += ElapsedMs(start);
+
+			for (unsigned int node = 0; node < nodeCount; node++) {
+				hierarchy.setLocalScale(node, glm::vec3(it % 2 ? 0.9f : 1.0f));
+			}
+			start = std::chrono::high_resolution_clock::now();
+			hierarchy.update();
+			transformMs += ElapsedMs(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			JobSystem::parallelFor("Cull spheres", sphereCount, 4096, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					visible[i] = frustum.isSphereVisible(glm::vec3(spheres[i].x, spheres[i].y, spheres[i].z), spheres[i].w) ? 1 : 0;
+				}
+			});
+			cullMs += ElapsedMs(start);
+		}
+		normalMs /= iterations;
+		transformMs /= iterations;
+		cullMs /= iterations;
+		if (threads == 1) {
+			baseNormalMs = normalMs;
+			baseTransformMs = transformMs;
+			baseCullMs = cullMs;
+		}
+		printf("  %7u | %8.3f ms (x%4.2f) | %8.3f ms (x%4.2f)    | %8.3f ms (x%4.2f)\n", threads,
+			normalMs, baseNormalMs / normalMs, transformMs, baseTransformMs / transformMs, cullMs, baseCullMs / cullMs);
+		JobSystem::setTraceCallback(NULL);
+		JobSystem::Shutdown();
+	}
+
+	WriteJobTrace("job_trace.json");
+	printf("Jobs of the %u thread run written to job_trace.json (%u jobs)\n", maxThreads, (unsigned int)tracedJobs.size());
+	return 0;
+}
+
+/********************************
+*	Render command recording benchmark
+*********************************/
+int RunCommandBenchmark(Mesh* mesh, int drawCount) {
+	const int frames = 20;
+	const int blockCount = 64, textureCount = 8;
+	// Up to one recording slice per thread of the running job system (left as the application configured it)
+	unsigned int maxThreads = JobSystem::getThreadCount();
+
+	Shader blockShader;
+	blockShader.CreateFromString(blockVertexCode, blockFragmentCode);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+	// A few object blocks and textures for the draws to cycle through (the cost measured is recording and submission)
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	GLsizeiptr blockStride = (sizeof(ObjectBlock) + alignment - 1) / alignment * alignment;
+	std::vector<GLubyte> blockData(blockStride * blockCount, 0);
+	for (int i = 0; i < blockCount; i++) {
+		ObjectBlock* block = (ObjectBlock*)&blockData[blockStride * i];
+		block->model = glm::translate(glm::mat4(1.0f), glm::vec3((i % 8) - 4.0f, (i / 8) - 4.0f, -20.0f));
+		block->specularIntensity = 1.0f;
+		block->shininess = 32.0f;
+	}
+	GLuint blockBuffer;
+	glGenBuffers(1, &blockBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, blockBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, blockData.size(), blockData.data(), GL_STATIC_DRAW);
+	GpuMemoryTracker::trackObject(GL_BUFFER, blockBuffer, GPU_MEMORY_BUFFER, blockData.size(), "Benchmark object blocks");
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLuint textures[textureCount];
+	glGenTextures(textureCount, textures);
+	for (int i = 0; i < textureCount; i++) {
+		GLubyte pixel[4] = { (GLubyte)(i * 32), 128, 255, 255 };
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+		GpuMemoryTracker::trackObject(GL_TEXTURE, textures[i], GPU_MEMORY_TEXTURE, 4, "Benchmark texture");
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint program = blockShader.getShaderID();
+	std::vector<RenderCommandBuffer*> buffers;
+	std::vector<RenderPacket> sorted;
+	printf("Render command benchmark (%d draws, %d frames)\n", drawCount, frames);
+	printf("  threads | record    | sort + submit\n");
+	for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+		// 'threads' slices: at most that many threads record at once
+		while (buffers.size() < threads) {
+			buffers.push_back(new RenderCommandBuffer());
+		}
+
+		double recordMs = 0.0, submitMs = 0.0;
+		for (int frame = 0; frame < frames; frame++) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			auto start = std::chrono::high_resolution_clock::now();
+			JobSystem::parallelFor("Record draws", threads, 1, [&](size_t begin, size_t end) {
+				for (size_t slice = begin; slice < end; slice++) {
+					RenderCommandBuffer* buffer = buffers[slice];
+					buffer->reset();
+					int first = (int)((size_t)drawCount * slice / threads), last = (int)((size_t)drawCount * (slice + 1) / threads);
+					for (int i = first; i < last; i++) {
+						GLuint texture = textures[(i * 7) % textureCount]; // Scrambled so the sort has work to do
+						buffer->beginPacket(RenderCommandBuffer::MakeSortKey(program, texture, mesh->getVAO()));
+						buffer->setProgram(program);
+						buffer->bindTexture(GL_TEXTURE0, GL_TEXTURE_2D, texture);
+						buffer->bindVertexArray(mesh->getVAO(), mesh->getIBO());
+						buffer->bindUniformRange(OBJECT_BLOCK_BINDING, blockBuffer, blockStride * (i % blockCount), sizeof(ObjectBlock));
+						buffer->drawElements(GL_TRIANGLES, mesh->getIndexCount(), GL_UNSIGNED_INT, 0);
+						buffer->endPacket();
+					}
+				}
+			});
+			recordMs += ElapsedMs(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			blockShader.UseProgram();
+			glUniformMatrix4fv(blockShader.getUniformProjection(), 1, GL_FALSE, glm::value_ptr(projection));
+			RenderCommandBuffer::Replay(buffers.data(), threads, sorted);
+			submitMs += ElapsedMs(start);
+			glFinish(); // GPU time is not part of the measurement
+		}
+		printf("  %7u | %6.3f ms | %6.3f ms\n", threads, recordMs / frames, submitMs / frames);
+	}
+	glUseProgram(0);
+
+	for (size_t i = 0; i < buffers.size(); i++) {
+		delete buffers[i];
+	}
+	for (int i = 0; i < textureCount; i++) {
+		GpuMemoryTracker::releaseObject(GL_TEXTURE, textures[i]);
+	}
+	GpuMemoryTracker::releaseObject(GL_BUFFER, blockBuffer);
+	glDeleteTextures(textureCount, textures);
+	glDeleteBuffers(1, &blockBuffer);
+	return 0;
+}
+
+/********************************
+*	Mesh import benchmark
+*********************************/
+// Bumpy 'gridSize' x 'gridSize' grid with normals and texture coordinates, as OBJ and as binary glTF
+static bool WriteImportModels(const char* objLocation, const char* glbLocation, unsigned int gridSize) {
+	std::vector<GLfloat> vertices(gridSize * gridSize * 8, 0.0f);
+	std::vector<unsigned int> indices;
+	for (unsigned int z = 0; z < gridSize; z++) {
+		for (unsigned int x = 0; x < gridSize; x++) {
+			GLfloat* v = &vertices[(z * gridSize + x) * 8];
+			v[0] = x * 0.01f;
+			v[1] = sinf(x * 0.3f) * cosf(z * 0.2f) * 0.05f;
+			v[2] = z * 0.01f;
+			v[3] = (GLfloat)x / (gridSize - 1);
+			v[4] = (GLfloat)z / (gridSize - 1);
+			if (x + 1 < gridSize && z + 1 < gridSize) {
+				unsigned int i = z * gridSize + x;
+				unsigned int quad[] = { i, i + gridSize, i + 1, i + 1, i + gridSize, i + gridSize + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+	CalcAverageNormal(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), 8, 5);
+	size_t vertexCount = vertices.size() / 8;
+
+	FILE* obj = fopen(objLocation, "w");
+	if (!obj) {
+		printf("Failed to write '%s'\n", objLocation);
+		return false;
+	}
+	fprintf(obj, "# %u x %u grid\n", gridSize, gridSize);
+	for (size_t i = 0; i < vertexCount; i++) {
+		fprintf(obj, "v %f %f %f\n", vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		fprintf(obj, "vt %f %f\n", vertices[i * 8 + 3], 1.0f - vertices[i * 8 + 4]);
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		fprintf(obj, "vn %f %f %f\n", vertices[i * 8 + 5], vertices[i * 8 + 6], vertices[i * 8 + 7]);
+	}
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		fprintf(obj, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", indices[i] + 1, indices[i] + 1, indices[i] + 1,
+			indices[i + 1] + 1, indices[i + 1] + 1, indices[i + 1] + 1, indices[i + 2] + 1, indices[i + 2] + 1, indices[i + 2] + 1);
+	}
+	fclose(obj);
+
+	// Binary chunk: positions | normals | texture coordinates | indices, one buffer view each
+	std::vector<GLfloat> positions, normals, texcoords;
+	for (size_t i = 0; i < vertexCount; i++) {
+		positions.insert(positions.end(), &vertices[i * 8], &vertices[i * 8] + 3);
+		texcoords.insert(texcoords.end(), &vertices[i * 8 + 3], &vertices[i * 8 + 3] + 2);
+		normals.insert(normals.end(), &vertices[i * 8 + 5], &vertices[i * 8 + 5] + 3);
+	}
+	size_t sizes[] = { positions.size() * 4, normals.size() * 4, texcoords.size() * 4, indices.size() * 4 };
+	const void* chunks[] = { positions.data(), normals.data(), texcoords.data(), indices.data() };
+	char json[2048];
+	int jsonLength = snprintf(json, sizeof(json),
+		"{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":%zu}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+		"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+		"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":2,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+		"{\"bufferView\":3,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}]}",
+		sizes[0] + sizes[1] + sizes[2] + sizes[3], sizes[0], sizes[0], sizes[1], sizes[0] + sizes[1], sizes[2],
+		sizes[0] + sizes[1] + sizes[2], sizes[3], vertexCount, vertexCount, vertexCount, indices.size());
+	while (jsonLength % 4 != 0) {
+		json[jsonLength++] = ' '; // Chunks are 4-byte aligned, JSON is padded with spaces
+	}
+	uint32_t binLength = (uint32_t)(sizes[0] + sizes[1] + sizes[2] + sizes[3]);
+	uint32_t header[] = { 0x46546C67, 2, (uint32_t)(12 + 8 + jsonLength + 8 + binLength) };
+	uint32_t jsonHeader[] = { (uint32_t)jsonLength, 0x4E4F534A };
+	uint32_t binHeader[] = { binLength, 0x004E4942 };
+
+	FILE* glb = fopen(glbLocation, "wb");
+	if (!glb) {
+		printf("Failed to write '%s'\n", glbLocation);
+		return false;
+	}
+	fwrite(header, sizeof(header), 1, glb);
+	fwrite(jsonHeader, sizeof(jsonHeader), 1, glb);
+	fwrite(json, jsonLength, 1, glb);
+	fwrite(binHeader, sizeof(binHeader), 1, glb);
+	for (int i = 0; i < 4; i++) {
+		fwrite(chunks[i], sizes[i], 1, glb);
+	}
+	fclose(glb);
+	return true;
+}
+
+int RunImportBenchmark(const char* fileLocation) {
+	const int iterations = 3; // Best of
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) {
+		maxThreads = 1;
+	}
+
+	std::vector<std::string> files;
+	bool generated = fileLocation == NULL;
+	if (generated) {
+		const unsigned int gridSize = 512;
+		if (!WriteImportModels("bench_import.obj", "bench_import.glb", gridSize)) {
+			return 1;
+		}
+		files.push_back("bench_import.obj");
+		files.push_back("bench_import.glb");
+	}
+	else {
+		files.push_back(fileLocation);
+	}
+
+	int result = 0;
+	for (size_t f = 0; f < files.size(); f++) {
+		MappedFile file;
+		if (!file.open(files[f].c_str(), false)) {
+			result = 1;
+			break;
+		}
+		double megabytes = file.getSize() / (1024.0 * 1024.0);
+		file.close();
+
+		ImportedMesh mesh;
+		if (!MeshImporter::importMesh(files[f].c_str(), mesh)) {
+			result = 1;
+			break;
+		}
+		printf("Import of '%s' (%.1f MB, %u vertices, %u triangles, best of %d)\n", files[f].c_str(), megabytes,
+			(unsigned int)mesh.vertices.size() / 8, (unsigned int)mesh.indices.size() / 3, iterations);
+		printf("  threads |    time    |  throughput\n");
+		double baseMs = 0.0;
+		for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+			JobSystem::Initialize((int)threads - 1);
+			double bestMs = 0.0;
+			for (int it = 0; it < iterations; it++) {
+				ImportedMesh imported;
+				auto start = std::chrono::high_resolution_clock::now();
+				MeshImporter::importMesh(files[f].c_str(), imported);
+				double ms = ElapsedMs(start);
+				bestMs = it == 0 || ms < bestMs ? ms : bestMs;
+			}
+			baseMs = threads == 1 ? bestMs : baseMs;
+			printf("  %7u | %8.2f ms | %7.1f MB/s (x%4.2f)\n", threads, bestMs, megabytes * 1000.0 / bestMs, baseMs / bestMs);
+			JobSystem::Shutdown();
+		}
+	}
+
+	if (generated) {
+		remove("bench_import.obj");
+		remove("bench_import.glb");
+	}
+	return result;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Mesh.h"
+
+// Benchmark modes selected from the command line. Each one needs an initialized window/context,
+// prints its results and returns the process exit code
+
+// --bench-uniforms: CPU time to submit 'drawCount' draws with glUniform* calls vs the uniform ring buffer
+int RunUniformBenchmark(Mesh* mesh, int drawCount);
+
+// --bench-commands: record 'drawCount' draws into per-thread command buffers with 1 to N threads,
+// then sort and submit them on the GL thread
+int RunCommandBenchmark(Mesh* mesh, int drawCount);
+
+// --bench-transforms: 'nodeCount' node hierarchy where 'movingFraction' of the nodes move every frame.
+// Dirty-propagated update vs recomputing every world matrix. Needs no GL context
+int RunTransformBenchmark(unsigned int nodeCount, float movingFraction);
+
+
+// --bench-jobs: normal generation, transform update and sphere culling with 1 to N threads.
+// Writes the jobs of the widest run to job_trace.json. Needs no GL context
+int RunJobBenchmark(bool pinThreads);
+
+// --bench-import [file.obj|file.glb]: mesh import throughput (MB/s) with 1 to N threads. Without a file, a
+// generated grid is written as OBJ and as binary glTF and both are measured. Needs no GL context
+int RunImportBenchmark(const char* fileLocation);
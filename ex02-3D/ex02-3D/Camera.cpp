@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "RedrawTracker.h"
 
 Camera::Camera(glm::vec3 startPosition, glm::vec3 startWorldUp, GLfloat startYaw, GLfloat startPitch, GLfloat startMoveSpeed, GLfloat startTurnSpeed) {
 	position = startPosition;
@@ -27,10 +28,18 @@ void Camera::keyControl(bool* keys, GLfloat deltaTime){
 	if (keys[GLFW_KEY_D] || keys[GLFW_KEY_RIGHT]) {
 		position += right * velocity;
 	}
+
+	if (velocity != 0.0f && (keys[GLFW_KEY_W] || keys[GLFW_KEY_UP] || keys[GLFW_KEY_S] || keys[GLFW_KEY_DOWN] ||
+		keys[GLFW_KEY_A] || keys[GLFW_KEY_LEFT] || keys[GLFW_KEY_D] || keys[GLFW_KEY_RIGHT])) {
+		RedrawTracker::markDirty(); // The camera moved
+	}
 }
 
 void Camera::mouseControl(GLfloat xChange, GLfloat yChange, GLfloat deltaTime) {
 	GLfloat velocity = deltaTime * turnSpeed;
+	if (xChange != 0.0f || yChange != 0.0f) {
+		RedrawTracker::markDirty();
+	}
 
 	yaw += xChange * velocity;
 	pitch += yChange * velocity;
@@ -43,6 +52,16 @@ void Camera::mouseControl(GLfloat xChange, GLfloat yChange, GLfloat deltaTime) {
 	update();
 }
 
+void Camera::setPose(glm::vec3 newPosition, GLfloat newYaw, GLfloat newPitch) {
+	if (newPosition != position || newYaw != yaw || newPitch != pitch) {
+		RedrawTracker::markDirty();
+	}
+	position = newPosition;
+	yaw = newYaw;
+	pitch = glm::clamp(newPitch, -90.0f, 90.0f);
+	update();
+}
+
 
 void Camera::update() {
 	front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
@@ -59,5 +78,13 @@ glm::mat4 Camera::calculateViewMatrix() {
 	return glm::lookAt(position, position + front, up);
 }
 
+glm::mat4 Camera::calculateViewMatrix(const Camera& previous, GLfloat alpha) {
+	glm::vec3 eye = previous.position + (position - previous.position) * alpha;
+	glm::vec3 direction = glm::normalize(previous.front + (front - previous.front) * alpha);
+	glm::vec3 blendedRight = glm::normalize(glm::cross(direction, worldUp));
+	glm::vec3 blendedUp = glm::normalize(glm::cross(blendedRight, direction));
+	return glm::lookAt(eye, eye + direction, blendedUp);
+}
+
 Camera::Camera() {}
 Camera::~Camera() {}
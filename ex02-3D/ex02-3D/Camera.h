@@ -14,8 +14,12 @@ public:
 
 	void keyControl(bool* keys, GLfloat deltaTime);
 	void mouseControl(GLfloat xChange, GLfloat yChange, GLfloat deltaTime);
+	// Places the camera directly (scripted paths), pitch in [-90, 90]
+	void setPose(glm::vec3 newPosition, GLfloat newYaw, GLfloat newPitch);
 
 	glm::mat4 calculateViewMatrix();
+	// View 'alpha' of the way from 'previous' (the camera one simulation step earlier) to this camera
+	glm::mat4 calculateViewMatrix(const Camera& previous, GLfloat alpha);
 
 	glm::vec3 getCameraPosition() { return position; };
 	glm::vec3 getCameraDirection() { return glm::normalize(front); };
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <math.h>
+#include "CameraPath.h"
+
+CameraPath::CameraPath() {
+}
+
+bool CameraPath::loadPath(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "r");
+	if (!file) {
+		printf("Failed to read camera path '%s'\n", fileLocation);
+		return false;
+	}
+
+	keys.clear();
+	char line[256];
+	int lineNumber = 0;
+	bool success = true;
+	while (fgets(line, sizeof(line), file)) {
+		lineNumber++;
+		PathKey key;
+		int fields = sscanf(line, "%f %f %f %f %f %f", &key.time, &key.position.x, &key.position.y, &key.position.z, &key.yaw, &key.pitch);
+		if (fields <= 0 || line[0] == '#') {
+			continue; // Blank line or comment
+		}
+		if (fields != 6 || (!keys.empty() && key.time <= keys.back().time)) {
+			printf("Camera path '%s', line %d: expected 'time x y z yaw pitch' with increasing time\n", fileLocation, lineNumber);
+			success = false;
+			break;
+		}
+		keys.push_back(key);
+	}
+	fclose(file);
+
+	if (success && keys.size() < 2) {
+		printf("Camera path '%s' needs at least two keyframes\n", fileLocation);
+		success = false;
+	}
+	if (!success) {
+		keys.clear();
+	}
+	return success;
+}
+
+void CameraPath::createOrbit(glm::vec3 center, GLfloat radius, GLfloat height, GLfloat seconds) {
+	// 16 keyframes are plenty for the spline to follow the circle
+	const int KEY_COUNT = 16;
+	keys.clear();
+	for (int i = 0; i <= KEY_COUNT; i++) {
+		GLfloat angle = 2.0f * 3.14159265f * i / KEY_COUNT;
+		PathKey key;
+		key.time = seconds * i / KEY_COUNT;
+		key.position = center + glm::vec3(cosf(angle) * radius, height, sinf(angle) * radius);
+		// Yaw 0 looks down +x (see Camera::update), so face back towards the center
+		key.yaw = glm::degrees(angle) + 180.0f;
+		key.pitch = -glm::degrees(atan2f(height, radius));
+		keys.push_back(key);
+	}
+}
+
+GLfloat CameraPath::getDuration() {
+	return keys.empty() ? 0.0f : keys.back().time;
+}
+
+// Catmull-Rom: passes through p1 at t = 0 and p2 at t = 1, with tangents taken from the neighbours
+template <typename T>
+static T CatmullRom(const T& p0, const T& p1, const T& p2, const T& p3, GLfloat t) {
+	GLfloat t2 = t * t, t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+void CameraPath::sample(GLfloat time, glm::vec3& position, GLfloat& yaw, GLfloat& pitch) {
+	if (keys.empty()) {
+		return;
+	}
+	if (time <= keys.front().time || keys.size() == 1) {
+		position = keys.front().position;
+		yaw = keys.front().yaw;
+		pitch = keys.front().pitch;
+		return;
+	}
+	if (time >= keys.back().time) {
+		position = keys.back().position;
+		yaw = keys.back().yaw;
+		pitch = keys.back().pitch;
+		return;
+	}
+
+	// Segment [i, i + 1] holding 'time'. The end keys are repeated as the outer control points
+	size_t i = 0;
+	while (keys[i + 1].time <= time) {
+		i++;
+	}
+	const PathKey& k0 = keys[i > 0 ? i - 1 : i];
+	const PathKey& k1 = keys[i];
+	const PathKey& k2 = keys[i + 1];
+	const PathKey& k3 = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+	GLfloat t = (time - k1.time) / (k2.time - k1.time);
+
+	position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	yaw = CatmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+	pitch = CatmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+}
+
+CameraPath::~CameraPath() {
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+/*
+Scripted camera movement for benchmarks: keyframes of position and orientation, sampled with a Catmull-Rom
+spline so the camera moves smoothly through every keyframe. Path files hold one keyframe per line:
+
+	# time(s)	x	y	z	yaw	pitch
+	0.0		0.0	1.0	4.0	-90.0	-10.0
+	2.5		3.0	1.5	0.0	-180.0	-15.0
+
+Lines starting with '#' are comments. Keyframes must be in increasing time order
+*/
+class CameraPath
+{
+public:
+	CameraPath();
+
+	bool loadPath(const char* fileLocation);
+	// Built-in path: one loop around 'center' in 'seconds', looking at it
+	void createOrbit(glm::vec3 center, GLfloat radius, GLfloat height, GLfloat seconds);
+
+	GLfloat getDuration();
+	bool isEmpty() { return keys.size() < 2; };
+	void sample(GLfloat time, glm::vec3& position, GLfloat& yaw, GLfloat& pitch);
+
+	~CameraPath();
+
+private:
+	struct PathKey
+	{
+		GLfloat time;
+		glm::vec3 position;
+		GLfloat yaw, pitch;
+	};
+
+	std::vector<PathKey> keys;
+};
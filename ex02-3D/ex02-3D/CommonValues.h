@@ -2,3 +2,8 @@
 
 const int MAX_POINT_LIGHTS = 3;
 const int MAX_SPOT_LIGHTS = 3;
+
+// Uniform block binding points (see Shader::CreateShader)
+const int OBJECT_BLOCK_BINDING = 0;
+// Frames the CPU may run ahead of the GPU in the per-frame ring buffers
+const int FRAMES_IN_FLIGHT = 3;
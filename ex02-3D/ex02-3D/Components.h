@@ -0,0 +1,51 @@
+#pragma once
+#include <GL\glew.h>
+
+#include "Material.h"
+#include "Texture.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+
+// Components of the scene entities (see Scene.h). Plain data, the behaviour lives in SceneSystems
+
+// Node in the TransformHierarchy holding the local TRS and cached world matrix
+struct Transform
+{
+	GLuint node;
+};
+
+// Index in meshList (same index as the mesh ID of the IndirectRenderer)
+struct MeshRef
+{
+	GLuint mesh;
+};
+
+struct MaterialRef
+{
+	Material* material;
+};
+
+// Texture for the classic path and its layer in the TextureArray for the indirect path
+struct TextureRef
+{
+	Texture* texture;
+	GLint layer;
+};
+
+struct DirectionalLightComponent
+{
+	DirectionalLight light;
+};
+
+struct PointLightComponent
+{
+	PointLight light;
+};
+
+struct SpotLightComponent
+{
+	SpotLight light;
+	bool attachedToCamera; // Flashlight: follows the camera position and direction
+};
+
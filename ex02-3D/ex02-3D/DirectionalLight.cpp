@@ -11,13 +11,3 @@ DirectionalLight::DirectionalLight(GLfloat red, GLfloat green, GLfloat blue, GLf
 }
 
 DirectionalLight::~DirectionalLight() {}
-
-void DirectionalLight::useLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-	GLuint diffuseIntensityLocation, GLuint directionLocation) {
-	// Ambient
-	glUniform1f(ambientIntensityLocation, ambientIntensity);
-	glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-	// Diffuse
-	glUniform1f(diffuseIntensityLocation, diffuseIntensity);
-	glUniform3f(directionLocation, direction.x, direction.y, direction.z);
-}
@@ -8,8 +8,7 @@ public:
 	DirectionalLight(GLfloat red, GLfloat green, GLfloat blue, GLfloat aIntensity, GLfloat dIntensity,
 		GLfloat xDir, GLfloat yDir, GLfloat zDir);
 	~DirectionalLight();
-	void useLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-		GLuint diffuseIntensityLocation, GLuint directionLocation);
+	glm::vec3 getDirection() const { return direction; };
 
 private:
 	glm::vec3 direction;
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "FileWatcher.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+FileWatcher::FileWatcher() {
+#ifndef _WIN32
+	inotify = -1;
+#endif
+}
+
+#ifdef _WIN32
+static unsigned long long GetLastWrite(const char* fileLocation) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileLocation, GetFileExInfoStandard, &attributes)) {
+		return 0;
+	}
+	return (unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+}
+#endif
+
+bool FileWatcher::watchFile(const char* fileLocation) {
+	std::string location = fileLocation;
+	for (size_t i = 0; i < files.size(); i++) {
+		if (files[i].location == location) {
+			return true;
+		}
+	}
+	size_t slash = location.find_last_of("/\\");
+	std::string directoryLocation = slash == std::string::npos ? "." : location.substr(0, slash);
+	WatchedFile file;
+	file.location = location;
+	file.name = slash == std::string::npos ? location : location.substr(slash + 1);
+
+	// One watch per directory, shared by its files
+	file.directory = directories.size();
+	for (size_t i = 0; i < directories.size(); i++) {
+		if (directories[i].location == directoryLocation) {
+			file.directory = i;
+		}
+	}
+	if (file.directory == directories.size()) {
+		WatchedDirectory directory;
+		directory.location = directoryLocation;
+#ifdef _WIN32
+		directory.changeHandle = FindFirstChangeNotificationA(directoryLocation.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+		if (directory.changeHandle == INVALID_HANDLE_VALUE) {
+			printf("Failed to watch the directory '%s'\n", directoryLocation.c_str());
+			return false;
+		}
+#else
+		if (inotify < 0) {
+			inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (inotify < 0) {
+				printf("inotify is not available, files are not watched\n");
+				return false;
+			}
+		}
+		// Written and closed, or renamed into the directory (editors that save through a temporary file)
+		directory.watch = inotify_add_watch(inotify, directoryLocation.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (directory.watch < 0) {
+			printf("Failed to watch the directory '%s'\n", directoryLocation.c_str());
+			return false;
+		}
+#endif
+		directories.push_back(directory);
+	}
+#ifdef _WIN32
+	file.lastWrite = GetLastWrite(fileLocation);
+#endif
+	files.push_back(file);
+	return true;
+}
+
+void FileWatcher::pollChanges(std::vector<std::string>& changedFiles) {
+	size_t firstChange = changedFiles.size();
+#ifdef _WIN32
+	for (size_t d = 0; d < directories.size(); d++) {
+		if (WaitForSingleObject((HANDLE)directories[d].changeHandle, 0) != WAIT_OBJECT_0) {
+			continue;
+		}
+		FindNextChangeNotification((HANDLE)directories[d].changeHandle); // Rearms it
+		// The notification does not say which file changed: the write times of the directory's files do
+		for (size_t i = 0; i < files.size(); i++) {
+			if (files[i].directory != d) {
+				continue;
+			}
+			unsigned long long lastWrite = GetLastWrite(files[i].location.c_str());
+			if (lastWrite != 0 && lastWrite != files[i].lastWrite) {
+				files[i].lastWrite = lastWrite;
+				changedFiles.push_back(files[i].location);
+			}
+		}
+	}
+#else
+	if (inotify < 0) {
+		return;
+	}
+	// Aligned for the event structs. Non-blocking: read() fails with EAGAIN once the queue is empty
+	alignas(struct inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t length = read(inotify, buffer, sizeof(buffer));
+		if (length <= 0) {
+			break;
+		}
+		for (ssize_t offset = 0; offset < length;) {
+			const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+			if (event->len == 0) {
+				continue;
+			}
+			for (size_t i = 0; i < files.size(); i++) {
+				if (directories[files[i].directory].watch == event->wd && files[i].name == event->name) {
+					changedFiles.push_back(files[i].location);
+				}
+			}
+		}
+	}
+#endif
+	// Once per file, however many events it had
+	std::vector<std::string>::iterator begin = changedFiles.begin() + firstChange;
+	std::sort(begin, changedFiles.end());
+	changedFiles.erase(std::unique(begin, changedFiles.end()), changedFiles.end());
+}
+
+void FileWatcher::clearWatcher() {
+#ifdef _WIN32
+	for (size_t i = 0; i < directories.size(); i++) {
+		FindCloseChangeNotification((HANDLE)directories[i].changeHandle);
+	}
+#else
+	if (inotify >= 0) {
+		close(inotify); // Removes every watch
+		inotify = -1;
+	}
+#endif
+	directories.clear();
+	files.clear();
+}
+
+FileWatcher::~FileWatcher() {
+	clearWatcher();
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+Tells which of the watched files were written since the last poll. The directories of the files are watched
+(inotify on Linux, change notifications on Windows), not the files themselves: editors often save by writing a new
+file and renaming it over the old one.
+
+pollChanges() never blocks, the main loop calls it once per frame
+*/
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// False when the file watching is not available (the file is then never reported). Watching a file twice is
+	// the same as once
+	bool watchFile(const char* fileLocation);
+	// Appends every watched file written since the last call, each once however many times it was written
+	void pollChanges(std::vector<std::string>& changedFiles);
+	void clearWatcher();
+
+	size_t getWatchedCount() { return files.size(); };
+
+private:
+	struct WatchedDirectory
+	{
+		std::string location;
+#ifdef _WIN32
+		void* changeHandle;
+#else
+		int watch;
+#endif
+	};
+
+	struct WatchedFile
+	{
+		std::string location; // As given to watchFile
+		std::string name; // Without the directory
+		size_t directory; // In 'directories'
+#ifdef _WIN32
+		unsigned long long lastWrite; // Compared when the directory signals a change
+#endif
+	};
+
+	std::vector<WatchedDirectory> directories;
+	std::vector<WatchedFile> files;
+#ifndef _WIN32
+	int inotify;
+#endif
+};
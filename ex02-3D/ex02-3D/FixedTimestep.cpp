@@ -0,0 +1,69 @@
+#include <math.h>
+#include "FixedTimestep.h"
+
+const double FixedTimestep::MAX_FRAME_SECONDS = 0.25;
+
+FixedTimestep::FixedTimestep() {
+	stepSeconds = 1.0 / 60.0;
+	accumulator = 0.0;
+	statSteps = 0;
+	statDropped = 0;
+	statNanoseconds = 0;
+	statMaxNanoseconds = 0;
+}
+
+FixedTimestep::FixedTimestep(double stepsPerSecond) {
+	stepSeconds = 1.0 / (stepsPerSecond > 0.0 ? stepsPerSecond : 60.0);
+	accumulator = 0.0;
+	statSteps = 0;
+	statDropped = 0;
+	statNanoseconds = 0;
+	statMaxNanoseconds = 0;
+}
+
+void FixedTimestep::setStepRate(double stepsPerSecond) {
+	if (stepsPerSecond > 0.0) {
+		stepSeconds = 1.0 / stepsPerSecond;
+		accumulator = 0.0;
+	}
+}
+
+unsigned int FixedTimestep::advance(double frameSeconds) {
+	if (frameSeconds > MAX_FRAME_SECONDS) {
+		frameSeconds = MAX_FRAME_SECONDS;
+	}
+	if (frameSeconds > 0.0) {
+		accumulator += frameSeconds;
+	}
+
+	unsigned int steps = (unsigned int)(accumulator / stepSeconds);
+	if (steps > MAX_STEPS) {
+		// Cannot keep up: simulate what the frame allows and drop the rest
+		statDropped += steps - MAX_STEPS;
+		steps = MAX_STEPS;
+		accumulator = fmod(accumulator, stepSeconds) + MAX_STEPS * stepSeconds;
+	}
+	accumulator -= steps * stepSeconds;
+	return steps;
+}
+
+void FixedTimestep::beginStep() {
+	stepStart = std::chrono::high_resolution_clock::now();
+}
+
+void FixedTimestep::endStep() {
+	long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - stepStart).count();
+	statSteps++;
+	statNanoseconds += nanoseconds;
+	if (nanoseconds > statMaxNanoseconds.load()) {
+		statMaxNanoseconds = nanoseconds; // Single writer, a plain store is enough
+	}
+}
+
+void FixedTimestep::takeStats(unsigned int& steps, double& averageMs, double& maxMs, unsigned int& droppedSteps) {
+	steps = statSteps.exchange(0);
+	long long total = statNanoseconds.exchange(0);
+	averageMs = steps > 0 ? total / 1e6 / steps : 0.0;
+	maxMs = statMaxNanoseconds.exchange(0) / 1e6;
+	droppedSteps = statDropped.exchange(0);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <GL\glew.h>
+
+/*
+Fixed-step simulation clock. The real frame time goes into an accumulator and the simulation advances in
+whole steps of 1 / stepRate seconds, so its results no longer depend on the frame rate:
+
+	unsigned int steps = clock.advance(frameSeconds);
+	for (unsigned int i = 0; i < steps; i++) { simulate(clock.getStepSeconds()); }
+	render(lerp(previousState, currentState, clock.getAlpha()));
+
+A long frame (a stall, a breakpoint) is clamped and at most MAX_STEPS run per frame; the rest is dropped
+instead of trying to catch up forever
+*/
+class FixedTimestep
+{
+public:
+	FixedTimestep();
+	FixedTimestep(double stepsPerSecond);
+
+	void setStepRate(double stepsPerSecond);
+	double getStepRate() { return 1.0 / stepSeconds; };
+	GLfloat getStepSeconds() { return (GLfloat)stepSeconds; };
+
+	// Adds the real time of the frame and returns the number of steps to simulate now
+	unsigned int advance(double frameSeconds);
+	// Position of the rendered frame between the last two steps, in [0, 1)
+	GLfloat getAlpha() { return (GLfloat)(accumulator / stepSeconds); };
+
+	// Step timing (call around every step)
+	void beginStep();
+	void endStep();
+	// Stats since the previous call. Can be read from another thread than the one stepping
+	void takeStats(unsigned int& steps, double& averageMs, double& maxMs, unsigned int& droppedSteps);
+
+private:
+	static const unsigned int MAX_STEPS = 8; // Per frame
+	static const double MAX_FRAME_SECONDS; // Longer frames are clamped
+
+	double stepSeconds;
+	double accumulator; // Real time not simulated yet
+
+	std::chrono::high_resolution_clock::time_point stepStart;
+	std::atomic<unsigned int> statSteps, statDropped;
+	std::atomic<long long> statNanoseconds, statMaxNanoseconds;
+};
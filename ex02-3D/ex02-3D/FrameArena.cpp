@@ -0,0 +1,99 @@
+#include <string.h>
+#include "FrameArena.h"
+#include "SystemStats.h"
+
+static const size_t FRAME_BLOCK_SIZE = 256 * 1024;
+static const size_t SCRATCH_BLOCK_SIZE = 4 * 1024 * 1024; // Decoded images are large, most fit in one block
+static const size_t SCRATCH_HEADER = 16; // Size of the allocation, keeps the data 16-byte aligned
+
+thread_local FrameArena::ThreadArena* FrameArena::threadArena = NULL;
+std::mutex FrameArena::arenasLock;
+std::vector<FrameArena::ThreadArena*> FrameArena::arenas;
+std::atomic<unsigned long long> FrameArena::frameIndex(0);
+std::atomic<size_t> FrameArena::allocatedBytes(0);
+std::atomic<size_t> FrameArena::reservedBytes(0);
+unsigned long long FrameArena::frameHeapAllocations = 0;
+unsigned long long FrameArena::heapAllocationsAtFrameStart = 0;
+size_t FrameArena::frameBytes = 0;
+
+FrameArena::ThreadArena* FrameArena::getThreadArena() {
+	if (!threadArena) {
+		ThreadArena* arena = new ThreadArena();
+		for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+			arena->frames[i].setBlockSize(FRAME_BLOCK_SIZE);
+			arena->frameOfSlot[i] = ~0ull; // Reset on first use
+		}
+		arena->scratch.setBlockSize(SCRATCH_BLOCK_SIZE);
+		std::lock_guard<std::mutex> lock(arenasLock);
+		arenas.push_back(arena);
+		threadArena = arena;
+	}
+	return threadArena;
+}
+
+void FrameArena::beginFrame() {
+	unsigned long long heapAllocations = GetHeapAllocationCount();
+	frameHeapAllocations = heapAllocations - heapAllocationsAtFrameStart;
+	heapAllocationsAtFrameStart = heapAllocations;
+	frameBytes = allocatedBytes.exchange(0);
+	frameIndex++;
+}
+
+/********************************
+*	Allocation
+*********************************/
+void* FrameArena::allocateFrom(LinearAllocator& allocator, size_t size, size_t align) {
+	size_t reservedBefore = allocator.getReservedBytes();
+	void* memory = allocator.allocate(size, align);
+	if (allocator.getReservedBytes() != reservedBefore) {
+		reservedBytes += allocator.getReservedBytes() - reservedBefore; // A new block
+	}
+	allocatedBytes += size;
+	return memory;
+}
+
+void* FrameArena::allocate(size_t size, size_t align) {
+	ThreadArena* arena = getThreadArena();
+	unsigned long long frame = frameIndex.load(std::memory_order_relaxed);
+	unsigned int slot = (unsigned int)(frame % FRAME_COUNT);
+	if (arena->frameOfSlot[slot] != frame) {
+		// Last used FRAME_COUNT (or more) frames ago, nothing in it is alive anymore
+		arena->frames[slot].reset();
+		arena->frameOfSlot[slot] = frame;
+	}
+	return allocateFrom(arena->frames[slot], size, align);
+}
+
+/********************************
+*	Scratch
+*********************************/
+void* FrameArena::allocateScratch(size_t size, size_t align) {
+	return allocateFrom(getThreadArena()->scratch, size, align);
+}
+
+void FrameArena::releaseScratch() {
+	std::lock_guard<std::mutex> lock(arenasLock);
+	for (size_t i = 0; i < arenas.size(); i++) {
+		reservedBytes -= arenas[i]->scratch.getReservedBytes();
+		arenas[i]->scratch.release();
+	}
+}
+
+void* FrameArena::scratchMalloc(size_t size) {
+	unsigned char* memory = (unsigned char*)allocateScratch(size + SCRATCH_HEADER, 16);
+	*(size_t*)memory = size;
+	return memory + SCRATCH_HEADER;
+}
+
+void* FrameArena::scratchRealloc(void* memory, size_t size) {
+	if (!memory) {
+		return scratchMalloc(size);
+	}
+	size_t oldSize = *(size_t*)((unsigned char*)memory - SCRATCH_HEADER);
+	if (size <= oldSize) {
+		return memory;
+	}
+	void* grown = scratchMalloc(size);
+	memcpy(grown, memory, oldSize);
+	return grown;
+}
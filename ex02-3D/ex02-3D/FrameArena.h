@@ -0,0 +1,98 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "CommonValues.h"
+#include "LinearAllocator.h"
+
+/*
+Memory for data that only lives for a frame or two (sort scratch, temporary lists, per-frame maps...):
+
+	FrameVector<GLuint> counts; // Comes from the arena of this thread, nothing to free
+	counts.reserve(chunkCount);
+
+Every thread allocates from its own sub-arena, so there is no lock and no contention. Each sub-arena has one
+LinearAllocator per frame in flight: what is allocated during frame N stays valid until frame N + FRAME_COUNT
+starts, which covers a packet built by the update thread one frame ahead. The blocks are kept, so once the
+arenas reached their size a frame does not touch the heap anymore.
+
+The scratch arena is for loading (stb_image decodes through it, see Source.cpp): it is only released by
+releaseScratch(), when nothing decoded is still in use and no job that could allocate scratch memory is queued or
+running (the threads allocate from their scratch without a lock).
+
+beginFrame() also measures the heap allocations of the frame that ended (GetHeapAllocationCount). Once the
+application reached its steady state the count should stay at zero
+*/
+class FrameArena
+{
+public:
+	static const unsigned int FRAME_COUNT = FRAMES_IN_FLIGHT;
+
+	// Main thread, once per iteration of the main loop. Older frames are reused lazily by each thread
+	static void beginFrame();
+
+	// 'size' bytes aligned to 'align' (a power of two, up to 16), valid for FRAME_COUNT frames. Any thread
+	static void* allocate(size_t size, size_t align = 16);
+
+	// Loading memory of the calling thread, kept until releaseScratch()
+	static void* allocateScratch(size_t size, size_t align = 16);
+	// Frees the scratch blocks of every thread. Only while no thread uses or allocates scratch memory: between
+	// loading phases, once every job that decodes has been waited for
+	static void releaseScratch();
+
+	// malloc/realloc/free for C libraries (stb_image) on top of the scratch arena. Freeing does nothing,
+	// a realloc that grows copies the data (the size is kept in front of each allocation)
+	static void* scratchMalloc(size_t size);
+	static void* scratchRealloc(void* memory, size_t size);
+	static void scratchFree(void*) {};
+
+	// Of the last finished frame
+	static unsigned long long getFrameHeapAllocations() { return frameHeapAllocations; };
+	static size_t getFrameBytes() { return frameBytes; }; // Handed out by every sub-arena
+	static size_t getReservedBytes() { return reservedBytes.load(); }; // Blocks of every sub-arena, scratch included
+	static unsigned long long getFrameIndex() { return frameIndex.load(std::memory_order_relaxed); };
+
+private:
+	// Sub-arena of one thread, created on its first allocation
+	struct ThreadArena
+	{
+		LinearAllocator frames[FRAME_COUNT];
+		unsigned long long frameOfSlot[FRAME_COUNT]; // Frame each allocator was last reset for
+		LinearAllocator scratch;
+	};
+
+	static thread_local ThreadArena* threadArena;
+	static std::mutex arenasLock; // Guards 'arenas' (registration, releaseScratch()), not the allocators themselves
+	static std::vector<ThreadArena*> arenas;
+	static std::atomic<unsigned long long> frameIndex;
+	static std::atomic<size_t> allocatedBytes; // Since the last beginFrame()
+	static std::atomic<size_t> reservedBytes;
+	static unsigned long long frameHeapAllocations, heapAllocationsAtFrameStart;
+	static size_t frameBytes;
+
+	static ThreadArena* getThreadArena();
+	static void* allocateFrom(LinearAllocator& allocator, size_t size, size_t align);
+};
+
+// STL allocator on top of the frame arena. deallocate() does nothing: the memory goes back with the frame.
+// Containers using it must not outlive FRAME_COUNT frames
+template <class T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() {};
+	template <class U> FrameAllocator(const FrameAllocator<U>&) {};
+
+	T* allocate(size_t count) { return (T*)FrameArena::allocate(count * sizeof(T), alignof(T) < 16 ? alignof(T) : 16); };
+	void deallocate(T*, size_t) {};
+
+	template <class U> bool operator==(const FrameAllocator<U>&) const { return true; };
+	template <class U> bool operator!=(const FrameAllocator<U>&) const { return false; };
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include <GLFW\glfw3.h>
+#include "FramePacer.h"
+
+static const double MIN_SPIN_MS = 0.2;
+static const double MAX_SPIN_MS = 4.0; // A sleep later than this is an outlier (scheduler hiccup), not the norm
+
+FramePacer::FramePacer() {
+	targetFps = 0.0;
+	swapInterval = 1;
+	timerPeriodSet = false;
+	started = false;
+	scheduled = false;
+	spinMs = 1.0;
+	waitedMs = 0.0;
+	// About a minute at 60 FPS. Past that the vector doubles, one allocation every few thousand frames
+	frameTimes.reserve(INITIAL_SAMPLES);
+}
+
+void FramePacer::setTargetFps(double fps) {
+	targetFps = fps > 0.0 ? fps : 0.0;
+	scheduled = false; // Start a new schedule from the next frame
+#ifdef _WIN32
+	// The default timer tick (15.6 ms) would make every sleep a whole frame late
+	if (targetFps > 0.0 && !timerPeriodSet) {
+		timerPeriodSet = timeBeginPeriod(1) == TIMERR_NOERROR;
+	}
+#endif
+}
+
+void FramePacer::setSwapInterval(int interval) {
+	swapInterval = interval < 0 ? 0 : interval;
+	// Headless on EGL has no GLFW context (and nothing to present)
+	if (glfwGetCurrentContext()) {
+		glfwSwapInterval(swapInterval);
+	}
+}
+
+void FramePacer::wait() {
+	if (targetFps <= 0.0) {
+		return;
+	}
+	Clock::time_point now = Clock::now();
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+	if (!scheduled) {
+		// First frame of the schedule: nothing to wait for yet
+		nextFrame = now + period;
+		scheduled = true;
+		return;
+	}
+
+	double remainingMs = std::chrono::duration<double, std::milli>(nextFrame - now).count();
+	if (remainingMs > spinMs) {
+		// Sleep up to the spin stretch, then measure how late the OS woke us
+		Clock::time_point sleepEnd = nextFrame - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(spinMs));
+		std::this_thread::sleep_until(sleepEnd);
+		double lateMs = std::chrono::duration<double, std::milli>(Clock::now() - sleepEnd).count();
+		if (lateMs > spinMs) {
+			spinMs = std::min(lateMs * 1.25, MAX_SPIN_MS);
+		}
+		else {
+			spinMs = std::max(spinMs * 0.99, MIN_SPIN_MS);
+		}
+	}
+	while (Clock::now() < nextFrame) {
+		std::this_thread::yield();
+	}
+	if (remainingMs > 0.0) {
+		waitedMs += remainingMs;
+	}
+
+	// Keep the cadence when slightly late, start over when a whole frame was missed (no burst to catch up)
+	nextFrame += period;
+	now = Clock::now();
+	if (nextFrame < now) {
+		nextFrame = now + period;
+	}
+}
+
+void FramePacer::endFrame() {
+	Clock::time_point now = Clock::now();
+	if (started && frameTimes.size() < MAX_SAMPLES) {
+		frameTimes.push_back((float)std::chrono::duration<double, std::milli>(now - lastFrameEnd).count());
+	}
+	lastFrameEnd = now;
+	started = true;
+}
+
+double FramePacer::getPercentile(double percent) {
+	if (frameTimes.empty()) {
+		return 0.0;
+	}
+	// Nearest rank: the smallest sample with at least 'percent' % of the samples at or below it
+	std::vector<float> sorted(frameTimes);
+	size_t rank = (size_t)ceil(percent / 100.0 * sorted.size());
+	size_t index = rank > 0 ? std::min(rank - 1, sorted.size() - 1) : 0;
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+	return sorted[index];
+}
+
+bool FramePacer::dumpCsv(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write frame times to '%s'\n", fileLocation);
+		return false;
+	}
+	fprintf(file, "frame,ms\n");
+	for (size_t i = 0; i < frameTimes.size(); i++) {
+		fprintf(file, "%zu,%.4f\n", i, frameTimes[i]);
+	}
+	fclose(file);
+	return true;
+}
+
+void FramePacer::clearStats() {
+	frameTimes.clear();
+	waitedMs = 0.0;
+	started = false;
+}
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+	if (timerPeriodSet) {
+		timeEndPeriod(1);
+	}
+#endif
+}
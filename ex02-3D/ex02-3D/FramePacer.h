@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+/*
+Frame rate limiter. After drawing, wait() holds the frame until its slot on a fixed schedule of 1 / targetFps
+seconds, then the buffers are swapped:
+
+	pacer.wait();
+	mainWindow.swapBuffer();
+	pacer.endFrame();
+
+The wait sleeps for most of the time (cheap, but the OS may wake us late) and spins for the last stretch
+(exact, but burns a core). The spin stretch adapts to how late the sleeps actually wake up.
+Frame times between endFrame() calls are kept for percentiles and a CSV dump
+*/
+class FramePacer
+{
+public:
+	FramePacer();
+
+	// 0 = unlimited
+	void setTargetFps(double fps);
+	double getTargetFps() { return targetFps; };
+	// Screen refreshes per swap: 0 = vsync off, 1 = every refresh, 2 = every other one... Needs the GL context current
+	void setSwapInterval(int interval);
+	int getSwapInterval() { return swapInterval; };
+
+	// Blocks until the next frame is due. Returns immediately when unlimited or late
+	void wait();
+	// Records the time since the previous endFrame() (call right after the swap)
+	void endFrame();
+
+	// Frame time (ms) below which 'percent' % of the recorded frames are. 0 when nothing was recorded
+	double getPercentile(double percent);
+	double getWaitedMs() { return waitedMs; }; // Total time spent in wait()
+	unsigned int getFrameCount() { return (unsigned int)frameTimes.size(); };
+	// One line per frame: index, frame time in ms. Returns false when the file cannot be written
+	bool dumpCsv(const char* fileLocation);
+	void clearStats();
+
+	~FramePacer();
+
+private:
+	static const size_t INITIAL_SAMPLES = 4096;
+	static const size_t MAX_SAMPLES = 1 << 20; // About 4.5 hours at 60 FPS (4 MB), recording stops afterwards
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double targetFps;
+	int swapInterval;
+	bool timerPeriodSet; // Windows timer resolution raised to 1 ms for the sleeps
+
+	Clock::time_point nextFrame; // Deadline of the frame being drawn
+	bool scheduled; // nextFrame is valid
+	Clock::time_point lastFrameEnd;
+	bool started; // lastFrameEnd is valid
+	double spinMs; // Stretch left to the spin, grows when sleeps overshoot and slowly shrinks back
+	double waitedMs;
+
+	std::vector<float> frameTimes;
+};
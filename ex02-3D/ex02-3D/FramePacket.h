@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+#include "SceneSystems.h"
+
+// Input as seen by the update thread. GLFW has to be polled on the main thread, so the main thread copies
+// the key states into one of these every frame. Mouse movement is cumulative so that no motion is lost
+// when the update thread skips a snapshot
+struct InputSnapshot
+{
+	bool keys[1024];
+	GLfloat mouseX, mouseY; // Total mouse movement since startup
+};
+
+// Everything the GL thread needs to draw one frame. Written by the update thread, then only read
+struct FramePacket
+{
+	unsigned long long frame; // Simulation frame that produced it
+	glm::mat4 view;
+	glm::vec3 cameraPosition;
+	std::vector<DrawItem> drawList; // Sorted by texture, material and mesh (see BuildDrawList)
+	SceneLights lights;
+	double updateMs; // CPU time the update took
+};
@@ -0,0 +1,40 @@
+#include "Frustum.h"
+
+Frustum::Frustum() {
+	for (int i = 0; i < 6; i++) {
+		planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Everything passes until the first update
+	}
+}
+
+void Frustum::update(const glm::mat4& viewProjection) {
+	// glm is column major: viewProjection[column][row]. Each plane is row 3 +/- row i (Gribb & Hartmann)
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = row3 + row0; // Left
+	planes[1] = row3 - row0; // Right
+	planes[2] = row3 + row1; // Bottom
+	planes[3] = row3 - row1; // Top
+	planes[4] = row3 + row2; // Near
+	planes[5] = row3 - row2; // Far
+
+	// Normalize so the plane distance can be compared against a radius
+	for (int i = 0; i < 6; i++) {
+		GLfloat len = glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+		planes[i] = planes[i] * (1.0f / len);
+	}
+}
+
+bool Frustum::isSphereVisible(const glm::vec3& center, GLfloat radius) {
+	for (int i = 0; i < 6; i++) {
+		GLfloat distance = planes[i].x * center.x + planes[i].y * center.y + planes[i].z * center.z + planes[i].w;
+		if (distance < -radius) {
+			return false; // Completely behind one of the planes
+		}
+	}
+	return true;
+}
+
+Frustum::~Frustum() {}
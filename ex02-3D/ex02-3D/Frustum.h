@@ -0,0 +1,21 @@
+#pragma once
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+// View frustum described by 6 planes (ax + by + cz + d = 0), normals pointing inwards
+class Frustum
+{
+public:
+	Frustum();
+	~Frustum();
+
+	// Extracts the planes straight from the combined (projection * view) matrix
+	void update(const glm::mat4& viewProjection);
+	bool isSphereVisible(const glm::vec3& center, GLfloat radius);
+
+	const glm::vec4* getPlanes() { return planes; };
+
+private:
+	glm::vec4 planes[6]; // Left, right, bottom, top, near, far
+};
+
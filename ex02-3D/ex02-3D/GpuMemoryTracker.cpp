@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include "GpuMemoryTracker.h"
+
+std::unordered_map<uint64_t, GpuMemoryTracker::TrackedObject> GpuMemoryTracker::objects;
+GpuMemoryTracker::CategoryStats GpuMemoryTracker::categories[GPU_MEMORY_CATEGORY_COUNT] = {};
+long long GpuMemoryTracker::totalLiveBytes = 0;
+long long GpuMemoryTracker::totalPeakBytes = 0;
+
+static uint64_t ObjectKey(GLenum type, GLuint name) {
+	return ((uint64_t)type << 32) | name;
+}
+
+static const char* TypeName(GLenum type) {
+	switch (type) {
+	case GL_BUFFER: return "buffer";
+	case GL_TEXTURE: return "texture";
+	case GL_RENDERBUFFER: return "renderbuffer";
+	case GL_FRAMEBUFFER: return "framebuffer";
+	case GL_PROGRAM: return "program";
+	case GL_VERTEX_ARRAY: return "vertex array";
+	default: return "object";
+	}
+}
+
+static double Megabytes(long long bytes) {
+	return bytes / (1024.0 * 1024.0);
+}
+
+const char* GpuMemoryTracker::getCategoryName(GpuMemoryCategory category) {
+	switch (category) {
+	case GPU_MEMORY_TEXTURE: return "textures";
+	case GPU_MEMORY_GEOMETRY: return "geometry";
+	case GPU_MEMORY_BUFFER: return "buffers";
+	case GPU_MEMORY_RENDER_TARGET: return "render targets";
+	case GPU_MEMORY_PROGRAM: return "programs";
+	default: return "unknown";
+	}
+}
+
+/********************************
+*	Tracking
+*********************************/
+void GpuMemoryTracker::trackObject(GLenum type, GLuint name, GpuMemoryCategory category, long long bytes, const char* debugName) {
+	if (name == 0) {
+		return;
+	}
+	// Replaces what was tracked for this object before (new buffer storage)
+	releaseObject(type, name);
+
+	TrackedObject object;
+	object.type = type;
+	object.name = name;
+	object.category = category;
+	object.bytes = bytes;
+	object.debugName = debugName ? debugName : "";
+	objects[ObjectKey(type, name)] = object;
+
+	CategoryStats& stats = categories[category];
+	stats.liveBytes += bytes;
+	stats.liveObjects++;
+	stats.peakBytes = std::max(stats.peakBytes, stats.liveBytes);
+	totalLiveBytes += bytes;
+	totalPeakBytes = std::max(totalPeakBytes, totalLiveBytes);
+
+	if (debugName && (GLEW_KHR_debug || GLEW_VERSION_4_3)) {
+		// Args: (object type, object name, length (-1: null terminated), label)
+		glObjectLabel(type, name, -1, debugName);
+	}
+}
+
+void GpuMemoryTracker::releaseObject(GLenum type, GLuint name) {
+	std::unordered_map<uint64_t, TrackedObject>::iterator object = objects.find(ObjectKey(type, name));
+	if (object == objects.end()) {
+		return;
+	}
+	CategoryStats& stats = categories[object->second.category];
+	stats.liveBytes -= object->second.bytes;
+	stats.liveObjects--;
+	totalLiveBytes -= object->second.bytes;
+	objects.erase(object);
+}
+
+/********************************
+*	Reports
+*********************************/
+void GpuMemoryTracker::printSummary() {
+	printf("GPU memory: %.2f MB live in %u objects, peak %.2f MB\n", Megabytes(totalLiveBytes), getTotalLiveObjects(), Megabytes(totalPeakBytes));
+	for (int i = 0; i < GPU_MEMORY_CATEGORY_COUNT; i++) {
+		const CategoryStats& stats = categories[i];
+		printf("  %-16s %10.2f MB live %10.2f MB peak %6u objects\n", getCategoryName((GpuMemoryCategory)i),
+			Megabytes(stats.liveBytes), Megabytes(stats.peakBytes), stats.liveObjects);
+	}
+}
+
+unsigned int GpuMemoryTracker::reportLeaks() {
+	if (objects.empty()) {
+		printf("GPU memory: no leaked objects\n");
+		return 0;
+	}
+	// Largest first
+	std::vector<const TrackedObject*> sorted;
+	for (std::unordered_map<uint64_t, TrackedObject>::iterator object = objects.begin(); object != objects.end(); object++) {
+		sorted.push_back(&object->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const TrackedObject* a, const TrackedObject* b) {
+		return a->bytes > b->bytes;
+	});
+
+	printf("GPU memory: %u objects leaked (%.2f MB)\n", (unsigned int)objects.size(), Megabytes(totalLiveBytes));
+	for (size_t i = 0; i < sorted.size(); i++) {
+		const TrackedObject& object = *sorted[i];
+		printf("  %-12s %5u %-14s %10lld bytes  '%s'\n", TypeName(object.type), object.name, getCategoryName(object.category),
+			object.bytes, object.debugName.c_str());
+	}
+	return (unsigned int)objects.size();
+}
+
+// Debug names are file paths and literals, only quotes and backslashes need escaping
+static void WriteJsonString(FILE* file, const char* text) {
+	fputc('"', file);
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool GpuMemoryTracker::writeJson(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write the GPU memory report to '%s'\n", fileLocation);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"liveBytes\": %lld,\n  \"peakBytes\": %lld,\n  \"liveObjects\": %u,\n  \"categories\": {\n",
+		totalLiveBytes, totalPeakBytes, getTotalLiveObjects());
+	for (int i = 0; i < GPU_MEMORY_CATEGORY_COUNT; i++) {
+		const CategoryStats& stats = categories[i];
+		fprintf(file, "    \"%s\": { \"liveBytes\": %lld, \"peakBytes\": %lld, \"liveObjects\": %u }%s\n",
+			getCategoryName((GpuMemoryCategory)i), stats.liveBytes, stats.peakBytes, stats.liveObjects, i + 1 < GPU_MEMORY_CATEGORY_COUNT ? "," : "");
+	}
+	fprintf(file, "  },\n  \"objects\": [");
+	bool first = true;
+	for (std::unordered_map<uint64_t, TrackedObject>::iterator object = objects.begin(); object != objects.end(); object++) {
+		fprintf(file, "%s\n    { \"type\": \"%s\", \"name\": %u, \"category\": \"%s\", \"bytes\": %lld, \"debugName\": ", first ? "" : ",",
+			TypeName(object->second.type), object->second.name, getCategoryName(object->second.category), object->second.bytes);
+		WriteJsonString(file, object->second.debugName.c_str());
+		fprintf(file, " }");
+		first = false;
+	}
+	fprintf(file, "%s]\n}\n", first ? "" : "\n  ");
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <GL\glew.h>
+
+// What an allocation is used for. Live bytes and peaks are kept per category
+enum GpuMemoryCategory
+{
+	GPU_MEMORY_TEXTURE, // Textures and texture arrays, mipmaps included
+	GPU_MEMORY_GEOMETRY, // Vertex and index buffers, vertex arrays
+	GPU_MEMORY_BUFFER, // Uniform, storage and indirect buffers
+	GPU_MEMORY_RENDER_TARGET, // Renderbuffers and framebuffers
+	GPU_MEMORY_PROGRAM, // Shader programs (the driver does not tell their size, they are only counted)
+	GPU_MEMORY_CATEGORY_COUNT
+};
+
+/*
+Every GL object the application creates, with its category, size and a debug name:
+
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+	GpuMemoryTracker::trackObject(GL_BUFFER, VBO, GPU_MEMORY_GEOMETRY, size, "Mesh VBO");
+	...
+	GpuMemoryTracker::releaseObject(GL_BUFFER, VBO);
+	glDeleteBuffers(1, &VBO);
+
+Objects are identified by their KHR_debug type (GL_BUFFER, GL_TEXTURE, GL_RENDERBUFFER, GL_FRAMEBUFFER, GL_PROGRAM,
+GL_VERTEX_ARRAY) and name, since every type has its own names. With KHR_debug the debug name also labels the object
+for RenderDoc, Nsight... Sizes are what was asked for, drivers add their own padding and alignment.
+Objects still tracked when the application is done with the GPU are reported as leaks. GL thread only
+*/
+class GpuMemoryTracker
+{
+public:
+	// Tracking an object again (glBufferData on the same buffer) replaces its size, category and name
+	static void trackObject(GLenum type, GLuint name, GpuMemoryCategory category, long long bytes, const char* debugName);
+	// Untracked objects (name 0, or never tracked) are ignored
+	static void releaseObject(GLenum type, GLuint name);
+
+	static long long getLiveBytes(GpuMemoryCategory category) { return categories[category].liveBytes; };
+	static long long getPeakBytes(GpuMemoryCategory category) { return categories[category].peakBytes; };
+	static unsigned int getLiveObjects(GpuMemoryCategory category) { return categories[category].liveObjects; };
+	static long long getTotalLiveBytes() { return totalLiveBytes; };
+	static long long getTotalPeakBytes() { return totalPeakBytes; }; // Highest total seen, not the sum of the category peaks
+	static unsigned int getTotalLiveObjects() { return (unsigned int)objects.size(); };
+	static const char* getCategoryName(GpuMemoryCategory category);
+
+	// Live and peak bytes per category
+	static void printSummary();
+	// Prints every object still tracked. Call once everything should have been released. Returns their count
+	static unsigned int reportLeaks();
+	// Totals, categories and every live object. Returns false when the file cannot be written
+	static bool writeJson(const char* fileLocation);
+
+private:
+	struct TrackedObject
+	{
+		GLenum type;
+		GLuint name;
+		GpuMemoryCategory category;
+		long long bytes;
+		std::string debugName;
+	};
+
+	struct CategoryStats
+	{
+		long long liveBytes, peakBytes;
+		unsigned int liveObjects;
+	};
+
+	static std::unordered_map<uint64_t, TrackedObject> objects; // Key: type << 32 | name
+	static CategoryStats categories[GPU_MEMORY_CATEGORY_COUNT];
+	static long long totalLiveBytes, totalPeakBytes;
+};
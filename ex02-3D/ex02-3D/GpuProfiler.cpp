@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include "GpuProfiler.h"
+
+static const unsigned int CALIBRATION_INTERVAL = 120; // Frames between two clock syncs (the clocks drift apart)
+
+bool GpuProfiler::initialized = false;
+bool GpuProfiler::debugGroups = false;
+GpuProfiler::FrameQueries GpuProfiler::frames[GpuProfiler::FRAME_LATENCY];
+unsigned int GpuProfiler::frameIndex = 0;
+int GpuProfiler::openZones[GpuProfiler::MAX_ZONES];
+unsigned int GpuProfiler::openCount = 0;
+int64_t GpuProfiler::gpuToCpuNs = 0;
+unsigned int GpuProfiler::droppedFrames = 0;
+ProfileThreadBuffer* GpuProfiler::track = NULL;
+
+void GpuProfiler::Initialize() {
+	if (initialized) {
+		return;
+	}
+	for (unsigned int i = 0; i < FRAME_LATENCY; i++) {
+		glGenQueries(MAX_ZONES * 2, frames[i].queries);
+		frames[i].zoneCount = 0;
+		frames[i].pending = false;
+	}
+	debugGroups = GLEW_KHR_debug || GLEW_VERSION_4_3;
+	if (!track) {
+		track = Profiler::createTrack("GPU");
+	}
+	frameIndex = 0;
+	openCount = 0;
+	initialized = true;
+	calibrate();
+}
+
+void GpuProfiler::Shutdown() {
+	if (!initialized) {
+		return;
+	}
+	// The last frames are still in the ring: wait for them once, so the trace has them too
+	glFinish();
+	for (unsigned int i = 0; i < FRAME_LATENCY; i++) {
+		FrameQueries& frame = frames[(frameIndex + i) % FRAME_LATENCY]; // Oldest first
+		if (frame.pending) {
+			resolve(frame);
+		}
+	}
+	for (unsigned int i = 0; i < FRAME_LATENCY; i++) {
+		glDeleteQueries(MAX_ZONES * 2, frames[i].queries);
+	}
+	initialized = false;
+}
+
+// Offset between the GPU clock and the profiler clock, read back to back
+void GpuProfiler::calibrate() {
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	gpuToCpuNs = (int64_t)Profiler::nowNs() - (int64_t)gpuNow;
+}
+
+/********************************
+*	Frames
+*********************************/
+void GpuProfiler::beginFrame() {
+	if (!initialized) {
+		return;
+	}
+	if (frameIndex % CALIBRATION_INTERVAL == 0) {
+		calibrate();
+	}
+	// This slot was used FRAME_LATENCY frames ago
+	FrameQueries& frame = frames[frameIndex % FRAME_LATENCY];
+	if (frame.pending) {
+		resolve(frame);
+	}
+	frame.zoneCount = 0;
+	frame.pending = true;
+	openCount = 0;
+	beginZone("GPU frame");
+}
+
+void GpuProfiler::endFrame() {
+	if (!initialized) {
+		return;
+	}
+	endZone(); // GPU frame
+	frameIndex++;
+}
+
+void GpuProfiler::beginZone(const char* name) {
+	if (!initialized) {
+		return;
+	}
+	if (debugGroups) {
+		// Args: (source, id, length (-1: null terminated), message)
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	}
+	FrameQueries& frame = frames[frameIndex % FRAME_LATENCY];
+	int zone = -1;
+	if (frame.zoneCount < MAX_ZONES) {
+		zone = (int)frame.zoneCount++;
+		frame.names[zone] = name;
+		frame.depths[zone] = openCount;
+		glQueryCounter(frame.queries[zone * 2], GL_TIMESTAMP);
+	}
+	if (openCount < MAX_ZONES) {
+		openZones[openCount] = zone;
+	}
+	openCount++;
+}
+
+void GpuProfiler::endZone() {
+	if (!initialized || openCount == 0) {
+		return;
+	}
+	openCount--;
+	int zone = openCount < MAX_ZONES ? openZones[openCount] : -1;
+	if (zone >= 0) {
+		glQueryCounter(frames[frameIndex % FRAME_LATENCY].queries[zone * 2 + 1], GL_TIMESTAMP);
+	}
+	if (debugGroups) {
+		glPopDebugGroup();
+	}
+}
+
+void GpuProfiler::resolve(FrameQueries& frame) {
+	frame.pending = false;
+	if (frame.zoneCount == 0) {
+		return;
+	}
+	// The frame's queries finish in order: when the last one is available, all of them are
+	GLuint available = 0;
+	glGetQueryObjectuiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available); // End of "GPU frame", issued last
+	if (!available) {
+		droppedFrames++; // The GPU is more than FRAME_LATENCY frames behind. Do not wait for it
+		return;
+	}
+	for (unsigned int zone = 0; zone < frame.zoneCount; zone++) {
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[zone * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.queries[zone * 2 + 1], GL_QUERY_RESULT, &end);
+		ProfileEvent event;
+		event.name = frame.names[zone];
+		event.startNs = (uint64_t)((int64_t)start + gpuToCpuNs);
+		event.endNs = end > start ? (uint64_t)((int64_t)end + gpuToCpuNs) : event.startNs;
+		event.depth = frame.depths[zone];
+		track->push(event);
+	}
+}
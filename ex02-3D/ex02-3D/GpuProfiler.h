@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <GL\glew.h>
+
+#include "Profiler.h"
+
+/*
+GPU time of render passes and draw groups:
+
+	GpuProfiler::beginFrame();
+	{
+		GPU_PROFILE_SCOPE("Scene");
+		...
+	}
+	GpuProfiler::endFrame();
+
+Each zone puts a GL_TIMESTAMP query before and after its commands (timestamps nest, GL_TIME_ELAPSED
+queries do not). Queries of a frame are read FRAME_LATENCY frames later, when the GPU is normally done with
+them, so nothing waits; a frame that is still not finished then is dropped rather than waited for.
+Results go to a "GPU" track of the CPU Profiler, on the same clock, so they show up under the CPU zones in
+the trace and in the per-zone table. With KHR_debug every zone is also a debug group (RenderDoc, Nsight...).
+
+Like the CPU zones, GPU_PROFILE_SCOPE compiles to nothing unless PROFILER_ENABLED is 1
+*/
+
+#if PROFILER_ENABLED
+#define GPU_PROFILE_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#else
+#define GPU_PROFILE_SCOPE(name)
+#endif
+
+class GpuProfiler
+{
+public:
+	// Needs the GL context. Without it every call is a no-op
+	static void Initialize();
+	static void Shutdown();
+
+	static void beginFrame(); // Also reads the results of FRAME_LATENCY frames ago
+	static void endFrame();
+	static void beginZone(const char* name);
+	static void endZone();
+
+	static unsigned int getDroppedFrames() { return droppedFrames; };
+
+private:
+	static const unsigned int FRAME_LATENCY = 4; // Frames in the query ring
+	static const unsigned int MAX_ZONES = 64; // Per frame, the rest is not timed
+
+	struct FrameQueries
+	{
+		GLuint queries[MAX_ZONES * 2]; // Start and end timestamp of every zone
+		const char* names[MAX_ZONES];
+		uint32_t depths[MAX_ZONES];
+		unsigned int zoneCount;
+		bool pending; // Issued and not read back yet
+	};
+
+	static bool initialized;
+	static bool debugGroups; // KHR_debug available
+	static FrameQueries frames[FRAME_LATENCY];
+	static unsigned int frameIndex;
+	static int openZones[MAX_ZONES]; // Stack of zone indices, -1 for zones past MAX_ZONES
+	static unsigned int openCount;
+	static int64_t gpuToCpuNs; // Added to a GPU timestamp to get Profiler::nowNs() time
+	static unsigned int droppedFrames;
+	static ProfileThreadBuffer* track;
+
+	static void calibrate();
+	static void resolve(FrameQueries& frame);
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(const char* name) { GpuProfiler::beginZone(name); };
+	~GpuProfileScope() { GpuProfiler::endZone(); };
+};
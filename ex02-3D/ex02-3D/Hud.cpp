@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include "Hud.h"
+#include "RenderStats.h"
+#include "Profiler.h"
+#include "GpuMemoryTracker.h"
+#include "FrameArena.h"
+
+static const double REFRESH_MS = 250.0;
+static const double GRAPH_MAX_MS = 1000.0 / 30.0; // Top of the graph, longer frames are clipped
+static const GLfloat SCALE = 1.0f; // Integer: the font has no filtering
+static const GLfloat MARGIN = 8.0f * SCALE, PADDING = 6.0f * SCALE;
+static const GLfloat LINE_HEIGHT = (TextRenderer::GLYPH_HEIGHT + 2) * SCALE;
+static const GLfloat GRAPH_HEIGHT = 40.0f * SCALE, GRAPH_BAR_WIDTH = 2.0f * SCALE;
+static const int PANEL_COLUMNS = 46; // Characters
+
+// 0xRRGGBBAA
+static const GLuint COLOR_PANEL = 0x000000B0;
+static const GLuint COLOR_TEXT = 0xFFFFFFFF;
+static const GLuint COLOR_DIM = 0xA0A0A0FF;
+static const GLuint COLOR_GOOD = 0x60E060FF;
+static const GLuint COLOR_SLOW = 0xE0C040FF;
+static const GLuint COLOR_BAD = 0xE05050FF;
+
+// Green up to 60 FPS, yellow up to 30 FPS, red below
+static GLuint FrameTimeColor(double frameMs) {
+	return frameMs <= 1000.0 / 58.0 ? COLOR_GOOD : frameMs <= 1000.0 / 29.0 ? COLOR_SLOW : COLOR_BAD;
+}
+
+Hud::Hud() {
+	initialized = false;
+	visible = false;
+	memset(frameTimes, 0, sizeof(frameTimes));
+	frameCursor = 0;
+	windowMs = 0.0;
+	windowMaxMs = 0.0;
+	windowFrames = 0;
+	memset(timerQueries, 0, sizeof(timerQueries));
+	memset(queryPending, 0, sizeof(queryPending));
+	queryFrame = 0;
+	cpuSumMs = 0.0;
+	gpuSumMs = 0.0;
+	shownCpuMs = 0.0;
+	shownGpuMs = 0.0;
+	cpuSamples = 0;
+	gpuSamples = 0;
+}
+
+bool Hud::Initialize(const char* vertexLocation, const char* fragmentLocation) {
+	if (!text.Initialize(vertexLocation, fragmentLocation)) {
+		return false;
+	}
+	glGenQueries(QUERY_LATENCY * 2, timerQueries);
+	initialized = true;
+	return true;
+}
+
+void Hud::setVisible(bool show) {
+	if (show && !visible) {
+		// Start a new refresh period, the numbers of the time it was hidden are stale
+		windowMs = 0.0;
+		windowMaxMs = 0.0;
+		windowFrames = 0;
+		lines.clear();
+	}
+	visible = show;
+}
+
+void Hud::addFrameTime(double frameMs) {
+	frameTimes[frameCursor] = frameMs;
+	frameCursor = (frameCursor + 1) % GRAPH_FRAMES;
+	windowMs += frameMs;
+	windowMaxMs = std::max(windowMaxMs, frameMs);
+	windowFrames++;
+}
+
+/********************************
+*	Text
+*********************************/
+void Hud::addLine(GLuint color, const char* format, ...) {
+	HudLine line;
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line.text, sizeof(line.text), format, args);
+	va_end(args);
+	line.color = color;
+	lines.push_back(line);
+}
+
+void Hud::refreshLines(const char* pathName) {
+	lines.clear();
+	double meanMs = windowFrames > 0 ? windowMs / windowFrames : 0.0;
+	addLine(FrameTimeColor(meanMs), "%.1f FPS  %.2f ms  (worst %.2f ms)", windowMs > 0.0 ? windowFrames * 1000.0 / windowMs : 0.0,
+		meanMs, windowMaxMs);
+	// The frame time graph goes here
+	addLine(COLOR_TEXT, "%s: %u draw calls, %u state changes", pathName, RenderStats::getDrawCalls(), RenderStats::getStateChanges());
+	addLine(COLOR_TEXT, "%u objects, %u triangles", RenderStats::getObjects(), RenderStats::getTriangles());
+	addLine(COLOR_TEXT, "%u uniform uploads, %u skipped (unchanged)", RenderStats::getUniformUploads(), RenderStats::getUniformsSkipped());
+	addLine(COLOR_TEXT, "GPU memory %.2f MB (peak %.2f MB)", GpuMemoryTracker::getTotalLiveBytes() / (1024.0 * 1024.0),
+		GpuMemoryTracker::getTotalPeakBytes() / (1024.0 * 1024.0));
+	addLine(COLOR_TEXT, "  textures %.2f  geometry %.2f  buffers %.2f", GpuMemoryTracker::getLiveBytes(GPU_MEMORY_TEXTURE) / (1024.0 * 1024.0),
+		GpuMemoryTracker::getLiveBytes(GPU_MEMORY_GEOMETRY) / (1024.0 * 1024.0), GpuMemoryTracker::getLiveBytes(GPU_MEMORY_BUFFER) / (1024.0 * 1024.0));
+	// Should be zero once everything reached its size
+	addLine(FrameArena::getFrameHeapAllocations() == 0 ? COLOR_TEXT : COLOR_SLOW, "%llu heap allocations, frame arena %.1f KB",
+		FrameArena::getFrameHeapAllocations(), FrameArena::getFrameBytes() / 1024.0);
+
+	// Most expensive zones of the last profiler summary
+	if (!Profiler::isCompiledIn()) {
+		addLine(COLOR_DIM, "Profiler zones compiled out");
+	}
+	else {
+		const std::vector<ProfileZoneStats>& zones = Profiler::getZoneSummary();
+		double frames = Profiler::getSummaryFrames() > 0 ? (double)Profiler::getSummaryFrames() : 1.0;
+		addLine(COLOR_DIM, "%-37s %8s", "Zone", "ms/frame");
+		for (size_t i = 0; i < zones.size() && i < MAX_ZONE_LINES; i++) {
+			int indent = (int)std::min(zones[i].depth, 4u) * 2;
+			addLine(COLOR_TEXT, "%*s%-*.*s %8.3f", indent, "", 37 - indent, 37 - indent, zones[i].name, zones[i].totalNs / 1e6 / frames);
+		}
+	}
+
+	shownCpuMs = cpuSamples > 0 ? cpuSumMs / cpuSamples : 0.0;
+	shownGpuMs = gpuSamples > 0 ? gpuSumMs / gpuSamples : 0.0;
+	addLine(COLOR_DIM, "HUD: %d quads, CPU %.3f ms, GPU %.3f ms", text.getQuadCount(), shownCpuMs, shownGpuMs);
+
+	windowMs = 0.0;
+	windowMaxMs = 0.0;
+	windowFrames = 0;
+	cpuSumMs = 0.0;
+	gpuSumMs = 0.0;
+	cpuSamples = 0;
+	gpuSamples = 0;
+}
+
+/********************************
+*	Drawing
+*********************************/
+// GPU time of the draw QUERY_LATENCY frames ago. Not waited for: a result that is not ready is skipped
+void Hud::readTimerQuery() {
+	unsigned int slot = queryFrame % QUERY_LATENCY;
+	if (!queryPending[slot]) {
+		return;
+	}
+	queryPending[slot] = false;
+	GLuint available = 0;
+	glGetQueryObjectuiv(timerQueries[slot * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available) {
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(timerQueries[slot * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(timerQueries[slot * 2 + 1], GL_QUERY_RESULT, &end);
+		gpuSumMs += end > start ? (end - start) / 1e6 : 0.0;
+		gpuSamples++;
+	}
+}
+
+void Hud::render(GLfloat width, GLfloat height, const char* pathName) {
+	if (!initialized || !visible) {
+		return;
+	}
+	uint64_t startNs = Profiler::nowNs();
+	readTimerQuery();
+	if (lines.empty() || windowMs >= REFRESH_MS) {
+		refreshLines(pathName);
+	}
+
+	text.begin();
+	GLfloat panelWidth = PANEL_COLUMNS * TextRenderer::GLYPH_WIDTH * SCALE + PADDING * 2.0f;
+	GLfloat panelHeight = lines.size() * LINE_HEIGHT + GRAPH_HEIGHT + PADDING * 3.0f;
+	text.addRect(MARGIN, MARGIN, panelWidth, panelHeight, COLOR_PANEL);
+
+	GLfloat x = MARGIN + PADDING, y = MARGIN + PADDING;
+	for (size_t i = 0; i < lines.size(); i++) {
+		text.addText(x, y, lines[i].text, lines[i].color, SCALE);
+		y += LINE_HEIGHT;
+		if (i == 0) {
+			/********************************
+			*	Frame time graph
+			*********************************/
+			// Oldest frame on the left, one bar per frame, lines at 60 and 30 FPS
+			GLfloat graphBottom = y + GRAPH_HEIGHT;
+			for (unsigned int frame = 0; frame < GRAPH_FRAMES; frame++) {
+				double frameMs = frameTimes[(frameCursor + frame) % GRAPH_FRAMES];
+				GLfloat barHeight = (GLfloat)(std::min(frameMs, GRAPH_MAX_MS) / GRAPH_MAX_MS) * GRAPH_HEIGHT;
+				if (barHeight > 0.0f) {
+					text.addRect(x + frame * GRAPH_BAR_WIDTH, graphBottom - barHeight, GRAPH_BAR_WIDTH, barHeight, FrameTimeColor(frameMs));
+				}
+			}
+			GLfloat graphWidth = GRAPH_FRAMES * GRAPH_BAR_WIDTH;
+			text.addRect(x, graphBottom - (GLfloat)(1000.0 / 60.0 / GRAPH_MAX_MS) * GRAPH_HEIGHT, graphWidth, SCALE, COLOR_DIM);
+			text.addRect(x, graphBottom - GRAPH_HEIGHT, graphWidth, SCALE, COLOR_DIM);
+			text.addText(x + graphWidth + PADDING, graphBottom - GRAPH_HEIGHT, "33 ms", COLOR_DIM, SCALE);
+			text.addText(x + graphWidth + PADDING, graphBottom - (GLfloat)(1000.0 / 60.0 / GRAPH_MAX_MS) * GRAPH_HEIGHT, "17 ms", COLOR_DIM, SCALE);
+			y = graphBottom + PADDING;
+		}
+	}
+
+	// One upload, one draw for everything above
+	unsigned int slot = queryFrame % QUERY_LATENCY;
+	glQueryCounter(timerQueries[slot * 2], GL_TIMESTAMP);
+	text.draw(width, height);
+	glQueryCounter(timerQueries[slot * 2 + 1], GL_TIMESTAMP);
+	queryPending[slot] = true;
+	queryFrame++;
+
+	cpuSumMs += (Profiler::nowNs() - startNs) / 1e6;
+	cpuSamples++;
+}
+
+void Hud::clearHud() {
+	if (initialized) {
+		glDeleteQueries(QUERY_LATENCY * 2, timerQueries);
+		text.clearTextRenderer();
+		initialized = false;
+	}
+}
+
+Hud::~Hud() {
+	clearHud();
+}
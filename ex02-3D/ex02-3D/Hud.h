@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+
+#include "TextRenderer.h"
+
+/*
+On-screen stats overlay (F3 or --hud): FPS and frame time graph, draw calls, state changes, triangles,
+GPU memory (GpuMemoryTracker), heap allocations of the frame (FrameArena), and the most expensive profiler zones.
+
+The whole overlay is one TextRenderer batch: one buffer upload and one draw per frame. Its own cost
+(CPU time of render() and GPU time of the draw, from GL_TIMESTAMP queries read QUERY_LATENCY frames later)
+is shown on its last line. It does not report to RenderStats, so the scene numbers are the same with it on or off
+*/
+class Hud
+{
+public:
+	Hud();
+	~Hud();
+
+	bool Initialize(const char* vertexLocation, const char* fragmentLocation);
+	void clearHud(); // Deletes the GL objects (also done by the destructor)
+
+	void setVisible(bool show);
+	bool isVisible() { return visible; };
+
+	// Once per drawn frame, also while hidden (the graph is full when it shows up)
+	void addFrameTime(double frameMs);
+	// Draws over the current framebuffer. 'pathName' labels the draw counts (active render path)
+	void render(GLfloat width, GLfloat height, const char* pathName);
+
+	double getCpuMs() { return shownCpuMs; }; // Average cost of the last refresh period
+	double getGpuMs() { return shownGpuMs; };
+
+private:
+	static const unsigned int GRAPH_FRAMES = 120;
+	static const unsigned int QUERY_LATENCY = 4;
+	static const unsigned int MAX_ZONE_LINES = 8;
+
+	struct HudLine
+	{
+		char text[64];
+		GLuint color;
+	};
+
+	TextRenderer text;
+	bool initialized, visible;
+
+	double frameTimes[GRAPH_FRAMES]; // Ring, frameCursor is the next slot
+	unsigned int frameCursor;
+
+	// The text is only rebuilt every REFRESH_MS, numbers changing every frame cannot be read
+	double windowMs, windowMaxMs;
+	unsigned int windowFrames;
+	std::vector<HudLine> lines;
+
+	// Cost of the HUD itself
+	GLuint timerQueries[QUERY_LATENCY * 2]; // Start and end timestamp of the draw, per frame in flight
+	bool queryPending[QUERY_LATENCY];
+	unsigned int queryFrame;
+	double cpuSumMs, gpuSumMs, shownCpuMs, shownGpuMs;
+	unsigned int cpuSamples, gpuSamples;
+
+	void readTimerQuery();
+	void refreshLines(const char* pathName);
+	void addLine(GLuint color, const char* format, ...);
+};
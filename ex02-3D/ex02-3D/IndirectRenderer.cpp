@@ -0,0 +1,276 @@
+#include "IndirectRenderer.h"
+#include "RenderStats.h"
+#include "GpuMemoryTracker.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+
+#include <glm\gtc\type_ptr.hpp>
+
+IndirectRenderer::IndirectRenderer() {
+	uniformFrustumPlanes = NO_UNIFORM;
+	uniformObjectCount = NO_UNIFORM;
+	gpuCulling = false;
+	VAO = 0;
+	VBO = 0;
+	IBO = 0;
+	drawIdBuffer = 0;
+	objectBuffer = 0;
+	commandBuffer = 0;
+	objectCapacity = 0;
+}
+
+bool IndirectRenderer::isSupported() {
+	return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_storage_buffer_object);
+}
+
+bool IndirectRenderer::Initialize(const char* vertexLocation, const char* fragmentLocation, const char* cullLocation) {
+	if (!isSupported()) {
+		printf("Indirect rendering not supported by this context (needs GL 4.3)\n");
+		return false;
+	}
+
+	drawShader.CreateFromFile(vertexLocation, fragmentLocation);
+	if (cullLocation && (GLEW_VERSION_4_3 || GLEW_ARB_compute_shader)) {
+		cullShader.CreateComputeFromFile(cullLocation);
+		updateCullUniforms();
+	}
+
+	glGenBuffers(1, &objectBuffer);
+	glGenBuffers(1, &commandBuffer);
+	glGenBuffers(1, &drawIdBuffer);
+	return true;
+}
+
+void IndirectRenderer::updateCullUniforms() {
+	uniformFrustumPlanes = cullShader.getUniform("frustumPlanes", GL_FLOAT_VEC4);
+	uniformObjectCount = cullShader.getUniform("objectCount", GL_UNSIGNED_INT);
+}
+
+GLuint IndirectRenderer::addMesh(GLfloat* vertices, unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices) {
+	MeshInfo info;
+	info.firstIndex = (GLuint)indexData.size();
+	info.indexCount = numOfIndices;
+	info.baseVertex = (GLint)(vertexData.size() / 8); // 8 floats per vertex
+
+	// Bounding sphere: center of the AABB, radius to the farthest vertex
+	glm::vec3 minPos(vertices[0], vertices[1], vertices[2]);
+	glm::vec3 maxPos = minPos;
+	for (unsigned int i = 0; i < numOfVertices; i += 8) {
+		glm::vec3 pos(vertices[i], vertices[i + 1], vertices[i + 2]);
+		minPos = glm::min(minPos, pos);
+		maxPos = glm::max(maxPos, pos);
+	}
+	glm::vec3 center = (minPos + maxPos) * 0.5f;
+	GLfloat radius = 0.0f;
+	for (unsigned int i = 0; i < numOfVertices; i += 8) {
+		radius = glm::max(radius, glm::length(glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]) - center));
+	}
+	info.boundingSphere = glm::vec4(center, radius);
+
+	vertexData.insert(vertexData.end(), vertices, vertices + numOfVertices);
+	indexData.insert(indexData.end(), indices, indices + numOfIndices); // Indices stay local, baseVertex offsets them
+	meshes.push_back(info);
+	return (GLuint)meshes.size() - 1;
+}
+
+void IndirectRenderer::uploadMeshes() {
+	glGenVertexArrays(1, &VAO);
+	glBindVertexArray(VAO);
+	GpuMemoryTracker::trackObject(GL_VERTEX_ARRAY, VAO, GPU_MEMORY_GEOMETRY, 0, "Indirect VAO");
+
+		glGenBuffers(1, &IBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indexData.size(), indexData.data(), GL_STATIC_DRAW);
+		GpuMemoryTracker::trackObject(GL_BUFFER, IBO, GPU_MEMORY_GEOMETRY, sizeof(unsigned int) * indexData.size(), "Indirect shared IBO");
+
+			glGenBuffers(1, &VBO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
+			GpuMemoryTracker::trackObject(GL_BUFFER, VBO, GPU_MEMORY_GEOMETRY, sizeof(GLfloat) * vertexData.size(), "Indirect shared VBO");
+
+				// Same attribute layout as Mesh::CreateMesh
+				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 8, 0);
+				glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 8, (void*)(sizeof(GLfloat) * 3));
+				glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 8, (void*)(sizeof(GLfloat) * 5));
+				glEnableVertexAttribArray(0);
+				glEnableVertexAttribArray(1);
+				glEnableVertexAttribArray(2);
+
+			// Object index: a per-instance attribute holding 0, 1, 2... Since the attribute divisor is 1, the value
+			// fetched for a draw is the one at 'baseInstance', which gives the shader its object index without GL 4.6 gl_DrawID
+			glBindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+				glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), 0);
+				glVertexAttribDivisor(3, 1);
+				glEnableVertexAttribArray(3);
+
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	reserveObjects(64);
+}
+
+void IndirectRenderer::reserveObjects(GLsizeiptr count) {
+	if (count <= objectCapacity) {
+		return;
+	}
+	while (objectCapacity < count) {
+		objectCapacity = objectCapacity ? objectCapacity * 2 : 64;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ObjectData) * objectCapacity, NULL, GL_DYNAMIC_DRAW);
+	GpuMemoryTracker::trackObject(GL_BUFFER, objectBuffer, GPU_MEMORY_BUFFER, sizeof(ObjectData) * objectCapacity, "Indirect objects SSBO");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * objectCapacity, NULL, GL_DYNAMIC_DRAW);
+	GpuMemoryTracker::trackObject(GL_BUFFER, commandBuffer, GPU_MEMORY_BUFFER, sizeof(DrawElementsIndirectCommand) * objectCapacity, "Indirect commands");
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	std::vector<GLuint> drawIds(objectCapacity);
+	for (GLsizeiptr i = 0; i < objectCapacity; i++) {
+		drawIds[i] = (GLuint)i;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint) * objectCapacity, drawIds.data(), GL_STATIC_DRAW);
+	GpuMemoryTracker::trackObject(GL_BUFFER, drawIdBuffer, GPU_MEMORY_GEOMETRY, sizeof(GLuint) * objectCapacity, "Indirect draw IDs");
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void IndirectRenderer::beginFrame() {
+	objects.clear();
+	commands.clear();
+}
+
+void IndirectRenderer::addObject(GLuint meshID, const glm::mat4& model, const Material& material, GLint textureLayer) {
+	ObjectData object;
+	object.model = model;
+	object.boundingSphere = meshes[meshID].boundingSphere;
+	object.specularIntensity = material.getSpecularIntensity();
+	object.shininess = material.getShininess();
+	object.textureLayer = textureLayer;
+	object.meshID = meshID;
+	objects.push_back(object);
+}
+
+void IndirectRenderer::render(const glm::mat4& projection, const glm::mat4& view) {
+	if (objects.empty()) {
+		return;
+	}
+	reserveObjects((GLsizeiptr)objects.size());
+	frustum.update(projection * view);
+
+	// One command per object. The object index travels through baseInstance.
+	// Objects are independent, so the commands (and the CPU culling) are filled in parallel
+	commands.resize(objects.size());
+	JobSystem::parallelFor("Build draw commands", objects.size(), CULL_GRAIN, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const MeshInfo& mesh = meshes[objects[i].meshID];
+			DrawElementsIndirectCommand& command = commands[i];
+			command.count = mesh.indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = mesh.firstIndex;
+			command.baseVertex = mesh.baseVertex;
+			command.baseInstance = (GLuint)i;
+
+			if (!gpuCulling) {
+				// CPU culling: bounding sphere in world space against the frustum
+				const glm::mat4& model = objects[i].model;
+				glm::vec4 center = model * glm::vec4(glm::vec3(mesh.boundingSphere.x, mesh.boundingSphere.y, mesh.boundingSphere.z), 1.0f);
+				GLfloat scale = glm::max(glm::length(glm::vec3(model[0].x, model[0].y, model[0].z)),
+								glm::max(glm::length(glm::vec3(model[1].x, model[1].y, model[1].z)), glm::length(glm::vec3(model[2].x, model[2].y, model[2].z))));
+				if (!frustum.isSphereVisible(glm::vec3(center.x, center.y, center.z), mesh.boundingSphere.w * scale)) {
+					command.instanceCount = 0;
+				}
+			}
+		}
+	});
+	GLsizei indexTotal = 0;
+	for (size_t i = 0; i < commands.size(); i++) {
+		if (commands[i].instanceCount) {
+			indexTotal += commands[i].count;
+		}
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ObjectData) * objects.size(), objects.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+
+	if (gpuCulling) {
+		GPU_PROFILE_SCOPE("Culling");
+		// The compute shader only writes instanceCount (0 or 1), everything else was filled above
+		cullShader.UseProgram();
+		cullShader.setUniform(uniformFrustumPlanes, frustum.getPlanes(), 6);
+		cullShader.setUniform(uniformObjectCount, (GLuint)objects.size());
+		glDispatchCompute(((GLuint)objects.size() + 63) / 64, 1, 1); // 64 threads per group (see CullShader.glsl)
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+		// The visible triangle count is only known on the GPU, report the upper bound
+		indexTotal = 0;
+		for (size_t i = 0; i < commands.size(); i++) {
+			indexTotal += commands[i].count;
+		}
+	}
+
+	drawShader.UseProgram();
+	drawShader.setProjection(projection);
+	drawShader.setView(view);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	RenderStats::addStateChange(3); // Program, VAO and indirect buffer
+		// Args: (primitive, index type, offset in the indirect buffer, draw count, stride (0: tightly packed))
+		GPU_PROFILE_SCOPE("Indirect draws");
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)commands.size(), 0);
+		RenderStats::addMultiDraw((GLsizei)commands.size(), indexTotal);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void IndirectRenderer::clearRenderer() {
+	if (VAO != 0) {
+		GpuMemoryTracker::releaseObject(GL_VERTEX_ARRAY, VAO);
+		glDeleteVertexArrays(1, &VAO);
+		VAO = 0;
+	}
+	if (VBO != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, VBO);
+		glDeleteBuffers(1, &VBO);
+		VBO = 0;
+	}
+	if (IBO != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, IBO);
+		glDeleteBuffers(1, &IBO);
+		IBO = 0;
+	}
+	if (drawIdBuffer != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, drawIdBuffer);
+		glDeleteBuffers(1, &drawIdBuffer);
+		drawIdBuffer = 0;
+	}
+	if (objectBuffer != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, objectBuffer);
+		glDeleteBuffers(1, &objectBuffer);
+		objectBuffer = 0;
+	}
+	if (commandBuffer != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, commandBuffer);
+		glDeleteBuffers(1, &commandBuffer);
+		commandBuffer = 0;
+	}
+	objectCapacity = 0;
+	drawShader.ClearShader();
+	cullShader.ClearShader();
+}
+
+IndirectRenderer::~IndirectRenderer() {
+	clearRenderer();
+}
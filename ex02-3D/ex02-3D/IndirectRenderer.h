@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+#include "Material.h"
+#include "Shader.h"
+#include "Frustum.h"
+
+// Layout read by glMultiDrawElementsIndirect. The order of the fields is fixed by the GL spec
+struct DrawElementsIndirectCommand
+{
+	GLuint count; // Index count
+	GLuint instanceCount; // 0 culls the draw, 1 renders it
+	GLuint firstIndex; // Offset (in indices) inside the shared IBO
+	GLint baseVertex; // Offset (in vertices) inside the shared VBO
+	GLuint baseInstance; // Used as the object index in the shaders
+};
+
+// Per-object data stored in the object SSBO (std430 layout, 96 bytes)
+struct ObjectData
+{
+	glm::mat4 model;
+	glm::vec4 boundingSphere; // xyz: center in object space, w: radius
+	GLfloat specularIntensity;
+	GLfloat shininess;
+	GLint textureLayer;
+	GLuint meshID;
+};
+
+/*
+GPU-driven submission path: every mesh lives in one VAO (shared VBO/IBO), the per-object data lives in an SSBO
+and one DrawElementsIndirectCommand is written per object. The whole scene is then submitted with a single
+glMultiDrawElementsIndirect call. Needs GL 4.3 (or ARB_multi_draw_indirect + ARB_shader_storage_buffer_object)
+*/
+class IndirectRenderer
+{
+public:
+	IndirectRenderer();
+	~IndirectRenderer();
+	void clearRenderer(); // Deletes the GL buffers (also done by the destructor)
+
+	static bool isSupported();
+
+	// Args: (draw shaders, culling compute shader or NULL to always build the commands on the CPU)
+	bool Initialize(const char* vertexLocation, const char* fragmentLocation, const char* cullLocation);
+
+	// Same vertex layout as Mesh::CreateMesh (x, y, z, u, v, nx, ny, nz). Returns the mesh ID
+	GLuint addMesh(GLfloat* vertices, unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices);
+	void uploadMeshes(); // Call once after the last addMesh
+
+	void beginFrame();
+	void addObject(GLuint meshID, const glm::mat4& model, const Material& material, GLint textureLayer);
+	// Fills the command buffer (CPU or compute culling) and draws everything with one call
+	void render(const glm::mat4& projection, const glm::mat4& view);
+
+	void setGpuCulling(bool enabled) { gpuCulling = enabled && cullShader.getShaderID() != 0; };
+	bool getGpuCulling() { return gpuCulling; };
+	Shader* getShader() { return &drawShader; };
+	Shader* getCullShader() { return &cullShader; };
+	// Finds the uniforms of the culling shader again (after a hot reload replaced its program)
+	void updateCullUniforms();
+
+private:
+	static const size_t CULL_GRAIN = 1024; // Objects per job when building the commands
+
+	struct MeshInfo
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+		glm::vec4 boundingSphere;
+	};
+
+	Shader drawShader, cullShader;
+	UniformHandle uniformFrustumPlanes, uniformObjectCount;
+	bool gpuCulling;
+
+	// Shared geometry
+	GLuint VAO, VBO, IBO, drawIdBuffer;
+	std::vector<GLfloat> vertexData;
+	std::vector<unsigned int> indexData;
+	std::vector<MeshInfo> meshes;
+
+	// Per-frame data
+	GLuint objectBuffer, commandBuffer;
+	GLsizeiptr objectCapacity; // Number of objects the GPU buffers can hold
+	std::vector<ObjectData> objects;
+	std::vector<DrawElementsIndirectCommand> commands;
+	Frustum frustum;
+
+	void reserveObjects(GLsizeiptr count);
+};
+
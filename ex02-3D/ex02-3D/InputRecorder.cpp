@@ -0,0 +1,144 @@
+#include <string.h>
+#include "InputRecorder.h"
+
+static const char INPUT_MAGIC[4] = { 'I', 'N', 'P', 'T' };
+static const uint32_t INPUT_VERSION = 2; // 2: INPUT_FRAME events
+
+static_assert(sizeof(InputEvent) == 20, "InputEvent is written to disk as is");
+
+/********************************
+*	Recording
+*********************************/
+InputRecorder::InputRecorder() {
+	file = NULL;
+	eventCount = 0;
+}
+
+bool InputRecorder::startRecording(const char* fileLocation) {
+	if (file) {
+		fclose(file);
+	}
+	file = fopen(fileLocation, "wb");
+	if (!file) {
+		printf("Failed to open '%s' to record input\n", fileLocation);
+		return false;
+	}
+	fwrite(INPUT_MAGIC, 1, sizeof(INPUT_MAGIC), file);
+	fwrite(&INPUT_VERSION, sizeof(INPUT_VERSION), 1, file);
+	eventCount = 0;
+	return true;
+}
+
+void InputRecorder::recordKey(uint32_t frame, float time, int key, int action) {
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.frame = frame;
+	event.time = time;
+	event.type = INPUT_KEY;
+	event.action = (uint8_t)action;
+	event.key = (uint16_t)key;
+	write(event);
+}
+
+void InputRecorder::recordCursor(uint32_t frame, float time, double x, double y) {
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.frame = frame;
+	event.time = time;
+	event.type = INPUT_CURSOR;
+	event.x = (float)x;
+	event.y = (float)y;
+	write(event);
+}
+
+void InputRecorder::recordFrame(uint32_t frame, float time, double frameSeconds, double stepRate) {
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.frame = frame;
+	event.time = time;
+	event.type = INPUT_FRAME;
+	event.x = (float)frameSeconds;
+	event.y = (float)stepRate;
+	write(event);
+}
+
+void InputRecorder::stopRecording(uint32_t frame, float time) {
+	if (!file) {
+		return;
+	}
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.frame = frame;
+	event.time = time;
+	event.type = INPUT_END;
+	write(event);
+	fclose(file);
+	file = NULL;
+}
+
+void InputRecorder::write(const InputEvent& event) {
+	if (!file) {
+		return;
+	}
+	// Buffered by stdio, the callbacks never wait for the disk
+	fwrite(&event, sizeof(event), 1, file);
+	eventCount++;
+}
+
+InputRecorder::~InputRecorder() {
+	if (file) {
+		fclose(file); // Stopped without an end marker: replay simply runs out of events
+	}
+}
+
+/********************************
+*	Replay
+*********************************/
+InputReplay::InputReplay() {
+	next = 0;
+}
+
+bool InputReplay::loadReplay(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "rb");
+	if (!file) {
+		printf("Failed to read input log '%s'\n", fileLocation);
+		return false;
+	}
+	char magic[4];
+	uint32_t version = 0;
+	if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, INPUT_MAGIC, sizeof(magic)) != 0 ||
+		fread(&version, sizeof(version), 1, file) != 1 || version < 1 || version > INPUT_VERSION) {
+		printf("'%s' is not an input log (version 1 to %u expected)\n", fileLocation, INPUT_VERSION);
+		fclose(file);
+		return false;
+	}
+
+	events.clear();
+	next = 0;
+	InputEvent event;
+	while (fread(&event, sizeof(event), 1, file) == 1) {
+		events.push_back(event);
+	}
+	fclose(file);
+	return true;
+}
+
+bool InputReplay::nextEvent(uint32_t frame, InputEvent& event) {
+	if (next >= events.size() || events[next].frame > frame) {
+		return false;
+	}
+	event = events[next++];
+	return true;
+}
+
+double InputReplay::getStepRate() {
+	for (size_t i = 0; i < events.size(); i++) {
+		if (events[i].type == INPUT_FRAME) {
+			return events[i].y;
+		}
+	}
+	return 0.0;
+}
+
+InputReplay::~InputReplay() {
+}
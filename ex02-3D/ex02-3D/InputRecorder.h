@@ -0,0 +1,79 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+Input sessions saved to disk and played back. The Window hands every key and cursor event to the recorder;
+during a replay the Window takes its events from the log instead of GLFW, through the same code path.
+
+Events are stamped with the frame they arrived in (the Window::pollEvents call) and the time in seconds.
+Every frame also records the time it simulated and the simulation step rate (INPUT_FRAME). Replay goes by frame
+and simulates each frame for its recorded time, so the same input meets the same fixed steps whatever the frame
+rate of the replay: the whole run is reproducible, with --benchmark too. Version 1 logs and --threaded sessions
+(the update thread steps on its own) have no frame times: their frames simulate the replay's own frame time, one
+fixed step each under --benchmark
+
+File: "INPT", version (uint32), then one 20 byte InputEvent after another (little endian)
+*/
+
+enum InputEventType
+{
+	INPUT_KEY,
+	INPUT_CURSOR,
+	INPUT_END, // Session closed. Replay asks the window to close
+	INPUT_FRAME // After the events of the frame: x is the time it simulated (seconds), y the step rate (Hz)
+};
+
+struct InputEvent
+{
+	uint32_t frame;
+	float time;
+	uint8_t type; // InputEventType
+	uint8_t action; // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+	uint16_t key;
+	float x, y; // Cursor position (INPUT_FRAME: frame time and step rate)
+};
+
+class InputRecorder
+{
+public:
+	InputRecorder();
+
+	bool startRecording(const char* fileLocation);
+	void recordKey(uint32_t frame, float time, int key, int action);
+	void recordCursor(uint32_t frame, float time, double x, double y);
+	void recordFrame(uint32_t frame, float time, double frameSeconds, double stepRate);
+	// Writes the end marker and closes the file
+	void stopRecording(uint32_t frame, float time);
+	bool isRecording() { return file != NULL; };
+	unsigned int getEventCount() { return eventCount; };
+
+	~InputRecorder();
+
+private:
+	FILE* file;
+	unsigned int eventCount;
+
+	void write(const InputEvent& event);
+};
+
+class InputReplay
+{
+public:
+	InputReplay();
+
+	bool loadReplay(const char* fileLocation);
+	// Next event recorded on or before 'frame'. Returns false when there is none for this frame (yet)
+	bool nextEvent(uint32_t frame, InputEvent& event);
+	bool isFinished() { return next >= events.size(); };
+	// Step rate of the recorded simulation, 0 when the log does not have it (version 1)
+	double getStepRate();
+	unsigned int getEventCount() { return (unsigned int)events.size(); };
+
+	~InputReplay();
+
+private:
+	std::vector<InputEvent> events;
+	size_t next;
+};
@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+JobCounter::JobCounter() {
+	value = 0;
+}
+
+/********************************
+*	Chase-Lev deque
+*********************************/
+// Fixed-size ring of job pointers. Only the owner calls push/pop (bottom end), any thread may steal (top end).
+// When it is full the owner runs the job itself instead of growing the ring
+class JobSystem::JobQueue
+{
+public:
+	JobQueue() {
+		top = 0;
+		bottom = 0;
+		for (int64_t i = 0; i < CAPACITY; i++) {
+			buffer[i] = NULL;
+		}
+	}
+
+	bool push(Job* job) {
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		if (b - t >= CAPACITY) {
+			return false;
+		}
+		buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // The job is visible before the new bottom
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job* pop() {
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // Thieves must see the reserved slot before we read top
+		int64_t t = top.load(std::memory_order_relaxed);
+		if (t > b) {
+			bottom.store(b + 1, std::memory_order_relaxed); // Empty
+			return NULL;
+		}
+		Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (t == b) {
+			// Last job: race the thieves for it
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = NULL;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* steal() {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b) {
+			return NULL;
+		}
+		Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return NULL; // Lost against the owner or another thief
+		}
+		return job;
+	}
+
+private:
+	static const int64_t CAPACITY = 4096; // Power of two
+	std::atomic<Job*> buffer[CAPACITY];
+	std::atomic<int64_t> top;
+	std::atomic<int64_t> bottom;
+};
+
+/********************************
+*	Scheduler state
+*********************************/
+std::vector<JobSystem::JobQueue*> JobSystem::queues;
+std::vector<std::thread> JobSystem::workers;
+std::atomic<bool> JobSystem::running(false);
+std::atomic<int> JobSystem::pendingJobs(0);
+std::mutex JobSystem::sleepLock;
+std::condition_variable JobSystem::wakeUp;
+std::mutex JobSystem::externalLock;
+std::vector<Job*> JobSystem::externalJobs;
+std::atomic<int> JobSystem::externalCount(0);
+JobTraceCallback JobSystem::traceCallback = NULL;
+std::mutex JobSystem::poolLock;
+std::vector<Job*> JobSystem::freeJobs;
+
+static thread_local int currentWorker = -1; // Index of this thread's deque, -1 for threads the system does not own
+static std::chrono::high_resolution_clock::time_point startTime;
+
+static double TraceTime() {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+void JobSystem::Initialize(int workerCount, bool pinThreads) {
+	if (!queues.empty()) {
+		Shutdown();
+	}
+	if (workerCount < 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? (int)cores - 1 : 0;
+	}
+	if (workerCount == 0) {
+		return; // Inline mode
+	}
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i <= workerCount; i++) {
+		queues.push_back(new JobQueue());
+	}
+	currentWorker = 0; // The calling (main) thread owns deque 0
+	if (pinThreads) {
+		pinCurrentThread(0);
+	}
+	running = true;
+	for (int i = 1; i <= workerCount; i++) {
+		workers.push_back(std::thread(workerLoop, i, pinThreads));
+	}
+}
+
+void JobSystem::Shutdown() {
+	if (queues.empty()) {
+		return;
+	}
+	running = false;
+	wakeUp.notify_all();
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	workers.clear();
+	for (size_t i = 0; i < queues.size(); i++) {
+		delete queues[i];
+	}
+	queues.clear();
+	currentWorker = -1;
+}
+
+void JobSystem::pinCurrentThread(int core) {
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0) {
+		return;
+	}
+	core = core % cores;
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+/********************************
+*	Scheduling
+*********************************/
+Job* JobSystem::acquireJob() {
+	std::lock_guard<std::mutex> lock(poolLock);
+	if (freeJobs.empty()) {
+		// Never freed: a job may still wait on a counter when the system shuts down
+		Job* block = new Job[POOL_BLOCK];
+		freeJobs.reserve(freeJobs.capacity() + POOL_BLOCK);
+		for (size_t i = 0; i < POOL_BLOCK; i++) {
+			freeJobs.push_back(&block[i]);
+		}
+	}
+	Job* job = freeJobs.back();
+	freeJobs.pop_back();
+	job->pooled = true;
+	return job;
+}
+
+void JobSystem::releaseJob(Job* job) {
+	std::lock_guard<std::mutex> lock(poolLock);
+	freeJobs.push_back(job); // Never reallocates: the capacity covers every job of the pool
+}
+
+void JobSystem::submit(Job* job, JobCounter* counter, JobCounter* dependency) {
+	job->counter = counter;
+	if (counter) {
+		counter->value++;
+	}
+
+	if (dependency) {
+		std::lock_guard<std::mutex> lock(dependency->waitingLock);
+		if (dependency->value.load() > 0) {
+			dependency->waiting.push_back(job); // Scheduled by the job that brings the dependency to zero
+			return;
+		}
+	}
+	schedule(job);
+}
+
+void JobSystem::schedule(Job* job) {
+	if (currentWorker >= 0) {
+		if (!queues[currentWorker]->push(job)) {
+			execute(job, currentWorker); // Deque full
+			return;
+		}
+	}
+	else {
+		std::lock_guard<std::mutex> lock(externalLock);
+		externalJobs.push_back(job);
+		externalCount++;
+	}
+	pendingJobs++;
+	wakeUp.notify_one();
+}
+
+Job* JobSystem::findJob(int worker) {
+	Job* job = NULL;
+	if (worker >= 0) {
+		job = queues[worker]->pop();
+	}
+	if (!job && externalCount.load() > 0) {
+		std::lock_guard<std::mutex> lock(externalLock);
+		if (!externalJobs.empty()) {
+			job = externalJobs.back();
+			externalJobs.pop_back();
+			externalCount--;
+		}
+	}
+	if (!job) {
+		// Steal, starting after ourselves so thieves do not all hit the same victim
+		size_t queueCount = queues.size();
+		size_t first = worker >= 0 ? (size_t)worker + 1 : 0;
+		for (size_t i = 0; i < queueCount && !job; i++) {
+			size_t victim = (first + i) % queueCount;
+			if ((int)victim != worker) {
+				job = queues[victim]->steal();
+			}
+		}
+	}
+	if (job) {
+		pendingJobs--;
+	}
+	return job;
+}
+
+void JobSystem::execute(Job* job, int worker) {
+	double start = traceCallback ? TraceTime() : 0.0;
+	{
+		PROFILE_SCOPE(job->name);
+		job->range(job->context, job->begin, job->end);
+	}
+	if (traceCallback) {
+		traceCallback(job->name, worker < 0 ? (unsigned int)queues.size() : (unsigned int)worker, start, TraceTime());
+	}
+
+	// A job on the stack of a parallelFor is gone as soon as the counter drops: nothing reads it after this
+	JobCounter* counter = job->counter;
+	if (job->pooled) {
+		if (job->destroy) {
+			job->destroy(job->context);
+		}
+		releaseJob(job);
+	}
+	if (!counter) {
+		return;
+	}
+	std::vector<Job*> released;
+	{
+		// Decrement under the lock: a waiter may destroy the counter as soon as it reads zero
+		std::lock_guard<std::mutex> lock(counter->waitingLock);
+		if (--counter->value == 0) {
+			released.swap(counter->waiting);
+		}
+	}
+	for (size_t i = 0; i < released.size(); i++) {
+		schedule(released[i]);
+	}
+}
+
+void JobSystem::Wait(JobCounter* counter) {
+	if (!counter) {
+		return;
+	}
+	while (!counter->isDone()) {
+		Job* job = queues.empty() ? NULL : findJob(currentWorker);
+		if (job) {
+			execute(job, currentWorker);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	// The job that released the counter may still hold its lock
+	std::lock_guard<std::mutex> lock(counter->waitingLock);
+}
+
+void JobSystem::parallelForRanges(const char* name, size_t count, size_t grainSize, JobRangeFunction function, const void* context) {
+	if (grainSize == 0) {
+		grainSize = 1;
+	}
+	if (queues.empty() || count <= grainSize) {
+		if (count > 0) {
+			function(context, 0, count);
+		}
+		return;
+	}
+
+	// Wait() below returns only once every range ran, so the jobs can live in this stack frame
+	Job stackJobs[STACK_RANGES];
+	JobCounter counter;
+	size_t lastBegin = ((count - 1) / grainSize) * grainSize;
+	size_t range = 0;
+	for (size_t begin = 0; begin < lastBegin; begin += grainSize, range++) {
+		Job* job = range < STACK_RANGES ? &stackJobs[range] : acquireJob();
+		job->name = name;
+		job->range = function;
+		job->context = context;
+		job->destroy = NULL;
+		job->begin = begin;
+		job->end = begin + grainSize;
+		job->pooled = range >= STACK_RANGES;
+		job->counter = &counter;
+		counter.value++;
+		schedule(job);
+	}
+	function(context, lastBegin, count); // The caller takes the last range instead of idling
+	Wait(&counter);
+}
+
+void JobSystem::workerLoop(int worker, bool pin) {
+	currentWorker = worker;
+	if (pin) {
+		pinCurrentThread(worker);
+	}
+#if PROFILER_ENABLED
+	char threadName[32];
+	snprintf(threadName, sizeof(threadName), "Worker %d", worker);
+	PROFILE_THREAD(threadName);
+#endif
+	while (running) {
+		Job* job = findJob(worker);
+		if (job) {
+			execute(job, worker);
+			continue;
+		}
+		// Nothing to do: sleep until a push. The timeout covers a notify that lands between the check and the wait
+		std::unique_lock<std::mutex> lock(sleepLock);
+		wakeUp.wait_for(lock, std::chrono::milliseconds(1), []() { return pendingJobs.load() > 0 || !running; });
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <new>
+#include <stddef.h>
+
+/*
+Work-stealing job scheduler. Every worker thread (and the main thread, which counts as worker 0) owns a
+Chase-Lev deque: the owner pushes and pops at the bottom, idle workers steal from the top of someone else's.
+
+	JobCounter counter;
+	JobSystem::Run("Decode brick", [&]() { brick.decodeTexture(); }, &counter);
+	JobSystem::Run("Decode dirt", [&]() { dirt.decodeTexture(); }, &counter);
+	JobSystem::Wait(&counter); // Runs other jobs while waiting instead of blocking
+
+A job can also depend on a counter: it is only scheduled once that counter drops to zero.
+Without Initialize() (or with 0 workers) every job simply runs inline on the calling thread.
+
+Jobs come from a pool that only grows, and the function object is copied into the job when it fits
+(JOB_INLINE_BYTES: a lambda capturing a few pointers or values), so dispatching does not allocate once the pool
+has warmed up
+*/
+
+struct Job;
+
+// Number of unfinished jobs attached to it. Wait() returns once it reaches zero
+class JobCounter
+{
+public:
+	JobCounter();
+
+	bool isDone() { return value.load() == 0; };
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int> value;
+	std::mutex waitingLock; // Guards 'waiting' against the decrement that releases it
+	std::vector<Job*> waiting; // Jobs that depend on this counter
+};
+
+// Runs items [begin, end) of a parallelFor. 'context' is the function object given to parallelFor
+typedef void(*JobRangeFunction)(const void* context, size_t begin, size_t end);
+
+static const size_t JOB_INLINE_BYTES = 64; // Function objects up to this size live in the job, larger ones are allocated
+
+struct Job
+{
+	const char* name;
+	JobRangeFunction range; // Runs the job: items [begin, end) of a parallelFor, or the function object of Run()
+	const void* context;
+	void(*destroy)(const void* context); // Destroys the function object of Run() (NULL for a parallelFor range)
+	size_t begin, end;
+	bool pooled; // Returned to the pool once it ran. parallelFor jobs are mostly on the caller's stack
+	JobCounter* counter;
+	alignas(16) unsigned char storage[JOB_INLINE_BYTES];
+};
+
+// Called after every job with the worker index and the start/end times in ms since Initialize()
+typedef void(*JobTraceCallback)(const char* name, unsigned int worker, double startMs, double endMs);
+
+class JobSystem
+{
+public:
+	// Args: (worker threads besides the main thread, -1 = one per remaining core; pin each thread to its own core)
+	static void Initialize(int workerCount = -1, bool pinThreads = false);
+	static void Shutdown();
+
+	// Args: (name shown by the trace hook, work (function object called with no arguments, copied), counter to
+	// signal or NULL, counter to wait for or NULL)
+	template <class Function>
+	static void Run(const char* name, const Function& function, JobCounter* counter = NULL, JobCounter* dependency = NULL) {
+		if (queues.empty()) {
+			// Inline mode: every earlier job already ran, so the dependency is always met
+			function();
+			return;
+		}
+		Job* job = acquireJob();
+		job->name = name;
+		job->range = &callFunction<Function>;
+		if (sizeof(Function) <= JOB_INLINE_BYTES && alignof(Function) <= 16) {
+			job->context = new (job->storage) Function(function);
+			job->destroy = &destroyFunction<Function>;
+		}
+		else {
+			job->context = new Function(function);
+			job->destroy = &deleteFunction<Function>;
+		}
+		submit(job, counter, dependency);
+	};
+	static void Wait(JobCounter* counter);
+
+	// Splits [0, count) into ranges of 'grainSize' items and waits for all of them. func(begin, end).
+	// 'func' is not copied and the range jobs live on the caller's stack, so a frame can call it without allocating
+	template <class Function>
+	static void parallelFor(const char* name, size_t count, size_t grainSize, const Function& func) {
+		parallelForRanges(name, count, grainSize, &callRange<Function>, &func);
+	};
+
+	// Threads taking part, main thread included (1 when running inline)
+	static unsigned int getThreadCount() { return (unsigned int)queues.size() > 0 ? (unsigned int)queues.size() : 1; };
+	static void setTraceCallback(JobTraceCallback callback) { traceCallback = callback; };
+
+private:
+	class JobQueue; // Chase-Lev deque
+
+	static const size_t STACK_RANGES = 32; // parallelFor ranges beyond this many come from the pool
+
+	static std::vector<JobQueue*> queues; // One per thread, index 0 belongs to the main thread
+	static std::vector<std::thread> workers;
+	static std::atomic<bool> running;
+	static std::atomic<int> pendingJobs; // Jobs pushed and not yet started (lets idle workers sleep)
+	static std::mutex sleepLock;
+	static std::condition_variable wakeUp;
+	static std::mutex externalLock; // Jobs pushed from threads without a deque (the update thread, for instance)
+	static std::vector<Job*> externalJobs;
+	static std::atomic<int> externalCount; // externalJobs.size(), readable without the lock
+	static JobTraceCallback traceCallback;
+	static std::mutex poolLock;
+	static std::vector<Job*> freeJobs; // Jobs of the pool not in use. The pool is kept until exit
+	static const size_t POOL_BLOCK = 64; // Jobs added at once when the pool is empty
+
+	static Job* acquireJob(); // From the pool, 'pooled' set
+	static void releaseJob(Job* job);
+	static void submit(Job* job, JobCounter* counter, JobCounter* dependency);
+
+	static void schedule(Job* job);
+	static Job* findJob(int worker);
+	static void execute(Job* job, int worker);
+	static void workerLoop(int worker, bool pin);
+	static void pinCurrentThread(int core);
+
+	template <class Function>
+	static void callRange(const void* context, size_t begin, size_t end) { (*(const Function*)context)(begin, end); };
+	template <class Function>
+	static void callFunction(const void* context, size_t, size_t) { (*(Function*)const_cast<void*>(context))(); };
+	template <class Function>
+	static void destroyFunction(const void* context) { ((const Function*)context)->~Function(); };
+	template <class Function>
+	static void deleteFunction(const void* context) { delete (const Function*)context; };
+	static void parallelForRanges(const char* name, size_t count, size_t grainSize, JobRangeFunction function, const void* context);
+};
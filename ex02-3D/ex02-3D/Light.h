@@ -8,6 +8,9 @@ public:
 	Light();
 	Light(GLfloat red, GLfloat green, GLfloat blue, GLfloat aIntensity, GLfloat dIntensity);
 	~Light();
+	glm::vec3 getColor() const { return color; };
+	GLfloat getAmbientIntensity() const { return ambientIntensity; };
+	GLfloat getDiffuseIntensity() const { return diffuseIntensity; };
 
 protected:
 	// Ambient
@@ -0,0 +1,63 @@
+#include "LinearAllocator.h"
+
+LinearAllocator::LinearAllocator() {
+	blockSize = 64 * 1024;
+	currentBlock = 0;
+	offset = 0;
+	usedBytes = 0;
+	reservedBytes = 0;
+}
+
+LinearAllocator::LinearAllocator(size_t size) {
+	blockSize = size;
+	currentBlock = 0;
+	offset = 0;
+	usedBytes = 0;
+	reservedBytes = 0;
+}
+
+void* LinearAllocator::allocate(size_t size, size_t align) {
+	while (true) {
+		if (currentBlock < blocks.size()) {
+			Block& block = blocks[currentBlock];
+			size_t start = (offset + align - 1) & ~(align - 1);
+			if (start + size <= block.size) {
+				offset = start + size;
+				usedBytes += size;
+				return block.data + start;
+			}
+			// Does not fit: move on to the next block (already allocated or new)
+			currentBlock++;
+			offset = 0;
+			if (currentBlock < blocks.size()) {
+				continue;
+			}
+		}
+		Block block;
+		block.size = size + align > blockSize ? size + align : blockSize;
+		block.data = new unsigned char[block.size]; // operator new: counted by GetHeapAllocationCount()
+		blocks.push_back(block);
+		reservedBytes += block.size;
+		currentBlock = blocks.size() - 1;
+		offset = 0;
+	}
+}
+
+void LinearAllocator::reset() {
+	currentBlock = 0;
+	offset = 0;
+	usedBytes = 0; // The blocks are kept, and still counted as reserved
+}
+
+void LinearAllocator::release() {
+	for (size_t i = 0; i < blocks.size(); i++) {
+		delete[] blocks[i].data;
+	}
+	blocks.clear();
+	reset();
+	reservedBytes = 0;
+}
+
+LinearAllocator::~LinearAllocator() {
+	release();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+
+/*
+Bump allocator for per-frame data. allocate() only moves a pointer forward; reset() releases everything at once.
+Memory comes in blocks that are kept between frames, so after the first frames nothing is allocated anymore.
+Not thread-safe: give every thread its own
+*/
+class LinearAllocator
+{
+public:
+	LinearAllocator();
+	LinearAllocator(size_t blockSize);
+	~LinearAllocator();
+
+	// Returns 'size' bytes aligned to 'align' (a power of two, up to 16). Never NULL, a new block is added when needed
+	void* allocate(size_t size, size_t align);
+	void reset(); // Rewinds to the first block. Every pointer handed out becomes invalid
+	void release(); // reset() and frees the blocks
+
+	void setBlockSize(size_t size) { blockSize = size; }; // For the blocks added from now on
+	size_t getUsedBytes() { return usedBytes; };
+	size_t getReservedBytes() { return reservedBytes; }; // Total size of the blocks
+
+private:
+	struct Block
+	{
+		unsigned char* data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t blockSize;
+	size_t currentBlock; // Block being filled
+	size_t offset; // Next free byte in the current block
+	size_t usedBytes;
+	size_t reservedBytes;
+};
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile() {
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	fileHandle = NULL;
+	mappingHandle = NULL;
+#endif
+}
+
+bool MappedFile::open(const char* fileLocation, bool sequential) {
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileLocation, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		printf("Failed to open '%s'\n", fileLocation);
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!view) {
+		printf("Failed to map '%s'\n", fileLocation);
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int file = ::open(fileLocation, O_RDONLY);
+	if (file < 0) {
+		printf("Failed to open '%s'\n", fileLocation);
+		return false;
+	}
+	struct stat status;
+	void* view = fstat(file, &status) == 0 && status.st_size > 0 ? mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+	::close(file); // The mapping keeps the file
+	if (view == MAP_FAILED) {
+		printf("Failed to map '%s'\n", fileLocation);
+		return false;
+	}
+	size = (size_t)status.st_size;
+	if (sequential) {
+		// Start reading ahead instead of faulting page by page
+		madvise(view, size, MADV_WILLNEED);
+	}
+#endif
+	data = (const unsigned char*)view;
+	return true;
+}
+
+void MappedFile::close() {
+	if (data) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+		fileHandle = NULL;
+		mappingHandle = NULL;
+#else
+		munmap((void*)data, size);
+#endif
+	}
+	data = NULL;
+	size = 0;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file. The pages are read by the OS when they are first touched,
+// nothing is copied into the process
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// 'sequential' hints the OS to read ahead (the whole file is about to be used once)
+	bool open(const char* fileLocation, bool sequential);
+	void close(); // Unmaps it (also done by the destructor)
+
+	const unsigned char* getData() { return data; };
+	size_t getSize() { return size; };
+
+private:
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
@@ -7,6 +7,8 @@ public:
 	Material();
 	Material(GLfloat sIntensity, GLfloat shine);
 	void useMaterial(GLuint specularIntensityLocation, GLuint shininessLocation);
+	GLfloat getSpecularIntensity() const { return specularIntensity; };
+	GLfloat getShininess() const { return shininess; };
 	~Material();
 
 private:
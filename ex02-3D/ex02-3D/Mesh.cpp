@@ -1,4 +1,6 @@
 #include "Mesh.h"
+#include "RenderStats.h"
+#include "GpuMemoryTracker.h"
 
 Mesh::Mesh() {
 	VAO = 0;
@@ -13,18 +15,21 @@ void Mesh::CreateMesh(GLfloat* vertices, unsigned int* indices, unsigned int num
 	// VAO (Vertex Array Object), stored in RAM. Coordinates VBO buffering.
 	glGenVertexArrays(1, &VAO); // Generates a VAO ID
 	glBindVertexArray(VAO); // Binds ID to VAO
+	GpuMemoryTracker::trackObject(GL_VERTEX_ARRAY, VAO, GPU_MEMORY_GEOMETRY, 0, "Mesh VAO");
 
 		// Loads index data into GPU memory
 		// IBO (Index Buffer Object), stored in GPU memory
 		glGenBuffers(1, &IBO); // Generates an IBO ID
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO); // Binds ID to IBO. IBO is automatically linked to its VAO
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * numOfIndices, indices, GL_STATIC_DRAW); // Assigning the index values to the IBO
+		GpuMemoryTracker::trackObject(GL_BUFFER, IBO, GPU_MEMORY_GEOMETRY, sizeof(indices[0]) * numOfIndices, "Mesh IBO");
 
 			// Loads vertex data into GPU memory
 			// VBO (Vertex Buffer Object), stored in GPU memory
 			glGenBuffers(1, &VBO); // Generates a VBO ID
 			glBindBuffer(GL_ARRAY_BUFFER, VBO); // Binds ID to VBO. VBO is automatically linked to its VAO
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices[0]) * numOfVertices, vertices, GL_STATIC_DRAW); // Assigning the vertex values to the VBO
+			GpuMemoryTracker::trackObject(GL_BUFFER, VBO, GPU_MEMORY_GEOMETRY, sizeof(vertices[0]) * numOfVertices, "Mesh VBO");
 					// GL_STATIC_DRAW: used for fixed vertex (allocation of slower GPU memory)
 					// GL_DYNAMIC_DRAW: used for dynamic vertex (allocation of faster GPU memory)
 					// GL_STREAM_DRAW: vertex shows up a single frame
@@ -55,18 +60,22 @@ void Mesh::RenderMesh() {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO); // Binds ID to IBO.
 			// Args: (primitive, index count (points to be connected), index type, end)
 			glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+			RenderStats::addDrawCall(indexCount);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // Reset IBO pointer for the next object to be processed
 	glBindVertexArray(0); // Reset VAO pointer for the next object to be processed
 }
 
 Mesh::~Mesh() {
 	if (VAO != 0) {
-		glDeleteBuffers(1, &VAO);
+		GpuMemoryTracker::releaseObject(GL_VERTEX_ARRAY, VAO);
+		glDeleteVertexArrays(1, &VAO); // A VAO is not a buffer
 	}
 	if (VBO != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, VBO);
 		glDeleteBuffers(1, &VBO);
 	}
 	if (IBO != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, IBO);
 		glDeleteBuffers(1, &IBO);
 	}
 	indexCount = 0;
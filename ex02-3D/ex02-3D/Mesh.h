@@ -1,6 +1,15 @@
 #pragma once
 #include <GL\glew.h>
 
+// Interleaved vertices (x, y, z, u, v, nx, ny, nz) and indices of a mesh, in place (arrays of the caller,
+// an imported mesh or a mapped asset pack)
+struct MeshData
+{
+	GLfloat* vertices;
+	unsigned int* indices;
+	unsigned int vertexCount, indexCount; // In floats and indices
+};
+
 class Mesh
 {
 public:
@@ -10,6 +19,10 @@ public:
 	void CreateMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices); 
 	void RenderMesh();
 
+	GLuint getVAO() { return VAO; };
+	GLuint getIBO() { return IBO; };
+	GLsizei getIndexCount() { return indexCount; };
+
 private:
 	GLuint VAO, VBO, IBO;
 	GLsizei indexCount;
@@ -0,0 +1,722 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "MeshUtils.h"
+#include "JobSystem.h"
+
+static const size_t OBJ_CHUNK_SIZE = 1024 * 1024; // Bytes of text per parse job
+static const size_t INTERLEAVE_GRAIN = 16384; // Vertices per interleave job
+// Negative (relative) OBJ indices are kept as their position in the chunk minus this, until the chunks are merged
+static const int RELATIVE_INDEX = 1 << 30;
+static const unsigned int NO_INDEX = UINT_MAX;
+
+bool MeshImporter::importMesh(const char* fileLocation, ImportedMesh& mesh) {
+	const char* extension = strrchr(fileLocation, '.');
+	if (extension && (strcmp(extension, ".obj") == 0 || strcmp(extension, ".OBJ") == 0)) {
+		return importObj(fileLocation, mesh);
+	}
+	if (extension && (strcmp(extension, ".glb") == 0 || strcmp(extension, ".GLB") == 0)) {
+		return importGlb(fileLocation, mesh);
+	}
+	printf("Unknown mesh format: '%s' (.obj or .glb)\n", fileLocation);
+	return false;
+}
+
+// Normals computed from the triangles, flipped like the imported ones
+static void ComputeNormals(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int floatCount) {
+	for (unsigned int i = 0; i < floatCount; i += 8) {
+		vertices[i + 5] = vertices[i + 6] = vertices[i + 7] = 0.0f;
+	}
+	CalcAverageNormal(indices, indexCount, vertices, floatCount, 8, 5);
+	for (unsigned int i = 0; i < floatCount; i += 8) {
+		vertices[i + 5] = -vertices[i + 5];
+		vertices[i + 6] = -vertices[i + 6];
+		vertices[i + 7] = -vertices[i + 7];
+	}
+}
+
+/********************************
+*	Number parsing
+*********************************/
+static inline bool IsBlank(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipBlanks(const char* cursor, const char* end) {
+	while (cursor < end && IsBlank(*cursor)) {
+		cursor++;
+	}
+	return cursor;
+}
+
+static inline bool IsDigit(char c) {
+	return (unsigned char)(c - '0') < 10;
+}
+
+// Exact in a double
+static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Decimal number ("-1.25", "3e-4") at 'cursor'. Returns the end of it, or 'cursor' when there is no number.
+// The digits go into an integer and one scaling by a power of ten at the end: no locale, no errno. Integers
+// below 2^53 are exact, fractions are within a rounding or two (far below float precision, which is all meshes keep)
+static const char* ParseNumber(const char* cursor, const char* end, double& value) {
+	const char* start = cursor;
+	bool negative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+		negative = *cursor == '-';
+		cursor++;
+	}
+	uint64_t mantissa = 0;
+	int exponent = 0, digits = 0;
+	bool anyDigit = false;
+	while (cursor < end && IsDigit(*cursor)) {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*cursor - '0');
+			digits += mantissa != 0 ? 1 : 0; // Leading zeros do not count
+		}
+		else {
+			exponent++;
+		}
+		anyDigit = true;
+		cursor++;
+	}
+	if (cursor < end && *cursor == '.') {
+		cursor++;
+		while (cursor < end && IsDigit(*cursor)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*cursor - '0');
+				digits += mantissa != 0 ? 1 : 0;
+				exponent--;
+			}
+			anyDigit = true;
+			cursor++;
+		}
+	}
+	if (!anyDigit) {
+		return start;
+	}
+	if (cursor + 1 < end && (*cursor == 'e' || *cursor == 'E')) {
+		const char* exponentStart = cursor++;
+		bool negativeExponent = false;
+		if (*cursor == '-' || *cursor == '+') {
+			negativeExponent = *cursor == '-';
+			cursor++;
+		}
+		if (cursor < end && IsDigit(*cursor)) {
+			int written = 0;
+			while (cursor < end && IsDigit(*cursor)) {
+				written = written < 10000 ? written * 10 + (*cursor - '0') : written;
+				cursor++;
+			}
+			exponent += negativeExponent ? -written : written;
+		}
+		else {
+			cursor = exponentStart; // An 'e' that is not an exponent
+		}
+	}
+
+	double result = (double)mantissa;
+	if (exponent < 0) {
+		result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent] : result * pow(10.0, exponent);
+	}
+	else if (exponent > 0) {
+		result = exponent <= 22 ? result * POWERS_OF_TEN[exponent] : result * pow(10.0, exponent);
+	}
+	value = negative ? -result : result;
+	return cursor;
+}
+
+static inline const char* ParseFloat(const char* cursor, const char* end, GLfloat& value) {
+	double number;
+	const char* next = ParseNumber(cursor, end, number);
+	value = (GLfloat)number;
+	return next;
+}
+
+// 'count' blank-separated floats. False when fewer than 'required' were found (the rest is left at 0)
+static bool ParseFloats(const char* cursor, const char* end, GLfloat* values, int count, int required) {
+	for (int i = 0; i < count; i++) {
+		values[i] = 0.0f;
+	}
+	for (int i = 0; i < count; i++) {
+		cursor = SkipBlanks(cursor, end);
+		const char* next = ParseFloat(cursor, end, values[i]);
+		if (next == cursor) {
+			return i >= required;
+		}
+		cursor = next;
+	}
+	return true;
+}
+
+/********************************
+*	Wavefront OBJ
+*********************************/
+// What one chunk of text produced
+struct ObjChunk
+{
+	const char* begin;
+	const char* end;
+	std::vector<GLfloat> positions, texcoords, normals; // 3, 2 and 3 floats per element
+	// v, vt, vn of each triangle corner. 0: absent, > 0: 1-based index in the file, < 0: relative (RELATIVE_INDEX)
+	std::vector<int> corners;
+	unsigned int malformedLines;
+	size_t positionBase, texcoordBase, normalBase, cornerBase; // Where the chunk lands once merged
+	bool badIndex;
+};
+
+// One face index ("12", "-1"). 'localCount' is how many elements of that kind the chunk parsed so far
+static const char* ParseObjIndex(const char* cursor, const char* end, int localCount, int& index) {
+	const char* start = cursor;
+	bool negative = cursor < end && *cursor == '-';
+	cursor += negative ? 1 : 0;
+	int value = 0;
+	while (cursor < end && IsDigit(*cursor)) {
+		value = value * 10 + (*cursor - '0');
+		cursor++;
+	}
+	if (value == 0) {
+		return start; // No digits, or 0 (OBJ indices start at 1)
+	}
+	index = negative ? localCount - value - RELATIVE_INDEX : value;
+	return cursor;
+}
+
+static void ParseObjChunk(ObjChunk& chunk) {
+	std::vector<int> polygon; // v, vt, vn of each corner of the current face
+	const char* cursor = chunk.begin;
+	while (cursor < chunk.end) {
+		const char* lineEnd = (const char*)memchr(cursor, '\n', chunk.end - cursor);
+		lineEnd = lineEnd ? lineEnd : chunk.end;
+		cursor = SkipBlanks(cursor, lineEnd);
+
+		if (lineEnd - cursor >= 2 && cursor[0] == 'v' && IsBlank(cursor[1])) {
+			GLfloat position[3];
+			chunk.malformedLines += ParseFloats(cursor + 1, lineEnd, position, 3, 3) ? 0 : 1;
+			chunk.positions.insert(chunk.positions.end(), position, position + 3);
+		}
+		else if (lineEnd - cursor >= 3 && cursor[0] == 'v' && cursor[1] == 't' && IsBlank(cursor[2])) {
+			GLfloat texcoord[2];
+			chunk.malformedLines += ParseFloats(cursor + 2, lineEnd, texcoord, 2, 1) ? 0 : 1;
+			chunk.texcoords.push_back(texcoord[0]);
+			chunk.texcoords.push_back(1.0f - texcoord[1]); // OBJ has the origin at the bottom left
+		}
+		else if (lineEnd - cursor >= 3 && cursor[0] == 'v' && cursor[1] == 'n' && IsBlank(cursor[2])) {
+			GLfloat normal[3];
+			chunk.malformedLines += ParseFloats(cursor + 2, lineEnd, normal, 3, 3) ? 0 : 1;
+			chunk.normals.insert(chunk.normals.end(), normal, normal + 3);
+		}
+		else if (lineEnd - cursor >= 2 && cursor[0] == 'f' && IsBlank(cursor[1])) {
+			// Corners "v", "v/vt", "v//vn" or "v/vt/vn"
+			polygon.clear();
+			bool valid = true;
+			cursor = SkipBlanks(cursor + 1, lineEnd);
+			while (cursor < lineEnd && *cursor != '#' && valid) {
+				int corner[3] = { 0, 0, 0 };
+				const char* next = ParseObjIndex(cursor, lineEnd, (int)(chunk.positions.size() / 3), corner[0]);
+				valid = next != cursor;
+				cursor = next;
+				if (valid && cursor < lineEnd && *cursor == '/') {
+					cursor++;
+					if (cursor < lineEnd && *cursor != '/') {
+						next = ParseObjIndex(cursor, lineEnd, (int)(chunk.texcoords.size() / 2), corner[1]);
+						valid = next != cursor;
+						cursor = next;
+					}
+					if (valid && cursor < lineEnd && *cursor == '/') {
+						cursor++;
+						next = ParseObjIndex(cursor, lineEnd, (int)(chunk.normals.size() / 3), corner[2]);
+						valid = next != cursor;
+						cursor = next;
+					}
+				}
+				valid = valid && (cursor == lineEnd || IsBlank(*cursor));
+				polygon.insert(polygon.end(), corner, corner + 3);
+				cursor = SkipBlanks(cursor, lineEnd);
+			}
+			if (!valid || polygon.size() < 9) {
+				chunk.malformedLines++;
+			}
+			else {
+				// Triangle fan around the first corner
+				for (size_t i = 1; i + 1 < polygon.size() / 3; i++) {
+					chunk.corners.insert(chunk.corners.end(), &polygon[0], &polygon[0] + 3);
+					chunk.corners.insert(chunk.corners.end(), &polygon[i * 3], &polygon[i * 3] + 6);
+				}
+			}
+		}
+		// Anything else (comments, groups, objects, materials, smoothing) is skipped
+		cursor = lineEnd + 1;
+	}
+}
+
+// 0-based index in the merged arrays, NO_INDEX when absent. Sets 'bad' when out of range
+static inline unsigned int ResolveObjIndex(int index, size_t chunkBase, size_t total, bool& bad) {
+	if (index == 0) {
+		return NO_INDEX;
+	}
+	long long resolved = index > 0 ? (long long)index - 1 : (long long)chunkBase + index + RELATIVE_INDEX;
+	if (resolved < 0 || resolved >= (long long)total) {
+		bad = true;
+		return 0;
+	}
+	return (unsigned int)resolved;
+}
+
+static inline uint32_t HashCorner(const unsigned int* corner) {
+	uint32_t hash = corner[0] * 0x9E3779B1u + corner[1] * 0x85EBCA77u + corner[2] * 0xC2B2AE3Du;
+	return hash ^ (hash >> 15);
+}
+
+bool MeshImporter::importObj(const char* fileLocation, ImportedMesh& mesh) {
+	MappedFile file;
+	if (!file.open(fileLocation, true)) {
+		return false;
+	}
+	const char* text = (const char*)file.getData();
+	size_t size = file.getSize();
+
+	// Chunks of about OBJ_CHUNK_SIZE, each ending after a newline (the last one at the end of the file)
+	std::vector<ObjChunk> chunks((size + OBJ_CHUNK_SIZE - 1) / OBJ_CHUNK_SIZE);
+	const char* fileEnd = text + size;
+	const char* chunkStart = text;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		const char* chunkEnd = fileEnd;
+		if (i + 1 < chunks.size()) {
+			const char* split = text + (i + 1) * OBJ_CHUNK_SIZE;
+			const char* newline = split > chunkStart ? (const char*)memchr(split - 1, '\n', fileEnd - split + 1) : NULL;
+			// Empty when the previous chunk ended past this split (a line longer than a chunk)
+			chunkEnd = split <= chunkStart ? chunkStart : newline ? newline + 1 : fileEnd;
+		}
+		chunks[i].begin = chunkStart;
+		chunks[i].end = chunkEnd;
+		chunks[i].malformedLines = 0;
+		chunks[i].badIndex = false;
+		chunkStart = chunkEnd;
+	}
+	JobSystem::parallelFor("Parse OBJ", chunks.size(), 1, [&chunks](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ParseObjChunk(chunks[i]);
+		}
+	});
+
+	// Merge: every chunk copies its elements and resolves its corners at its offset
+	size_t positionCount = 0, texcoordCount = 0, normalCount = 0, cornerCount = 0;
+	unsigned int malformedLines = 0;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		chunks[i].positionBase = positionCount;
+		chunks[i].texcoordBase = texcoordCount;
+		chunks[i].normalBase = normalCount;
+		chunks[i].cornerBase = cornerCount;
+		positionCount += chunks[i].positions.size() / 3;
+		texcoordCount += chunks[i].texcoords.size() / 2;
+		normalCount += chunks[i].normals.size() / 3;
+		cornerCount += chunks[i].corners.size() / 3;
+		malformedLines += chunks[i].malformedLines;
+	}
+	if (cornerCount == 0) {
+		printf("'%s' has no faces\n", fileLocation);
+		return false;
+	}
+	std::vector<GLfloat> positions(positionCount * 3), texcoords(texcoordCount * 2), normals(normalCount * 3);
+	std::vector<unsigned int> corners(cornerCount * 3);
+	JobSystem::parallelFor("Merge OBJ chunks", chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ObjChunk& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.texcoordBase * 2);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+			unsigned int* resolved = &corners[chunk.cornerBase * 3];
+			for (size_t c = 0; c < chunk.corners.size(); c += 3) {
+				resolved[c] = ResolveObjIndex(chunk.corners[c], chunk.positionBase, positionCount, chunk.badIndex);
+				resolved[c + 1] = ResolveObjIndex(chunk.corners[c + 1], chunk.texcoordBase, texcoordCount, chunk.badIndex);
+				resolved[c + 2] = ResolveObjIndex(chunk.corners[c + 2], chunk.normalBase, normalCount, chunk.badIndex);
+			}
+			// Parsed text is not needed anymore
+			std::vector<GLfloat>().swap(chunk.positions);
+			std::vector<GLfloat>().swap(chunk.texcoords);
+			std::vector<GLfloat>().swap(chunk.normals);
+			std::vector<int>().swap(chunk.corners);
+		}
+	});
+	for (size_t i = 0; i < chunks.size(); i++) {
+		if (chunks[i].badIndex) {
+			printf("'%s' has face indices out of range\n", fileLocation);
+			return false;
+		}
+	}
+	if (malformedLines > 0) {
+		printf("'%s': %u malformed lines skipped\n", fileLocation, malformedLines);
+	}
+
+	// One vertex per distinct (v, vt, vn). Open addressing table of vertex numbers, at most half full
+	size_t tableSize = 1;
+	while (tableSize < cornerCount * 2) {
+		tableSize *= 2;
+	}
+	std::vector<unsigned int> table(tableSize, NO_INDEX);
+	std::vector<unsigned int> vertexCorners; // v, vt, vn of each vertex
+	vertexCorners.reserve(cornerCount); // Room for a third of the corners: vertices are usually shared by several faces
+	mesh.indices.resize(cornerCount);
+	bool missingNormals = false;
+	for (size_t c = 0; c < cornerCount; c++) {
+		const unsigned int* corner = &corners[c * 3];
+		size_t slot = HashCorner(corner) & (tableSize - 1);
+		while (table[slot] != NO_INDEX && memcmp(&vertexCorners[table[slot] * 3], corner, sizeof(unsigned int) * 3) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == NO_INDEX) {
+			table[slot] = (unsigned int)(vertexCorners.size() / 3);
+			vertexCorners.insert(vertexCorners.end(), corner, corner + 3);
+			missingNormals = missingNormals || corner[2] == NO_INDEX;
+		}
+		mesh.indices[c] = table[slot];
+	}
+
+	// Interleave
+	size_t vertexCount = vertexCorners.size() / 3;
+	mesh.vertices.resize(vertexCount * 8);
+	GLfloat* vertices = mesh.vertices.data();
+	JobSystem::parallelFor("Interleave OBJ", vertexCount, INTERLEAVE_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const unsigned int* corner = &vertexCorners[i * 3];
+			GLfloat* vertex = vertices + i * 8;
+			memcpy(vertex, &positions[corner[0] * 3], sizeof(GLfloat) * 3);
+			vertex[3] = corner[1] != NO_INDEX ? texcoords[corner[1] * 2] : 0.0f;
+			vertex[4] = corner[1] != NO_INDEX ? texcoords[corner[1] * 2 + 1] : 0.0f;
+			vertex[5] = corner[2] != NO_INDEX ? -normals[corner[2] * 3] : 0.0f;
+			vertex[6] = corner[2] != NO_INDEX ? -normals[corner[2] * 3 + 1] : 0.0f;
+			vertex[7] = corner[2] != NO_INDEX ? -normals[corner[2] * 3 + 2] : 0.0f;
+		}
+	});
+	if (missingNormals) {
+		ComputeNormals(mesh.indices.data(), (unsigned int)mesh.indices.size(), vertices, (unsigned int)mesh.vertices.size());
+	}
+	return true;
+}
+
+/********************************
+*	JSON (glTF)
+*********************************/
+// Just enough JSON for a glTF header: the whole document as a tree
+struct JsonValue
+{
+	enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+	Type type;
+	double number;
+	std::string text;
+	std::vector<std::string> keys; // Objects: keys[i] names items[i]
+	std::vector<JsonValue> items;
+
+	JsonValue() { type = JSON_NULL; number = 0.0; };
+
+	const JsonValue* get(const char* key) const {
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (keys[i] == key) {
+				return &items[i];
+			}
+		}
+		return NULL;
+	};
+	const JsonValue* at(size_t index) const { return type == JSON_ARRAY && index < items.size() ? &items[index] : NULL; };
+	double getNumber(const char* key, double fallback) const {
+		const JsonValue* value = get(key);
+		return value && value->type == JSON_NUMBER ? value->number : fallback;
+	};
+};
+
+static const int JSON_MAX_DEPTH = 64;
+
+static inline const char* SkipJsonSpace(const char* cursor, const char* end) {
+	while (cursor < end && (IsBlank(*cursor) || *cursor == '\n')) {
+		cursor++;
+	}
+	return cursor;
+}
+
+static const char* ParseJsonString(const char* cursor, const char* end, std::string& text) {
+	cursor++; // Opening quote
+	while (cursor < end && *cursor != '"') {
+		if (*cursor == '\\' && cursor + 1 < end) {
+			cursor++;
+			switch (*cursor) {
+			case 'n': text += '\n'; break;
+			case 't': text += '\t'; break;
+			case 'r': text += '\r'; break;
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'u': text += '?'; cursor += end - cursor > 4 ? 4 : 0; break; // Names that matter here are ASCII
+			default: text += *cursor; break;
+			}
+		}
+		else {
+			text += *cursor;
+		}
+		cursor++;
+	}
+	return cursor < end ? cursor + 1 : NULL;
+}
+
+// NULL on a syntax error
+static const char* ParseJsonValue(const char* cursor, const char* end, JsonValue& value, int depth) {
+	cursor = SkipJsonSpace(cursor, end);
+	if (cursor >= end || depth > JSON_MAX_DEPTH) {
+		return NULL;
+	}
+	if (*cursor == '{' || *cursor == '[') {
+		bool object = *cursor == '{';
+		char closing = object ? '}' : ']';
+		value.type = object ? JsonValue::JSON_OBJECT : JsonValue::JSON_ARRAY;
+		cursor++;
+		while (true) {
+			cursor = SkipJsonSpace(cursor, end);
+			if (cursor < end && *cursor == ',') {
+				cursor = SkipJsonSpace(cursor + 1, end);
+			}
+			if (cursor >= end) {
+				return NULL;
+			}
+			if (*cursor == closing) {
+				return cursor + 1;
+			}
+			if (object) {
+				if (*cursor != '"') {
+					return NULL;
+				}
+				value.keys.push_back(std::string());
+				cursor = ParseJsonString(cursor, end, value.keys.back());
+				cursor = cursor ? SkipJsonSpace(cursor, end) : NULL;
+				if (!cursor || cursor >= end || *cursor != ':') {
+					return NULL;
+				}
+				cursor++;
+			}
+			value.items.push_back(JsonValue());
+			cursor = ParseJsonValue(cursor, end, value.items.back(), depth + 1);
+			if (!cursor) {
+				return NULL;
+			}
+		}
+	}
+	if (*cursor == '"') {
+		value.type = JsonValue::JSON_STRING;
+		return ParseJsonString(cursor, end, value.text);
+	}
+	if (end - cursor >= 4 && strncmp(cursor, "true", 4) == 0) {
+		value.type = JsonValue::JSON_BOOL;
+		value.number = 1.0;
+		return cursor + 4;
+	}
+	if (end - cursor >= 5 && strncmp(cursor, "false", 5) == 0) {
+		value.type = JsonValue::JSON_BOOL;
+		return cursor + 5;
+	}
+	if (end - cursor >= 4 && strncmp(cursor, "null", 4) == 0) {
+		return cursor + 4;
+	}
+	const char* next = ParseNumber(cursor, end, value.number);
+	if (next == cursor) {
+		return NULL;
+	}
+	value.type = JsonValue::JSON_NUMBER;
+	return next;
+}
+
+/********************************
+*	Binary glTF
+*********************************/
+static const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+static const int GLTF_UNSIGNED_BYTE = 5121, GLTF_UNSIGNED_SHORT = 5123, GLTF_UNSIGNED_INT = 5125, GLTF_FLOAT = 5126;
+
+// Typed view of an accessor inside the binary chunk
+struct GlbAccessor
+{
+	const unsigned char* data;
+	size_t count, stride;
+	int componentType, components;
+	bool normalized;
+};
+
+static size_t ComponentSize(int componentType) {
+	switch (componentType) {
+	case GLTF_UNSIGNED_BYTE: return 1;
+	case GLTF_UNSIGNED_SHORT: return 2;
+	case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+	default: return 0;
+	}
+}
+
+static bool GetGlbAccessor(const JsonValue& root, double index, const unsigned char* bin, size_t binSize, GlbAccessor& accessor) {
+	const JsonValue* accessors = root.get("accessors");
+	const JsonValue* description = accessors ? accessors->at((size_t)index) : NULL;
+	if (!description || description->get("sparse")) {
+		return false; // Sparse accessors are not supported
+	}
+	const JsonValue* bufferViews = root.get("bufferViews");
+	const JsonValue* view = bufferViews ? bufferViews->at((size_t)description->getNumber("bufferView", -1.0)) : NULL;
+	if (!view || view->getNumber("buffer", 0.0) != 0.0) {
+		return false; // Only the binary chunk of the GLB
+	}
+	const JsonValue* type = description->get("type");
+	accessor.components = !type ? 0 : type->text == "SCALAR" ? 1 : type->text == "VEC2" ? 2 : type->text == "VEC3" ? 3 : type->text == "VEC4" ? 4 : 0;
+	accessor.componentType = (int)description->getNumber("componentType", 0.0);
+	accessor.count = (size_t)description->getNumber("count", 0.0);
+	const JsonValue* normalized = description->get("normalized");
+	accessor.normalized = normalized && normalized->number != 0.0;
+	size_t elementSize = ComponentSize(accessor.componentType) * accessor.components;
+	size_t viewOffset = (size_t)view->getNumber("byteOffset", 0.0), viewLength = (size_t)view->getNumber("byteLength", 0.0);
+	size_t offset = (size_t)description->getNumber("byteOffset", 0.0);
+	accessor.stride = (size_t)view->getNumber("byteStride", (double)elementSize);
+	if (elementSize == 0 || accessor.count == 0 || viewOffset > binSize || viewLength > binSize - viewOffset ||
+		offset + (accessor.count - 1) * accessor.stride + elementSize > viewLength) {
+		return false;
+	}
+	accessor.data = bin + viewOffset + offset;
+	return true;
+}
+
+// Component 'component' of element 'index' as a float (normalized integers are scaled to [0, 1])
+static inline GLfloat ReadComponent(const GlbAccessor& accessor, size_t index, int component) {
+	const unsigned char* element = accessor.data + index * accessor.stride;
+	switch (accessor.componentType) {
+	case GLTF_FLOAT: { GLfloat value; memcpy(&value, element + component * 4, 4); return value; }
+	case GLTF_UNSIGNED_BYTE: return element[component] / (accessor.normalized ? 255.0f : 1.0f);
+	case GLTF_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, element + component * 2, 2); return value / (accessor.normalized ? 65535.0f : 1.0f); }
+	default: { uint32_t value; memcpy(&value, element + component * 4, 4); return (GLfloat)value; }
+	}
+}
+
+// Element 'index' of an integer scalar accessor (indices), exact: no float in between to round indices above 2^24
+static inline unsigned int ReadIndex(const GlbAccessor& accessor, size_t index) {
+	const unsigned char* element = accessor.data + index * accessor.stride;
+	switch (accessor.componentType) {
+	case GLTF_UNSIGNED_BYTE: return element[0];
+	case GLTF_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, element, 2); return value; }
+	default: { uint32_t value; memcpy(&value, element, 4); return value; }
+	}
+}
+
+bool MeshImporter::importGlb(const char* fileLocation, ImportedMesh& mesh) {
+	MappedFile file;
+	if (!file.open(fileLocation, true)) {
+		return false;
+	}
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+
+	// Header (magic, version, length), then chunks (length, type, data). JSON first, binary second
+	uint32_t header[3], jsonHeader[2], binHeader[2] = { 0, 0 };
+	if (size < 20) {
+		printf("'%s' is not a binary glTF file\n", fileLocation);
+		return false;
+	}
+	memcpy(header, data, 12);
+	memcpy(jsonHeader, data + 12, 8);
+	if (header[0] != GLB_MAGIC || header[1] != 2 || jsonHeader[1] != GLB_CHUNK_JSON || jsonHeader[0] > size - 20) {
+		printf("'%s' is not a binary glTF 2.0 file\n", fileLocation);
+		return false;
+	}
+	const char* json = (const char*)data + 20;
+	size_t binOffset = 20 + ((jsonHeader[0] + 3) & ~3u);
+	const unsigned char* bin = NULL;
+	size_t binSize = 0;
+	if (binOffset + 8 <= size) {
+		memcpy(binHeader, data + binOffset, 8);
+		if (binHeader[1] == GLB_CHUNK_BIN && binHeader[0] <= size - binOffset - 8) {
+			bin = data + binOffset + 8;
+			binSize = binHeader[0];
+		}
+	}
+
+	JsonValue root;
+	if (!ParseJsonValue(json, json + jsonHeader[0], root, 0) || root.type != JsonValue::JSON_OBJECT) {
+		printf("'%s': malformed glTF JSON\n", fileLocation);
+		return false;
+	}
+
+	// Every triangle primitive of every mesh, appended
+	const JsonValue* meshes = root.get("meshes");
+	unsigned int skipped = 0;
+	for (size_t m = 0; meshes && m < meshes->items.size(); m++) {
+		const JsonValue* primitives = meshes->items[m].get("primitives");
+		for (size_t p = 0; primitives && p < primitives->items.size(); p++) {
+			const JsonValue& primitive = primitives->items[p];
+			const JsonValue* attributes = primitive.get("attributes");
+			const JsonValue* positionIndex = attributes ? attributes->get("POSITION") : NULL;
+			const JsonValue* normalIndex = attributes ? attributes->get("NORMAL") : NULL;
+			const JsonValue* texcoordIndex = attributes ? attributes->get("TEXCOORD_0") : NULL;
+			GlbAccessor positions, normals, texcoords, indices;
+			bool hasNormals = normalIndex && GetGlbAccessor(root, normalIndex->number, bin, binSize, normals) &&
+				normals.componentType == GLTF_FLOAT && normals.components == 3;
+			bool hasTexcoords = texcoordIndex && GetGlbAccessor(root, texcoordIndex->number, bin, binSize, texcoords) &&
+				texcoords.componentType != GLTF_UNSIGNED_INT && texcoords.components == 2;
+			bool hasIndices = primitive.get("indices") != NULL;
+			if (primitive.getNumber("mode", 4.0) != 4.0 || !positionIndex ||
+				!GetGlbAccessor(root, positionIndex->number, bin, binSize, positions) || positions.componentType != GLTF_FLOAT || positions.components != 3 ||
+				(hasNormals && normals.count != positions.count) || (hasTexcoords && texcoords.count != positions.count) ||
+				(hasIndices && (!GetGlbAccessor(root, primitive.get("indices")->number, bin, binSize, indices) ||
+					indices.components != 1 || indices.componentType == GLTF_FLOAT))) {
+				skipped++; // Not triangles, or data this importer does not read
+				continue;
+			}
+
+			size_t baseVertex = mesh.vertices.size() / 8, firstIndex = mesh.indices.size();
+			size_t vertexCount = positions.count;
+			mesh.vertices.resize((baseVertex + vertexCount) * 8);
+			GLfloat* vertices = mesh.vertices.data() + baseVertex * 8;
+			JobSystem::parallelFor("Interleave glTF", vertexCount, INTERLEAVE_GRAIN, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					GLfloat* vertex = vertices + i * 8;
+					for (int c = 0; c < 3; c++) {
+						vertex[c] = ReadComponent(positions, i, c);
+						vertex[5 + c] = hasNormals ? -ReadComponent(normals, i, c) : 0.0f;
+					}
+					vertex[3] = hasTexcoords ? ReadComponent(texcoords, i, 0) : 0.0f;
+					vertex[4] = hasTexcoords ? ReadComponent(texcoords, i, 1) : 0.0f;
+				}
+			});
+
+			// Local indices first (normals are computed on the primitive alone), offset once done
+			size_t indexCount = hasIndices ? indices.count : vertexCount;
+			mesh.indices.resize(firstIndex + indexCount);
+			unsigned int* primitiveIndices = mesh.indices.data() + firstIndex;
+			bool inRange = true;
+			for (size_t i = 0; i < indexCount; i++) {
+				primitiveIndices[i] = hasIndices ? ReadIndex(indices, i) : (unsigned int)i;
+				inRange = inRange && primitiveIndices[i] < vertexCount;
+			}
+			if (!inRange || indexCount % 3 != 0) {
+				mesh.vertices.resize(baseVertex * 8);
+				mesh.indices.resize(firstIndex);
+				skipped++;
+				continue;
+			}
+			if (!hasNormals) {
+				ComputeNormals(primitiveIndices, (unsigned int)indexCount, vertices, (unsigned int)(vertexCount * 8));
+			}
+			for (size_t i = 0; i < indexCount; i++) {
+				primitiveIndices[i] += (unsigned int)baseVertex;
+			}
+		}
+	}
+	if (skipped > 0) {
+		printf("'%s': %u primitives skipped (not triangles, or unsupported data)\n", fileLocation, skipped);
+	}
+	if (mesh.indices.empty()) {
+		printf("'%s' has no triangles\n", fileLocation);
+		return false;
+	}
+	return true;
+}
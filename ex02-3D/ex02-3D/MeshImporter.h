@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+
+#include "Mesh.h"
+
+// Result of an import, in the layout Mesh::CreateMesh and IndirectRenderer::addMesh take
+struct ImportedMesh
+{
+	std::vector<GLfloat> vertices; // Interleaved (x, y, z, u, v, nx, ny, nz)
+	std::vector<unsigned int> indices; // Triangles
+
+	MeshData getMeshData() { return MeshData{ vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size() }; };
+};
+
+/*
+Mesh files to the interleaved layout of this project:
+- Wavefront OBJ (.obj): positions, texture coordinates, normals and faces (polygons are fanned into triangles).
+  Groups, objects and materials are ignored, everything ends up in one mesh
+- Binary glTF (.glb): every triangle primitive of every mesh (float attributes, any index type), merged into one
+  mesh. Node transforms are not applied
+
+The file is memory-mapped. OBJ text is split in chunks at line starts and the chunks are parsed on the job system
+with a hand-written number parser (no locale, no strtod), then merged and deduplicated into shared vertices.
+glTF buffers are interleaved straight from the mapped binary chunk, in parallel for large meshes.
+
+The shaders light the side a normal points away from (the floor normal is -Y), so imported normals are flipped.
+Missing normals are computed (CalcAverageNormal), OBJ texture coordinates are flipped to the top-left origin
+the textures are uploaded with
+*/
+class MeshImporter
+{
+public:
+	// By extension. Prints the problem and returns false when the file cannot be imported
+	static bool importMesh(const char* fileLocation, ImportedMesh& mesh);
+	static bool importObj(const char* fileLocation, ImportedMesh& mesh);
+	static bool importGlb(const char* fileLocation, ImportedMesh& mesh);
+};
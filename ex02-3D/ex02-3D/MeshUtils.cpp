@@ -0,0 +1,74 @@
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "MeshUtils.h"
+#include "JobSystem.h"
+
+// Below this many triangles the jobs cost more than they save
+static const unsigned int PARALLEL_TRIANGLES = 8192;
+
+// Adds the face normal of triangles [first, last) to 'normals' (3 floats per vertex, 'stride' apart)
+static void AccumulateFaceNormals(const unsigned int* indices, unsigned int first, unsigned int last, const GLfloat* vertices,
+								unsigned int vLength, GLfloat* normals, unsigned int stride) {
+	for (unsigned int t = first; t < last; t++) {
+		unsigned int i0 = indices[t * 3] * vLength;
+		unsigned int i1 = indices[t * 3 + 1] * vLength;
+		unsigned int i2 = indices[t * 3 + 2] * vLength;
+
+		glm::vec3 v1(vertices[i1] - vertices[i0], vertices[i1 + 1] - vertices[i0 + 1], vertices[i1 + 2] - vertices[i0 + 2]);
+		glm::vec3 v2(vertices[i2] - vertices[i0], vertices[i2 + 1] - vertices[i0 + 1], vertices[i2 + 2] - vertices[i0 + 2]);
+		glm::vec3 normal = glm::normalize(glm::cross(v1, v2));
+
+		unsigned int n0 = indices[t * 3] * stride, n1 = indices[t * 3 + 1] * stride, n2 = indices[t * 3 + 2] * stride;
+		normals[n0] += normal.x; normals[n0 + 1] += normal.y; normals[n0 + 2] += normal.z;
+		normals[n1] += normal.x; normals[n1 + 1] += normal.y; normals[n1 + 2] += normal.z;
+		normals[n2] += normal.x; normals[n2 + 1] += normal.y; normals[n2 + 2] += normal.z;
+	}
+}
+
+static void NormalizeNormal(GLfloat* normal) {
+	glm::vec3 vec = glm::normalize(glm::vec3(normal[0], normal[1], normal[2]));
+	normal[0] = vec.x;
+	normal[1] = vec.y;
+	normal[2] = vec.z;
+}
+
+// Normal calculations (source: OpenGL)
+void CalcAverageNormal(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+					unsigned int vLength, unsigned int normalOffset) {
+	unsigned int triangleCount = indexCount / 3;
+	unsigned int vertexTotal = vertexCount / vLength;
+	unsigned int sliceCount = JobSystem::getThreadCount();
+
+	if (triangleCount < PARALLEL_TRIANGLES || sliceCount < 2) {
+		// Accumulate straight into the vertex array, then normalize
+		AccumulateFaceNormals(indices, 0, triangleCount, vertices, vLength, vertices + normalOffset, vLength);
+		for (unsigned int i = 0; i < vertexTotal; i++) {
+			NormalizeNormal(vertices + i * vLength + normalOffset);
+		}
+		return;
+	}
+
+	// Triangles sharing a vertex may land in different slices: every slice sums into its own buffer,
+	// then one pass per vertex adds the buffers together (no atomics, no locks)
+	std::vector<GLfloat> partialSums((size_t)sliceCount * vertexTotal * 3, 0.0f);
+	JobSystem::parallelFor("Face normals", sliceCount, 1, [&](size_t begin, size_t end) {
+		for (size_t slice = begin; slice < end; slice++) {
+			unsigned int first = (unsigned int)(triangleCount * slice / sliceCount);
+			unsigned int last = (unsigned int)(triangleCount * (slice + 1) / sliceCount);
+			AccumulateFaceNormals(indices, first, last, vertices, vLength, &partialSums[slice * vertexTotal * 3], 3);
+		}
+	});
+	JobSystem::parallelFor("Vertex normals", vertexTotal, 4096, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			GLfloat* normal = vertices + i * vLength + normalOffset;
+			for (unsigned int slice = 0; slice < sliceCount; slice++) {
+				const GLfloat* sum = &partialSums[(slice * vertexTotal + i) * 3];
+				normal[0] += sum[0];
+				normal[1] += sum[1];
+				normal[2] += sum[2];
+			}
+			NormalizeNormal(normal);
+		}
+	});
+}
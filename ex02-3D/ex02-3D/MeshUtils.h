@@ -0,0 +1,8 @@
+#pragma once
+#include <GL\glew.h>
+
+// Smooth normals: each vertex gets the normalized sum of the normals of the triangles using it.
+// Large meshes are split across the job system, small ones (like the pyramid) run inline
+// Args: (indices, index count, interleaved vertices, float count of 'vertices', floats per vertex, offset of the normal)
+void CalcAverageNormal(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+					unsigned int vLength, unsigned int normalOffset);
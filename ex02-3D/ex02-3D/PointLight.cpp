@@ -18,19 +18,3 @@ PointLight::PointLight(GLfloat red, GLfloat green, GLfloat blue,
 }
 
 PointLight::~PointLight() {}
-
-void PointLight::UseLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-	GLuint diffuseIntensityLocation, GLuint positionLocation,
-	GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation) {
-
-	// Ambient
-	glUniform1f(ambientIntensityLocation, ambientIntensity);
-	glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-	// Diffuse
-	glUniform1f(diffuseIntensityLocation, diffuseIntensity);
-	glUniform3f(positionLocation, position.x, position.y, position.z);
-
-	glUniform1f(constantLocation, constant);
-	glUniform1f(linearLocation, linear);
-	glUniform1f(exponentLocation, exponent);
-}
\ No newline at end of file
@@ -10,9 +10,10 @@ public:
 		GLfloat xPos, GLfloat yPos, GLfloat zPos,
 		GLfloat con, GLfloat lin, GLfloat exp);
 	~PointLight();
-	void UseLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-		GLuint diffuseIntensityLocation, GLuint positionLocation,
-		GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation);
+	glm::vec3 getPosition() const { return position; };
+	GLfloat getConstant() const { return constant; };
+	GLfloat getLinear() const { return linear; };
+	GLfloat getExponent() const { return exponent; };
 protected:
 	glm::vec3 position;
 	GLfloat constant, linear, exponent; // L/(ax^2 + bx + c) a: exponent, b: linear, c: constant
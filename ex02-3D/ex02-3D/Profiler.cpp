@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <algorithm>
+#include "Profiler.h"
+#include "FrameArena.h"
+
+static const std::chrono::steady_clock::time_point profilerStart = std::chrono::steady_clock::now();
+static thread_local ProfileThreadBuffer* threadBuffer = NULL;
+
+std::mutex Profiler::buffersLock;
+std::vector<ProfileThreadBuffer*> Profiler::buffers;
+unsigned int Profiler::reportInterval = 0;
+unsigned int Profiler::framesSinceReport = 0;
+uint64_t Profiler::reportStartNs = 0;
+std::map<std::string, ProfileZoneStats, std::less<>> Profiler::reportZones;
+uint64_t Profiler::lostEvents = 0;
+std::vector<ProfileZoneStats> Profiler::summary;
+unsigned int Profiler::summaryFrames = 0;
+unsigned int Profiler::framesSinceSummary = 0;
+
+/********************************
+*	Recording
+*********************************/
+ProfileThreadBuffer::ProfileThreadBuffer(unsigned int index) {
+	threadIndex = index;
+	snprintf(threadName, sizeof(threadName), "Thread %u", index);
+	isTrack = false;
+	depth = 0;
+	head = 0;
+	readIndex = 0;
+}
+
+void ProfileThreadBuffer::push(const ProfileEvent& event) {
+	uint64_t index = head.load(std::memory_order_relaxed);
+	events[index & (CAPACITY - 1)] = event;
+	head.store(index + 1, std::memory_order_release); // Readers see the event before the new head
+}
+
+uint64_t Profiler::nowNs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerStart).count();
+}
+
+ProfileThreadBuffer* Profiler::getThreadBuffer() {
+	if (!threadBuffer) {
+		// Kept until exit: the trace may still want the events of a thread that is gone
+		std::lock_guard<std::mutex> lock(buffersLock);
+		threadBuffer = new ProfileThreadBuffer((unsigned int)buffers.size());
+		buffers.push_back(threadBuffer);
+	}
+	return threadBuffer;
+}
+
+void Profiler::setThreadName(const char* name) {
+	ProfileThreadBuffer* buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffersLock);
+	snprintf(buffer->threadName, sizeof(buffer->threadName), "%s", name);
+}
+
+ProfileThreadBuffer* Profiler::createTrack(const char* name) {
+	std::lock_guard<std::mutex> lock(buffersLock);
+	ProfileThreadBuffer* track = new ProfileThreadBuffer((unsigned int)buffers.size());
+	snprintf(track->threadName, sizeof(track->threadName), "%s", name);
+	track->isTrack = true;
+	buffers.push_back(track);
+	return track;
+}
+
+/********************************
+*	Frame report
+*********************************/
+void Profiler::endFrame() {
+	uint64_t now = nowNs();
+	if (reportStartNs == 0) {
+		reportStartNs = now;
+	}
+	framesSinceReport++;
+	framesSinceSummary++;
+	bool reportDue = reportInterval != 0 && framesSinceReport >= reportInterval;
+	if (framesSinceSummary >= SUMMARY_FRAMES || reportDue) {
+		collectZones();
+	}
+	if (!reportDue) {
+		return;
+	}
+	printReport(now - reportStartNs);
+	// Zeroed rather than cleared: the zones keep their entries (and names) for the next table
+	for (std::map<std::string, ProfileZoneStats, std::less<>>::iterator zone = reportZones.begin(); zone != reportZones.end(); zone++) {
+		zone->second.calls = 0;
+		zone->second.totalNs = 0;
+		zone->second.maxNs = 0;
+	}
+	lostEvents = 0;
+	framesSinceReport = 0;
+	reportStartNs = now;
+}
+
+static bool MoreExpensive(const ProfileZoneStats& a, const ProfileZoneStats& b) {
+	return a.totalNs > b.totalNs;
+}
+
+// Totals of a zone while the events are summed
+struct ZoneTotals
+{
+	uint64_t calls, totalNs, maxNs;
+	uint32_t depth;
+};
+
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+
+void Profiler::collectZones() {
+	// Temporary: the map and its keys come from the frame arena, the summary and the report totals keep their
+	// storage between windows, so once every zone has been seen a summary does not allocate
+	std::map<FrameString, ZoneTotals, std::less<FrameString>, FrameAllocator<std::pair<const FrameString, ZoneTotals>>> zones;
+	FrameString key;
+
+	std::lock_guard<std::mutex> lock(buffersLock);
+	for (size_t b = 0; b < buffers.size(); b++) {
+		ProfileThreadBuffer* buffer = buffers[b];
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		if (head - buffer->readIndex > ProfileThreadBuffer::CAPACITY) {
+			// The thread wrote more than the ring holds since the last summary
+			lostEvents += head - buffer->readIndex - ProfileThreadBuffer::CAPACITY;
+			buffer->readIndex = head - ProfileThreadBuffer::CAPACITY;
+		}
+		for (uint64_t i = buffer->readIndex; i < head; i++) {
+			// Copied, then dropped if the owner reached the slot meanwhile (it writes event i + CAPACITY there while
+			// its head is i + CAPACITY): the oldest events can be overwritten while they are summed
+			ProfileEvent event = buffer->events[i & (ProfileThreadBuffer::CAPACITY - 1)];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (buffer->head.load(std::memory_order_relaxed) >= i + ProfileThreadBuffer::CAPACITY) {
+				lostEvents++;
+				continue;
+			}
+			uint64_t duration = event.endNs - event.startNs;
+			// Same name on a track (GPU) and on a thread are different zones
+			key.clear();
+			if (buffer->isTrack) {
+				key.append("[").append(buffer->threadName).append("] ");
+			}
+			key.append(event.name);
+			ZoneTotals& zone = zones[key];
+			if (zone.calls == 0) {
+				zone.maxNs = duration;
+				zone.depth = event.depth;
+			}
+			zone.calls++;
+			zone.totalNs += duration;
+			zone.maxNs = std::max(zone.maxNs, duration);
+			zone.depth = std::min(zone.depth, event.depth);
+		}
+		buffer->readIndex = head;
+	}
+
+	// This window becomes the summary and is added to the totals of the next printed table. The totals are never
+	// erased (only zeroed after a table), so their keys also name the summary entries
+	summary.clear();
+	for (auto zone = zones.begin(); zone != zones.end(); zone++) {
+		std::map<std::string, ProfileZoneStats, std::less<>>::iterator total = reportZones.find(zone->first.c_str());
+		if (total == reportZones.end()) {
+			total = reportZones.insert(std::make_pair(std::string(zone->first.c_str()), ProfileZoneStats())).first;
+			total->second.name = total->first.c_str(); // Map keys do not move
+			total->second.depth = zone->second.depth;
+		}
+		ProfileZoneStats stats = { total->second.name, zone->second.calls, zone->second.totalNs, zone->second.maxNs, zone->second.depth };
+		summary.push_back(stats);
+		total->second.calls += stats.calls;
+		total->second.totalNs += stats.totalNs;
+		total->second.maxNs = std::max(total->second.maxNs, stats.maxNs);
+		total->second.depth = std::min(total->second.depth, stats.depth);
+	}
+	std::sort(summary.begin(), summary.end(), MoreExpensive);
+	summaryFrames = framesSinceSummary;
+	framesSinceSummary = 0;
+}
+
+static bool MoreExpensiveTotal(const ProfileZoneStats* a, const ProfileZoneStats* b) {
+	return a->totalNs > b->totalNs;
+}
+
+void Profiler::printReport(uint64_t elapsedNs) {
+	// Most expensive first
+	FrameVector<const ProfileZoneStats*> sorted;
+	sorted.reserve(reportZones.size());
+	for (std::map<std::string, ProfileZoneStats, std::less<>>::iterator zone = reportZones.begin(); zone != reportZones.end(); zone++) {
+		if (zone->second.calls > 0) {
+			sorted.push_back(&zone->second);
+		}
+	}
+	std::sort(sorted.begin(), sorted.end(), MoreExpensiveTotal);
+
+	double frames = framesSinceReport > 0 ? (double)framesSinceReport : 1.0;
+	double frameMs = elapsedNs / 1e6 / frames;
+	printf("Profile: %u frames, %.2f ms/frame%s\n", framesSinceReport, frameMs, lostEvents > 0 ? " (some events overwritten)" : "");
+	printf("  %-32s %10s %10s %10s %8s\n", "Zone", "calls/frm", "ms/frame", "max ms", "% frame");
+	for (size_t i = 0; i < sorted.size(); i++) {
+		const ProfileZoneStats& totals = *sorted[i];
+		double msPerFrame = totals.totalNs / 1e6 / frames;
+		// Nested zones are indented under their parents' level
+		int indent = (int)std::min(totals.depth, 8u) * 2;
+		printf("  %*s%-*.*s %10.1f %10.3f %10.3f %7.1f%%\n", indent, "", 32 - indent, 32 - indent, totals.name, totals.calls / frames,
+			msPerFrame, totals.maxNs / 1e6, frameMs > 0.0 ? msPerFrame / frameMs * 100.0 : 0.0);
+	}
+}
+
+/********************************
+*	Chrome trace
+*********************************/
+// Zone names are identifiers and literals, only quotes and backslashes need escaping
+static void WriteJsonString(FILE* file, const char* text) {
+	fputc('"', file);
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool Profiler::writeTrace(const char* fileLocation) {
+	FILE* file = fopen(fileLocation, "w");
+	if (!file) {
+		printf("Failed to write the profile trace to '%s'\n", fileLocation);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffersLock);
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	unsigned int eventCount = 0;
+	std::vector<ProfileEvent> copy;
+	for (size_t b = 0; b < buffers.size(); b++) {
+		ProfileThreadBuffer* buffer = buffers[b];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", buffer->threadIndex);
+		WriteJsonString(file, buffer->threadName);
+		fprintf(file, "}}");
+		first = false;
+
+		// Copy the ring, then drop whatever the owner overwrote while we were copying
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t begin = head > ProfileThreadBuffer::CAPACITY ? head - ProfileThreadBuffer::CAPACITY : 0;
+		copy.clear();
+		for (uint64_t i = begin; i < head; i++) {
+			copy.push_back(buffer->events[i & (ProfileThreadBuffer::CAPACITY - 1)]);
+		}
+		uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+		// Event headAfter - CAPACITY may be the one being written
+		uint64_t firstValid = headAfter >= ProfileThreadBuffer::CAPACITY ? headAfter - ProfileThreadBuffer::CAPACITY + 1 : 0;
+		size_t skip = firstValid > begin ? (size_t)std::min<uint64_t>(firstValid - begin, copy.size()) : 0;
+
+		for (size_t i = skip; i < copy.size(); i++) {
+			// Complete events, times in microseconds
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, copy[i].name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->threadIndex,
+				copy[i].startNs / 1000.0, (copy[i].endNs - copy[i].startNs) / 1000.0);
+			eventCount++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	printf("Profile trace: %u zones written to '%s'\n", eventCount, fileLocation);
+	return true;
+}
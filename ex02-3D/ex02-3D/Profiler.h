@@ -0,0 +1,150 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <string>
+
+/*
+Scoped CPU profiling zones:
+
+	void RenderFrame() {
+		PROFILE_FUNCTION();
+		{
+			PROFILE_SCOPE("Lights");
+			...
+		}
+	}
+
+Every zone is timed in nanoseconds and written to a ring buffer owned by the thread (no locks, no allocation).
+Once per frame PROFILE_FRAME() marks the frame boundary; the zones are summed every few frames (the HUD shows
+the latest sums) and printed as a table every N frames.
+The rings can be written as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+
+The macros compile to nothing unless PROFILER_ENABLED is 1, which it is by default in debug builds (no NDEBUG).
+Zone names must be string literals (only the pointer is stored)
+*/
+
+#ifndef PROFILER_ENABLED
+#ifdef NDEBUG
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_FRAME() Profiler::endFrame()
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(name)
+#endif
+
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t startNs, endNs; // Since Profiler start
+	uint32_t depth; // Zones open on the thread around this one
+};
+
+// Totals of one zone over a number of frames
+struct ProfileZoneStats
+{
+	const char* name; // Zones of a track are "[track] name". Kept by the profiler for the whole run
+	uint64_t calls, totalNs, maxNs;
+	uint32_t depth; // Shallowest nesting seen
+};
+
+// Events of one thread. Only that thread writes, the profiler reads behind it
+class ProfileThreadBuffer
+{
+public:
+	static const uint64_t CAPACITY = 16384; // Power of two. Older events are overwritten
+
+	ProfileThreadBuffer(unsigned int threadIndex);
+
+	void push(const ProfileEvent& event);
+
+	unsigned int threadIndex;
+	char threadName[32];
+	bool isTrack; // Not a thread: events come from elsewhere (GPU), its zones are labelled with the name
+	uint32_t depth; // Owner only
+
+	ProfileEvent events[CAPACITY];
+	std::atomic<uint64_t> head; // Events written so far
+	uint64_t readIndex; // Next event the frame report has not seen yet (profiler thread only)
+};
+
+class Profiler
+{
+public:
+	static uint64_t nowNs();
+	// Buffer of the calling thread, created on its first zone
+	static ProfileThreadBuffer* getThreadBuffer();
+	static void setThreadName(const char* name);
+	// Extra timeline for events that do not run on a CPU thread (GPU zones). One thread pushes to it
+	static ProfileThreadBuffer* createTrack(const char* name);
+
+	// Counts a frame. Every 'reportInterval' frames prints the per-zone table (0 = never)
+	static void endFrame();
+	static void setReportInterval(unsigned int frames) { reportInterval = frames; };
+	// Zones of the last SUMMARY_FRAMES frames, most expensive first (main thread, refreshed by endFrame)
+	static const std::vector<ProfileZoneStats>& getZoneSummary() { return summary; };
+	static unsigned int getSummaryFrames() { return summaryFrames; };
+
+	// Events still held by the rings, as Chrome trace JSON. Returns false when the file cannot be written
+	static bool writeTrace(const char* fileLocation);
+
+	static bool isCompiledIn() { return PROFILER_ENABLED != 0; };
+
+private:
+	static const unsigned int SUMMARY_FRAMES = 30; // Frames summed together for getZoneSummary()
+
+	static std::mutex buffersLock; // Taken once per thread (registration) and by the reports, never per zone
+	static std::vector<ProfileThreadBuffer*> buffers;
+	static unsigned int reportInterval;
+	static unsigned int framesSinceReport;
+	static uint64_t reportStartNs;
+	static std::map<std::string, ProfileZoneStats, std::less<>> reportZones; // Summed since the last printed table (transparent: found by const char*)
+	static uint64_t lostEvents; // Overwritten before they were summed, since the last printed table
+	static std::vector<ProfileZoneStats> summary;
+	static unsigned int summaryFrames, framesSinceSummary;
+
+	static void collectZones(); // Sums the events the rings got since the last call
+	static void printReport(uint64_t elapsedNs);
+};
+
+// Times its own lifetime
+class ProfileScope
+{
+public:
+	ProfileScope(const char* zoneName) {
+		buffer = Profiler::getThreadBuffer();
+		name = zoneName;
+		depth = buffer->depth++;
+		startNs = Profiler::nowNs();
+	};
+	~ProfileScope() {
+		ProfileEvent event;
+		event.name = name;
+		event.startNs = startNs;
+		event.endNs = Profiler::nowNs();
+		event.depth = depth;
+		buffer->depth--;
+		buffer->push(event);
+	};
+
+private:
+	ProfileThreadBuffer* buffer;
+	const char* name;
+	uint64_t startNs;
+	uint32_t depth;
+};
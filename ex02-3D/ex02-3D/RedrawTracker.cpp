@@ -0,0 +1,4 @@
+#include "RedrawTracker.h"
+
+std::atomic<bool> RedrawTracker::dirty(true); // The first frame always has to be drawn
+std::atomic<unsigned int> RedrawTracker::changes(0);
@@ -0,0 +1,17 @@
+#pragma once
+#include <atomic>
+
+// Render-on-demand bookkeeping. Whatever changes the picture (input, camera, lights, transforms) marks the
+// frame dirty; the main loop only redraws dirty frames and otherwise sleeps in glfwWaitEventsTimeout
+class RedrawTracker
+{
+public:
+	static void markDirty() { changes++; dirty = true; };
+	static bool isDirty() { return dirty.load(); };
+	static bool consumeDirty() { return dirty.exchange(false); }; // True if a redraw is needed, then clears the flag
+	static unsigned int getChangeCount() { return changes.load(); }; // Total markDirty() calls
+
+private:
+	static std::atomic<bool> dirty;
+	static std::atomic<unsigned int> changes;
+};
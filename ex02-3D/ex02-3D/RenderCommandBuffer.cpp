@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "RenderCommandBuffer.h"
+#include "RenderStats.h"
+
+unsigned int RenderCommandBuffer::droppedCommands = 0;
+
+RenderCommandBuffer::RenderCommandBuffer() : allocator(256 * 1024) {
+	dropped = 0;
+	current.sortKey = 0;
+	current.commands = NULL;
+	current.commandCount = 0;
+	current.order = 0;
+}
+
+void RenderCommandBuffer::reset() {
+	allocator.reset();
+	packets.clear(); // Keeps the capacity
+	current.commands = NULL;
+	current.commandCount = 0;
+	dropped = 0;
+}
+
+void RenderCommandBuffer::beginPacket(GLuint64 sortKey) {
+	// Room for the largest packet, so its commands are contiguous (unused slots are just skipped memory)
+	current.sortKey = sortKey;
+	current.commands = (RenderCommand*)allocator.allocate(sizeof(RenderCommand) * MAX_PACKET_COMMANDS, 16);
+	current.commandCount = 0;
+}
+
+RenderCommand* RenderCommandBuffer::push(GLuint type) {
+	if (!current.commands || current.commandCount >= MAX_PACKET_COMMANDS) {
+		dropped++; // Reported with the stats, not per command
+		return NULL;
+	}
+	RenderCommand* command = &current.commands[current.commandCount++];
+	command->type = type;
+	return command;
+}
+
+void RenderCommandBuffer::setProgram(GLuint program) {
+	RenderCommand* command = push(COMMAND_SET_PROGRAM);
+	if (command) {
+		command->setProgram.program = program;
+	}
+}
+
+void RenderCommandBuffer::bindVertexArray(GLuint vao, GLuint ibo) {
+	RenderCommand* command = push(COMMAND_BIND_VERTEX_ARRAY);
+	if (command) {
+		command->bindVertexArray.vao = vao;
+		command->bindVertexArray.ibo = ibo;
+	}
+}
+
+void RenderCommandBuffer::bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	RenderCommand* command = push(COMMAND_BIND_UNIFORM_RANGE);
+	if (command) {
+		command->bindUniformRange.binding = binding;
+		command->bindUniformRange.buffer = buffer;
+		command->bindUniformRange.offset = offset;
+		command->bindUniformRange.size = size;
+	}
+}
+
+void RenderCommandBuffer::bindTexture(GLenum unit, GLenum target, GLuint texture) {
+	RenderCommand* command = push(COMMAND_BIND_TEXTURE);
+	if (command) {
+		command->bindTexture.unit = unit;
+		command->bindTexture.target = target;
+		command->bindTexture.texture = texture;
+	}
+}
+
+void RenderCommandBuffer::drawElements(GLenum mode, GLsizei count, GLenum indexType, GLintptr indexOffset) {
+	RenderCommand* command = push(COMMAND_DRAW_ELEMENTS);
+	if (command) {
+		command->drawElements.mode = mode;
+		command->drawElements.count = count;
+		command->drawElements.indexType = indexType;
+		command->drawElements.indexOffset = indexOffset;
+	}
+}
+
+void RenderCommandBuffer::endPacket() {
+	if (current.commands && current.commandCount > 0) {
+		packets.push_back(current);
+	}
+	current.commands = NULL;
+	current.commandCount = 0;
+}
+
+static bool ComparePackets(const RenderPacket& a, const RenderPacket& b) {
+	return a.sortKey != b.sortKey ? a.sortKey < b.sortKey : a.order < b.order;
+}
+
+void RenderCommandBuffer::Replay(RenderCommandBuffer** buffers, size_t bufferCount, std::vector<RenderPacket>& sorted) {
+	sorted.clear();
+	for (size_t b = 0; b < bufferCount; b++) {
+		sorted.insert(sorted.end(), buffers[b]->packets.begin(), buffers[b]->packets.end());
+		droppedCommands += buffers[b]->dropped;
+	}
+	// Packets with equal keys keep their recording order. std::sort with the order as a tie-break instead of
+	// std::stable_sort, which allocates a temporary buffer on every call
+	for (size_t p = 0; p < sorted.size(); p++) {
+		sorted[p].order = (GLuint)p;
+	}
+	std::sort(sorted.begin(), sorted.end(), ComparePackets);
+
+	// Bound state, so redundant binds between packets are skipped
+	GLuint boundProgram = 0, boundVAO = 0, boundTextures[16] = { 0 };
+	for (size_t p = 0; p < sorted.size(); p++) {
+		const RenderPacket& packet = sorted[p];
+		for (GLuint c = 0; c < packet.commandCount; c++) {
+			const RenderCommand& command = packet.commands[c];
+			switch (command.type) {
+			case COMMAND_SET_PROGRAM:
+				if (command.setProgram.program != boundProgram) {
+					glUseProgram(command.setProgram.program);
+					boundProgram = command.setProgram.program;
+					RenderStats::addStateChange();
+				}
+				break;
+			case COMMAND_BIND_VERTEX_ARRAY:
+				if (command.bindVertexArray.vao != boundVAO) {
+					glBindVertexArray(command.bindVertexArray.vao);
+					// Older drivers do not restore the IBO with the VAO (see Mesh::RenderMesh)
+					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, command.bindVertexArray.ibo);
+					boundVAO = command.bindVertexArray.vao;
+					RenderStats::addStateChange();
+				}
+				break;
+			case COMMAND_BIND_UNIFORM_RANGE:
+				glBindBufferRange(GL_UNIFORM_BUFFER, command.bindUniformRange.binding, command.bindUniformRange.buffer,
+					command.bindUniformRange.offset, command.bindUniformRange.size);
+				RenderStats::addStateChange();
+				break;
+			case COMMAND_BIND_TEXTURE: {
+				GLuint unit = command.bindTexture.unit - GL_TEXTURE0;
+				if (unit >= 16 || boundTextures[unit] != command.bindTexture.texture) {
+					glActiveTexture(command.bindTexture.unit);
+					glBindTexture(command.bindTexture.target, command.bindTexture.texture);
+					if (unit < 16) {
+						boundTextures[unit] = command.bindTexture.texture;
+					}
+					RenderStats::addStateChange();
+				}
+				break;
+			}
+			case COMMAND_DRAW_ELEMENTS:
+				glDrawElements(command.drawElements.mode, command.drawElements.count, command.drawElements.indexType,
+					(void*)command.drawElements.indexOffset);
+				RenderStats::addDrawCall(command.drawElements.count);
+				break;
+			}
+		}
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+unsigned int RenderCommandBuffer::takeDroppedCommands() {
+	unsigned int count = droppedCommands;
+	droppedCommands = 0;
+	return count;
+}
+
+RenderCommandBuffer::~RenderCommandBuffer() {
+}
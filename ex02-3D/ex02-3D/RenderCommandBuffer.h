@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+
+#include "LinearAllocator.h"
+
+/*
+Deferred GL submission. Worker threads record draws into their own RenderCommandBuffer (plain structs in a
+linear allocator, no GL calls); the GL thread then replays every buffer in sort key order.
+
+	buffer.beginPacket(RenderCommandBuffer::MakeSortKey(program, texture, vao));
+	buffer.setProgram(program);
+	buffer.bindVertexArray(vao);
+	buffer.bindUniformRange(OBJECT_BLOCK_BINDING, ringBuffer, offset, sizeof(ObjectBlock));
+	buffer.drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+	buffer.endPacket();
+
+A packet is the unit of sorting: its commands stay together and in order. During replay, state that is
+already bound (same program, VAO or texture as the previous packet) is skipped
+*/
+
+enum RenderCommandType
+{
+	COMMAND_SET_PROGRAM,
+	COMMAND_BIND_VERTEX_ARRAY,
+	COMMAND_BIND_UNIFORM_RANGE,
+	COMMAND_BIND_TEXTURE,
+	COMMAND_DRAW_ELEMENTS
+};
+
+// 32 bytes, copied around by value
+struct RenderCommand
+{
+	GLuint type; // RenderCommandType
+	union
+	{
+		struct { GLuint program; } setProgram;
+		struct { GLuint vao; GLuint ibo; } bindVertexArray;
+		struct { GLuint binding; GLuint buffer; GLintptr offset; GLsizeiptr size; } bindUniformRange;
+		struct { GLenum unit; GLenum target; GLuint texture; } bindTexture;
+		struct { GLenum mode; GLsizei count; GLenum indexType; GLintptr indexOffset; } drawElements;
+	};
+};
+
+// Commands of one draw, sorted as a whole
+struct RenderPacket
+{
+	GLuint64 sortKey;
+	RenderCommand* commands; // In the allocator of the buffer that recorded it
+	GLuint commandCount;
+	GLuint order; // Position in recording order (set by Replay), breaks ties between equal keys
+};
+
+class RenderCommandBuffer
+{
+public:
+	static const GLuint MAX_PACKET_COMMANDS = 8;
+
+	RenderCommandBuffer();
+	~RenderCommandBuffer();
+
+	void reset(); // Drops the recorded packets (start of the frame)
+
+	void beginPacket(GLuint64 sortKey);
+	void setProgram(GLuint program);
+	void bindVertexArray(GLuint vao, GLuint ibo);
+	void bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void bindTexture(GLenum unit, GLenum target, GLuint texture);
+	void drawElements(GLenum mode, GLsizei count, GLenum indexType, GLintptr indexOffset);
+	void endPacket();
+
+	const std::vector<RenderPacket>& getPackets() { return packets; };
+
+	// Program in the top bits so the most expensive switches happen the least, then texture, then VAO
+	static GLuint64 MakeSortKey(GLuint program, GLuint texture, GLuint vao) {
+		return ((GLuint64)(program & 0xFFFF) << 48) | ((GLuint64)(texture & 0xFFFFFF) << 24) | (GLuint64)(vao & 0xFFFFFF);
+	};
+
+	// Merges the packets of every buffer, sorts them by key and issues the GL calls (GL thread only).
+	// 'sorted' is scratch storage kept by the caller between frames
+	static void Replay(RenderCommandBuffer** buffers, size_t bufferCount, std::vector<RenderPacket>& sorted);
+	// Commands dropped (packet full or no packet open) by the buffers replayed since the last call. GL thread only
+	static unsigned int takeDroppedCommands();
+
+private:
+	static unsigned int droppedCommands; // Added up by Replay
+
+	LinearAllocator allocator;
+	std::vector<RenderPacket> packets;
+	RenderPacket current; // Packet being recorded
+	unsigned int dropped; // Since reset(), owner only
+	RenderCommand* push(GLuint type);
+};
@@ -0,0 +1,29 @@
+#include "RenderStats.h"
+
+unsigned int RenderStats::drawCalls = 0;
+unsigned int RenderStats::objects = 0;
+unsigned int RenderStats::triangles = 0;
+unsigned int RenderStats::stateChanges = 0;
+unsigned int RenderStats::uniformUploads = 0;
+unsigned int RenderStats::uniformsSkipped = 0;
+
+void RenderStats::beginFrame() {
+	drawCalls = 0;
+	objects = 0;
+	triangles = 0;
+	stateChanges = 0;
+	uniformUploads = 0;
+	uniformsSkipped = 0;
+}
+
+void RenderStats::addDrawCall(GLsizei indexCount) {
+	drawCalls++;
+	objects++;
+	triangles += indexCount / 3;
+}
+
+void RenderStats::addMultiDraw(GLsizei drawCount, GLsizei indexCount) {
+	drawCalls++; // The whole batch is submitted by a single call
+	objects += drawCount;
+	triangles += indexCount / 3;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <GL\glew.h>
+
+// Per-frame render counters. Every path that issues a draw reports to it, so the
+// classic per-object loop and the indirect path can be compared on equal terms
+class RenderStats
+{
+public:
+	static void beginFrame(); // Reset the counters at the start of every frame
+	static void addDrawCall(GLsizei indexCount); // One glDraw* call with 'indexCount' indices
+	static void addMultiDraw(GLsizei drawCount, GLsizei indexCount); // One glMultiDraw* call covering 'drawCount' objects
+	static void addStateChange(unsigned int count = 1) { stateChanges += count; }; // Binds (program, VAO, texture, buffer range) actually issued
+	// A uniform set through Shader::setUniform: sent to the driver, or skipped because its value did not change
+	static void addUniformSet(bool uploaded) { if (uploaded) uniformUploads++; else uniformsSkipped++; };
+
+	static unsigned int getDrawCalls() { return drawCalls; };
+	static unsigned int getObjects() { return objects; };
+	static unsigned int getTriangles() { return triangles; };
+	static unsigned int getStateChanges() { return stateChanges; };
+	static unsigned int getUniformUploads() { return uniformUploads; };
+	static unsigned int getUniformsSkipped() { return uniformsSkipped; };
+
+private:
+	static unsigned int drawCalls; // API calls issued to the driver
+	static unsigned int objects; // Objects rendered by those calls
+	static unsigned int triangles;
+	static unsigned int stateChanges;
+	static unsigned int uniformUploads;
+	static unsigned int uniformsSkipped;
+};
+
@@ -0,0 +1,116 @@
+#include "Scene.h"
+#include "JobSystem.h"
+
+Scene::Scene() {}
+
+Entity Scene::allocateEntity() {
+	Entity entity;
+	if (!freeSlots.empty()) {
+		entity.index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		entity.index = (GLuint)records.size();
+		EntityRecord record = { NULL, NULL, 0, 0 };
+		records.push_back(record);
+	}
+	entity.generation = records[entity.index].generation;
+	return entity;
+}
+
+bool Scene::isAlive(Entity entity) {
+	return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+		records[entity.index].archetype != NULL;
+}
+
+Archetype* Scene::findOrCreateArchetype(ComponentMask mask) {
+	for (size_t i = 0; i < archetypes.size(); i++) {
+		if (archetypes[i]->getMask() == mask) {
+			return archetypes[i];
+		}
+	}
+	Archetype* archetype = new Archetype(mask);
+	archetypes.push_back(archetype);
+	return archetype;
+}
+
+void Scene::placeEntity(Entity entity, Archetype* archetype) {
+	EntityRecord& record = records[entity.index];
+	record.archetype = archetype;
+	archetype->allocateRow(entity, record.chunk, record.row);
+}
+
+void Scene::removeFromArchetype(EntityRecord& record, bool destroyComponents) {
+	Entity movedEntity;
+	if (record.archetype->removeRow(record.chunk, record.row, destroyComponents, movedEntity)) {
+		// The last row of the archetype now lives where the removed one was
+		records[movedEntity.index].chunk = record.chunk;
+		records[movedEntity.index].row = record.row;
+	}
+}
+
+void Scene::moveEntity(Entity entity, Archetype* target) {
+	EntityRecord& record = records[entity.index];
+	Archetype* source = record.archetype;
+	Chunk* sourceChunk = record.chunk;
+	GLuint sourceRow = record.row;
+
+	Chunk* targetChunk;
+	GLuint targetRow;
+	target->allocateRow(entity, targetChunk, targetRow);
+
+	// Move what both archetypes share; components the target does not have were already destroyed by the caller
+	ComponentMask shared = source->getMask() & target->getMask();
+	for (unsigned int typeID = 0; typeID < MAX_COMPONENT_TYPES; typeID++) {
+		if (shared & ((ComponentMask)1 << typeID)) {
+			GetComponentInfo(typeID).moveConstruct(target->getComponent(targetChunk, targetRow, typeID),
+												source->getComponent(sourceChunk, sourceRow, typeID));
+		}
+	}
+
+	// Every component of the old row is now either moved out or destroyed: remove it without destroying
+	removeFromArchetype(record, false);
+	record.archetype = target;
+	record.chunk = targetChunk;
+	record.row = targetRow;
+}
+
+void Scene::destroyEntity(Entity entity) {
+	if (!isAlive(entity)) {
+		return;
+	}
+	EntityRecord& record = records[entity.index];
+	removeFromArchetype(record, true);
+	record.archetype = NULL;
+	record.chunk = NULL;
+	record.generation++; // Old handles to this slot are now stale
+	freeSlots.push_back(entity.index);
+}
+
+void Scene::collectChunks(ComponentMask mask) {
+	queryChunks.clear();
+	for (size_t a = 0; a < archetypes.size(); a++) {
+		if ((archetypes[a]->getMask() & mask) != mask) {
+			continue;
+		}
+		for (size_t c = 0; c < archetypes[a]->getChunkCount(); c++) {
+			ChunkRef ref = { archetypes[a], archetypes[a]->getChunk(c) };
+			queryChunks.push_back(ref);
+		}
+	}
+}
+
+void Scene::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+	// One job per chunk: chunks are already a good unit of work (up to 16 KB of components each)
+	JobSystem::parallelFor("Scene chunk", count, 1, [&job](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			job(i);
+		}
+	});
+}
+
+Scene::~Scene() {
+	for (size_t i = 0; i < archetypes.size(); i++) {
+		delete archetypes[i];
+	}
+}
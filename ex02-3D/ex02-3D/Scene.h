@@ -0,0 +1,192 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <GL\glew.h>
+
+#include "Archetype.h"
+
+/*
+Archetype-based entity/component storage. Entities with the same set of components share an archetype and
+their components are stored SoA in fixed-size chunks, so systems walk plain arrays.
+
+	Entity e = scene.createEntity(Transform{ node }, MeshRef{ 0 });
+	scene.forEachChunk<Transform, MeshRef>([](GLuint count, Entity* entities, Transform* transforms, MeshRef* meshes) { ... });
+*/
+class Scene
+{
+public:
+	Scene();
+	~Scene();
+
+	template <typename... Ts>
+	Entity createEntity(Ts... components);
+	void destroyEntity(Entity entity);
+	bool isAlive(Entity entity);
+
+	template <typename T>
+	T* getComponent(Entity entity);
+	template <typename T>
+	void addComponent(Entity entity, T component);
+	template <typename T>
+	void removeComponent(Entity entity);
+
+	// Calls func(count, entities, Ts* arrays...) once per chunk holding all of Ts
+	template <typename... Ts, typename Func>
+	void forEachChunk(Func func);
+	// Calls func(entity, Ts&...) once per matching entity
+	template <typename... Ts, typename Func>
+	void forEach(Func func);
+	// Same as forEachChunk, but chunks are spread over worker threads. func(chunkIndex, count, entities, Ts*...)
+	// gets the index of the chunk in the query, so results can be written to disjoint ranges
+	template <typename... Ts, typename Func>
+	void forEachChunkParallel(Func func);
+	// Number of entities holding all of Ts
+	template <typename... Ts>
+	size_t count();
+	// Entity counts of the matching chunks, in the order the chunk queries visit them (any vector of GLuint)
+	template <typename... Ts, typename Counts>
+	void chunkCounts(Counts& counts);
+
+private:
+	struct EntityRecord
+	{
+		Archetype* archetype;
+		Chunk* chunk;
+		GLuint row;
+		GLuint generation;
+	};
+
+	struct ChunkRef
+	{
+		Archetype* archetype;
+		Chunk* chunk;
+	};
+
+	std::vector<EntityRecord> records;
+	std::vector<GLuint> freeSlots;
+	std::vector<Archetype*> archetypes;
+	std::vector<ChunkRef> queryChunks; // Scratch list for the parallel queries
+
+	template <typename... Ts>
+	static ComponentMask maskOf();
+
+	Entity allocateEntity();
+	Archetype* findOrCreateArchetype(ComponentMask mask);
+	void placeEntity(Entity entity, Archetype* archetype); // Reserves a row in 'archetype' and updates the record
+	void moveEntity(Entity entity, Archetype* target); // Moves the shared components, new ones stay uninitialized
+	void removeFromArchetype(EntityRecord& record, bool destroyComponents);
+	void collectChunks(ComponentMask mask);
+	// Runs job(i) for i in [0, count) on the job system (see JobSystem.h)
+	static void parallelFor(size_t count, const std::function<void(size_t)>& job);
+};
+
+/********************************
+*	Template implementations
+*********************************/
+template <typename... Ts>
+ComponentMask Scene::maskOf() {
+	ComponentMask mask = 0;
+	int expand[] = { 0, (mask |= ComponentBit<Ts>(), 0)... };
+	(void)expand;
+	return mask;
+}
+
+template <typename... Ts>
+Entity Scene::createEntity(Ts... components) {
+	Entity entity = allocateEntity();
+	Archetype* archetype = findOrCreateArchetype(maskOf<Ts...>());
+	placeEntity(entity, archetype);
+
+	EntityRecord& record = records[entity.index];
+	// Placement-new every component in its array
+	int expand[] = { 0, (new (archetype->getComponent(record.chunk, record.row, ComponentTypeID<Ts>())) Ts(static_cast<Ts&&>(components)), 0)... };
+	(void)expand;
+	return entity;
+}
+
+template <typename T>
+T* Scene::getComponent(Entity entity) {
+	if (!isAlive(entity)) {
+		return NULL;
+	}
+	EntityRecord& record = records[entity.index];
+	if (!record.archetype->hasComponent(ComponentTypeID<T>())) {
+		return NULL;
+	}
+	return static_cast<T*>(record.archetype->getComponent(record.chunk, record.row, ComponentTypeID<T>()));
+}
+
+template <typename T>
+void Scene::addComponent(Entity entity, T component) {
+	if (!isAlive(entity)) {
+		return;
+	}
+	T* existing = getComponent<T>(entity);
+	if (existing) {
+		*existing = component;
+		return;
+	}
+	EntityRecord& record = records[entity.index];
+	moveEntity(entity, findOrCreateArchetype(record.archetype->getMask() | ComponentBit<T>()));
+	new (record.archetype->getComponent(record.chunk, record.row, ComponentTypeID<T>())) T(static_cast<T&&>(component));
+}
+
+template <typename T>
+void Scene::removeComponent(Entity entity) {
+	T* existing = getComponent<T>(entity);
+	if (!existing) {
+		return;
+	}
+	existing->~T(); // Destroyed here, moveEntity only moves the components the target archetype keeps
+	EntityRecord& record = records[entity.index];
+	moveEntity(entity, findOrCreateArchetype(record.archetype->getMask() & ~ComponentBit<T>()));
+}
+
+template <typename... Ts, typename Func>
+void Scene::forEachChunk(Func func) {
+	ComponentMask mask = maskOf<Ts...>();
+	for (size_t a = 0; a < archetypes.size(); a++) {
+		Archetype* archetype = archetypes[a];
+		if ((archetype->getMask() & mask) != mask) {
+			continue;
+		}
+		for (size_t c = 0; c < archetype->getChunkCount(); c++) {
+			Chunk* chunk = archetype->getChunk(c);
+			func(chunk->count, archetype->getEntities(chunk), static_cast<Ts*>(archetype->getComponentArray(chunk, ComponentTypeID<Ts>()))...);
+		}
+	}
+}
+
+template <typename... Ts, typename Func>
+void Scene::forEach(Func func) {
+	forEachChunk<Ts...>([&func](GLuint count, Entity* entities, Ts*... arrays) {
+		for (GLuint i = 0; i < count; i++) {
+			func(entities[i], arrays[i]...);
+		}
+	});
+}
+
+template <typename... Ts, typename Func>
+void Scene::forEachChunkParallel(Func func) {
+	collectChunks(maskOf<Ts...>());
+	const std::vector<ChunkRef>& chunks = queryChunks;
+	parallelFor(chunks.size(), [&chunks, &func](size_t i) {
+		Archetype* archetype = chunks[i].archetype;
+		Chunk* chunk = chunks[i].chunk;
+		func(i, chunk->count, archetype->getEntities(chunk), static_cast<Ts*>(archetype->getComponentArray(chunk, ComponentTypeID<Ts>()))...);
+	});
+}
+
+template <typename... Ts>
+size_t Scene::count() {
+	size_t total = 0;
+	forEachChunk<Ts...>([&total](GLuint chunkCount, Entity*, Ts*...) { total += chunkCount; });
+	return total;
+}
+
+template <typename... Ts, typename Counts>
+void Scene::chunkCounts(Counts& counts) {
+	counts.clear();
+	forEachChunk<Ts...>([&counts](GLuint chunkCount, Entity*, Ts*...) { counts.push_back(chunkCount); });
+}
+
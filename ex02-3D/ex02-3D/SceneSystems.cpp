@@ -0,0 +1,68 @@
+#include <algorithm>
+#include "SceneSystems.h"
+#include "FrameArena.h"
+
+void UpdateFlashlights(Scene& scene, Camera& camera) {
+	glm::vec3 position = camera.getCameraPosition();
+	glm::vec3 direction = camera.getCameraDirection();
+	scene.forEach<SpotLightComponent>([&position, &direction](Entity, SpotLightComponent& spot) {
+		if (spot.attachedToCamera) {
+			spot.light.SetFlash(position, direction);
+		}
+	});
+}
+
+static bool DrawItemOrder(const DrawItem& a, const DrawItem& b) {
+	if (a.texture != b.texture) return a.texture < b.texture;
+	if (a.material != b.material) return a.material < b.material;
+	return a.mesh < b.mesh;
+}
+
+void BuildDrawList(Scene& scene, TransformHierarchy& transforms, std::vector<DrawItem>& drawList, GLfloat alpha) {
+	// Each chunk writes its own range of the list, so the chunks can be filled in parallel without locks.
+	// The counts and starts only live for this call: frame arena
+	FrameVector<GLuint> chunkCounts;
+	FrameVector<size_t> chunkStarts;
+	scene.chunkCounts<Transform, MeshRef, MaterialRef, TextureRef>(chunkCounts);
+	chunkStarts.resize(chunkCounts.size());
+	size_t total = 0;
+	for (size_t i = 0; i < chunkCounts.size(); i++) {
+		chunkStarts[i] = total;
+		total += chunkCounts[i];
+	}
+	drawList.resize(total);
+
+	DrawItem* items = drawList.data();
+	scene.forEachChunkParallel<Transform, MeshRef, MaterialRef, TextureRef>(
+		[items, &chunkStarts, &transforms, alpha](size_t chunkIndex, GLuint count, Entity*, Transform* transform, MeshRef* mesh, MaterialRef* material, TextureRef* texture) {
+			DrawItem* out = items + chunkStarts[chunkIndex];
+			for (GLuint i = 0; i < count; i++) {
+				out[i].model = transforms.getInterpolatedMatrix(transform[i].node, alpha);
+				out[i].mesh = mesh[i].mesh;
+				out[i].material = material[i].material;
+				out[i].texture = texture[i].texture;
+				out[i].textureLayer = texture[i].layer;
+			}
+		});
+
+	std::sort(drawList.begin(), drawList.end(), DrawItemOrder);
+}
+
+void GatherLights(Scene& scene, SceneLights& lights) {
+	lights.pointLightsCount = 0;
+	lights.spotLightsCount = 0;
+
+	scene.forEach<DirectionalLightComponent>([&lights](Entity, DirectionalLightComponent& directional) {
+		lights.directionalLight = directional.light; // The shaders support a single directional light
+	});
+	scene.forEach<PointLightComponent>([&lights](Entity, PointLightComponent& point) {
+		if (lights.pointLightsCount < MAX_POINT_LIGHTS) {
+			lights.pointLights[lights.pointLightsCount++] = point.light;
+		}
+	});
+	scene.forEach<SpotLightComponent>([&lights](Entity, SpotLightComponent& spot) {
+		if (lights.spotLightsCount < MAX_SPOT_LIGHTS) {
+			lights.spotLights[lights.spotLightsCount++] = spot.light;
+		}
+	});
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+#include "CommonValues.h"
+#include "Scene.h"
+#include "Components.h"
+#include "TransformHierarchy.h"
+#include "Camera.h"
+
+// One object to render, produced by the render system from the scene
+struct DrawItem
+{
+	glm::mat4 model;
+	GLuint mesh;
+	Material* material;
+	Texture* texture;
+	GLint textureLayer;
+};
+
+// Lights gathered from the scene in the arrays the Shader setters expect
+struct SceneLights
+{
+	DirectionalLight directionalLight;
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	unsigned int pointLightsCount;
+	SpotLight spotLights[MAX_SPOT_LIGHTS];
+	unsigned int spotLightsCount;
+};
+
+// Moves the spot lights attached to the camera (flashlight)
+void UpdateFlashlights(Scene& scene, Camera& camera);
+
+// Render system: one DrawItem per entity with Transform + MeshRef + MaterialRef + TextureRef, sorted by
+// texture, material and mesh so consecutive draws share state. Chunks are processed in parallel.
+// 'alpha' < 1 interpolates the model matrices between the last two simulation steps
+void BuildDrawList(Scene& scene, TransformHierarchy& transforms, std::vector<DrawItem>& drawList, GLfloat alpha = 1.0f);
+
+// Light system: copies the light components into 'lights' (extra lights beyond the MAX_* limits are dropped)
+void GatherLights(Scene& scene, SceneLights& lights);
+
@@ -1,19 +1,33 @@
 #include "Shader.h"
+#include "GpuMemoryTracker.h"
+#include "RenderStats.h"
+#include "ShaderPreprocessor.h"
+
+#include <glm\gtc\type_ptr.hpp>
 
 Shader::Shader() {
 	shaderID = 0;
-	uniformModel = 0;
-	uniformProjection = 0;
+	uniformModel = NO_UNIFORM;
+	uniformProjection = NO_UNIFORM;
+	uniformBlockObject = GL_INVALID_INDEX;
+	computeOnly = false;
+	pendingKey = 0;
 	//uniformView = 0;
 }
 
 Shader::~Shader() {
+	ClearShader();
+}
+
+void Shader::ClearShader() {
 	if (shaderID != 0) {
+		GpuMemoryTracker::releaseObject(GL_PROGRAM, shaderID);
 		glDeleteProgram(shaderID);
 		shaderID = 0;
 	}
-	uniformModel = 0;
-	uniformProjection = 0;
+	uniforms.clearTable();
+	uniformModel = NO_UNIFORM;
+	uniformProjection = NO_UNIFORM;
 	//uniformView = 0;
 }
 
@@ -23,140 +37,294 @@ void Shader::UseProgram() {
 
 // Public access to the compiling method
 void Shader::CreateFromString(const char* vertexCode, const char* fragmentCode) {
-	CreateShader(vertexCode, fragmentCode);
+	CreateShader(vertexCode, fragmentCode, "Shader program");
 }
 
-void Shader::CreateFromFile(const char* vertexLocation, const char* fragmentLocation) {
-	std::string vertexString = ReadFile(vertexLocation);
-	std::string fragmentString = ReadFile(fragmentLocation);
-
-	const char* vertexCode = vertexString.c_str(); // String to char* convertion
-	const char* fragmentCode = fragmentString.c_str();
-
-	CreateShader(vertexCode, fragmentCode);
+void Shader::CreateFromFile(const char* vertexLocation, const char* fragmentLocation, const char* variantDefines) {
+	this->variantDefines = variantDefines ? variantDefines : "";
+	std::string vertexCode, fragmentCode;
+	std::vector<std::string> vertexFiles, fragmentFiles;
+	if (!ShaderPreprocessor::expandFile(vertexLocation, variantDefines, vertexCode, &vertexFiles) ||
+		!ShaderPreprocessor::expandFile(fragmentLocation, variantDefines, fragmentCode, &fragmentFiles)) {
+		return;
+	}
+	if (!CreateShader(vertexCode.c_str(), fragmentCode.c_str(), vertexLocation)) {
+		// The compile errors number the files of each stage
+		printf("Vertex shader sources: %s\nFragment shader sources: %s\n", ShaderPreprocessor::describeSources(vertexFiles).c_str(),
+			ShaderPreprocessor::describeSources(fragmentFiles).c_str());
+	}
 }
 
-std::string Shader::ReadFile(const char* fileLocation) {
-	std::string content = "";
-	std::ifstream fileStream(fileLocation, std::ios::in);
-
-	if (!fileStream.is_open()) {
-		printf("Error while trying to open the following file: '%s'\n", fileLocation);
-		return "";
+void Shader::CreateComputeFromFile(const char* computeLocation, const char* variantDefines) {
+	this->variantDefines = variantDefines ? variantDefines : "";
+	std::string computeCode;
+	std::vector<std::string> computeFiles;
+	if (!ShaderPreprocessor::expandFile(computeLocation, variantDefines, computeCode, &computeFiles)) {
+		return;
 	}
-
-	std::string line;
-	while (!fileStream.eof()) {
-		std::getline(fileStream, line);
-		content.append(line + '\n');
+	if (!CreateComputeShader(computeCode.c_str(), computeLocation)) {
+		printf("Compute shader sources: %s\n", ShaderPreprocessor::describeSources(computeFiles).c_str());
 	}
+}
+
+bool Shader::CreateShader(const char* vertexCode, const char* fragmentCode, const char* debugName) {
+	// The steps of a background build, without doing anything in between
+	return startCreate(vertexCode, fragmentCode, debugName) && finishCreate();
+}
 
-	fileStream.close();
-	return content;
+bool Shader::CreateComputeShader(const char* computeCode, const char* debugName) {
+	return startCreateCompute(computeCode, debugName) && finishCreate();
 }
 
-void Shader::CreateShader(const char* vertexCode, const char* fragmentCode) {
+bool Shader::startCreate(const char* vertexCode, const char* fragmentCode, const char* debugName, bool useCache) {
 	shaderID = glCreateProgram(); // Program ID in the GPU
 	if (!shaderID) {
 		printf("Error while creating shader program\n");
-		return;
+		return false;
 	}
+	GpuMemoryTracker::trackObject(GL_PROGRAM, shaderID, GPU_MEMORY_PROGRAM, 0, debugName);
+	computeOnly = false;
+	programName = debugName;
+
+	// Create the Vertex and Fragment Shaders, attach them to the program and link it
+	GLenum stageTypes[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* stageCodes[] = { vertexCode, fragmentCode };
+	StartProgram(stageTypes, stageCodes, 2, useCache);
+	return true;
+}
 
-	CompileShader(GL_VERTEX_SHADER, vertexCode); // Create Vertex Shader and attach it to the program
-	CompileShader(GL_FRAGMENT_SHADER, fragmentCode); // Create Fragment Shader and attach it to the program
+bool Shader::startCreateCompute(const char* computeCode, const char* debugName, bool useCache) {
+	shaderID = glCreateProgram();
+	if (!shaderID) {
+		printf("Error while creating compute program\n");
+		return false;
+	}
+	GpuMemoryTracker::trackObject(GL_PROGRAM, shaderID, GPU_MEMORY_PROGRAM, 0, debugName);
+	computeOnly = true; // A compute program has no light/material uniforms to look up
+	programName = debugName;
 
-	// Link the program
-	glLinkProgram(shaderID);
-	// Check if the link went OK
-	GLint returnCode = 0;
-	glGetProgramiv(shaderID, GL_LINK_STATUS, &returnCode); // Returns the linking status to our returnCode variable
-	if (!returnCode) {
-		GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
-		glGetProgramInfoLog(shaderID, sizeof(log), NULL, log); // Get error log
-		printf("Program linking error: '%s'\n", log);
-		return;
+	GLenum stageType = GL_COMPUTE_SHADER;
+	StartProgram(&stageType, &computeCode, 1, useCache);
+	return true;
+}
+
+bool Shader::isBuildComplete() {
+	if (!shaderID || !GLEW_ARB_parallel_shader_compile) {
+		return true; // Without the extension the driver finished in glLinkProgram
 	}
+	GLint complete = GL_TRUE;
+	glGetProgramiv(shaderID, GL_COMPLETION_STATUS_ARB, &complete); // Does not wait for the compiler threads
+	return complete == GL_TRUE;
+}
 
-	// Program validation (last step in the pipeline)
-	glValidateProgram(shaderID);
-	returnCode = 0;
-	glGetProgramiv(shaderID, GL_VALIDATE_STATUS, &returnCode); // Returns the validation status to our returnCode variable
-	if (!returnCode) {
-		GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
-		glGetProgramInfoLog(shaderID, sizeof(log), NULL, log); // Get error log
-		printf("Program validation error: '%s'\n", log);
-		return;
+bool Shader::finishCreate() {
+	if (!shaderID || !FinishProgram()) {
+		return false;
+	}
+	uniforms.reflect(shaderID, programName.c_str());
+	if (!computeOnly) {
+		GetUniformLocations();
 	}
+	return true;
+}
 
-	// Get the uniform variables in the compiled shaders and store them in memory
-	uniformProjection = glGetUniformLocation(shaderID, "projection"); // Searches for the 'projection' variable in the shader program
-	uniformModel = glGetUniformLocation(shaderID, "model"); // Searches for the 'model' variable in the shader program
-	uniformView = glGetUniformLocation(shaderID, "view"); // Searches for the 'view' variable in the shader program
+void Shader::adoptProgram(Shader& other) {
+	std::string defines = variantDefines;
+	ClearShader();
+	*this = other; // The program and every uniform location
+	variantDefines = defines;
+	other.shaderID = 0; // Owned here now, not deleted with 'other'
+}
+
+void Shader::GetUniformLocations() {
+	// Looked up in the table of the linked program (names it does not have come back as -1)
+	uniformProjection = uniforms.find("projection", GL_FLOAT_MAT4);
+	uniformModel = uniforms.find("model", GL_FLOAT_MAT4);
+	uniformView = uniforms.find("view", GL_FLOAT_MAT4);
+	uniformEyePosition = uniforms.find("eyePosition", GL_FLOAT_VEC3);
 	// Ambient Light
-	uniformDirectionalLight.uniformAmbientColor = glGetUniformLocation(shaderID, "directionalLight.base.color");
-	uniformDirectionalLight.uniformAmbientIntensity = glGetUniformLocation(shaderID, "directionalLight.base.ambientIntensity");
+	uniformDirectionalLight.uniformAmbientColor = uniforms.find("directionalLight.base.color", GL_FLOAT_VEC3);
+	uniformDirectionalLight.uniformAmbientIntensity = uniforms.find("directionalLight.base.ambientIntensity", GL_FLOAT);
 	// Diffuse Light
-	uniformDirectionalLight.uniformDirection = glGetUniformLocation(shaderID, "directionalLight.direction");
-	uniformDirectionalLight.uniformDiffuseIntensity = glGetUniformLocation(shaderID, "directionalLight.base.diffuseIntensity");
+	uniformDirectionalLight.uniformDirection = uniforms.find("directionalLight.direction", GL_FLOAT_VEC3);
+	uniformDirectionalLight.uniformDiffuseIntensity = uniforms.find("directionalLight.base.diffuseIntensity", GL_FLOAT);
 	// Specular Light
-	uniformSpecularIntensity = glGetUniformLocation(shaderID, "material.specularIntensity");
-	uniformShininess = glGetUniformLocation(shaderID, "material.shininess");
+	uniformSpecularIntensity = uniforms.find("material.specularIntensity", GL_FLOAT);
+	uniformShininess = uniforms.find("material.shininess", GL_FLOAT);
+	// Per-object block (model + material) written to the UniformRingBuffer. GLSL 330 has no 'binding' qualifier,
+	// so the block is attached to its binding point here
+	uniformBlockObject = glGetUniformBlockIndex(shaderID, "ObjectBlock");
+	if (uniformBlockObject != GL_INVALID_INDEX) {
+		glUniformBlockBinding(shaderID, uniformBlockObject, OBJECT_BLOCK_BINDING);
+	}
 	// Point Light
-	uniformPointLightsCount = glGetUniformLocation(shaderID, "pointLightsCount");
+	uniformPointLightsCount = uniforms.find("pointLightsCount", GL_INT);
 	for (int i = 0; i < MAX_POINT_LIGHTS; i++) {
 		char locBuff[100] = { "\0" };
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.ambientIntensity", i);
-		uniformPointLights[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformAmbientIntensity = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.color", i);
-		uniformPointLights[i].uniformAmbientColor = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformAmbientColor = uniforms.find(locBuff, GL_FLOAT_VEC3);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.diffuseIntensity", i);
-		uniformPointLights[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformDiffuseIntensity = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].position", i);
-		uniformPointLights[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformPosition = uniforms.find(locBuff, GL_FLOAT_VEC3);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].constant", i);
-		uniformPointLights[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformConstant = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].linear", i);
-		uniformPointLights[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformLinear = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "pointLights[%d].exponent", i);
-		uniformPointLights[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+		uniformPointLights[i].uniformExponent = uniforms.find(locBuff, GL_FLOAT);
 	}
 	// Spot Light
-	uniformSpotLightsCount = glGetUniformLocation(shaderID, "spotLightsCount");
+	uniformSpotLightsCount = uniforms.find("spotLightsCount", GL_INT);
 	for (int i = 0; i < MAX_SPOT_LIGHTS; i++) {
 		char locBuff[100] = { "\0" };
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.base.ambientIntensity", i);
-		uniformSpotLights[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformAmbientIntensity = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.base.color", i);
-		uniformSpotLights[i].uniformAmbientColor = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformAmbientColor = uniforms.find(locBuff, GL_FLOAT_VEC3);
 
-		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.diffuseIntensity", i);
-		uniformSpotLights[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
+		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.base.diffuseIntensity", i);
+		uniformSpotLights[i].uniformDiffuseIntensity = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.position", i);
-		uniformSpotLights[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformPosition = uniforms.find(locBuff, GL_FLOAT_VEC3);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].direction", i);
-		uniformSpotLights[i].uniformDirection = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformDirection = uniforms.find(locBuff, GL_FLOAT_VEC3);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.constant", i);
-		uniformSpotLights[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformConstant = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.linear", i);
-		uniformSpotLights[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformLinear = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].point.exponent", i);
-		uniformSpotLights[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformExponent = uniforms.find(locBuff, GL_FLOAT);
 
 		snprintf(locBuff, sizeof(locBuff), "spotLights[%d].edge", i);
-		uniformSpotLights[i].uniformEdge = glGetUniformLocation(shaderID, locBuff);
+		uniformSpotLights[i].uniformEdge = uniforms.find(locBuff, GL_FLOAT);
+	}
+}
+
+// Binaries only fit the driver that made them: its name and version are part of the key with every source.
+// 0 (not cached) without a binary format to store programs in
+static uint64_t GetProgramKey(const GLenum* stageTypes, const char* const* stageCodes, int stageCount) {
+	GLint formatCount = 0;
+	if (GLEW_ARB_get_program_binary) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	}
+	if (formatCount <= 0) {
+		return 0;
 	}
+	uint64_t key = AssetCache::hashString("Program binary 1");
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (int i = 0; i < 3; i++) {
+		const char* driverString = (const char*)glGetString(driverStrings[i]);
+		key = AssetCache::hashString(driverString ? driverString : "", key);
+	}
+	for (int i = 0; i < stageCount; i++) {
+		key = AssetCache::hashBytes(&stageTypes[i], sizeof(stageTypes[i]), key);
+		key = AssetCache::hashString(stageCodes[i], key);
+	}
+	return key;
+}
+
+void Shader::StartProgram(const GLenum* stageTypes, const char* const* stageCodes, int stageCount, bool useCache) {
+	AssetCache* cache = useCache ? AssetCache::getMounted() : NULL;
+	pendingKey = cache ? GetProgramKey(stageTypes, stageCodes, stageCount) : 0;
+	if (pendingKey != 0) {
+		AssetPack entry;
+		GLenum binaryFormat;
+		GLsizei binarySize;
+		const void* binary = cache->find(pendingKey, entry) ? entry.getProgramBinary("program", binaryFormat, binarySize) : NULL;
+		if (binary) {
+			glProgramBinary(shaderID, binaryFormat, binary, binarySize);
+			GLint returnCode = 0;
+			glGetProgramiv(shaderID, GL_LINK_STATUS, &returnCode);
+			if (returnCode) {
+				pendingKey = 0; // Nothing to store
+				return;
+			}
+			// Rejected by the driver (updated without changing its version string): compiled and stored again
+		}
+		glProgramParameteri(shaderID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	for (int i = 0; i < stageCount; i++) {
+		CompileShader(stageTypes[i], stageCodes[i]);
+	}
+	// Link the program
+	glLinkProgram(shaderID);
+}
+
+bool Shader::FinishProgram() {
+	// Check if the link went OK
+	GLint returnCode = 0;
+	glGetProgramiv(shaderID, GL_LINK_STATUS, &returnCode); // Returns the linking status to our returnCode variable
+
+	// The compiled stages are not needed anymore (the program keeps its executable). Their errors explain a failed link
+	GLuint stages[4];
+	GLsizei stageCount = 0;
+	glGetAttachedShaders(shaderID, 4, &stageCount, stages);
+	for (GLsizei i = 0; i < stageCount; i++) {
+		GLint compiled = GL_TRUE;
+		glGetShaderiv(stages[i], GL_COMPILE_STATUS, &compiled);
+		if (!compiled) {
+			GLint shaderType = 0;
+			glGetShaderiv(stages[i], GL_SHADER_TYPE, &shaderType);
+			GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
+			glGetShaderInfoLog(stages[i], sizeof(log), NULL, log); // Get error log
+			printf("%d shader compile error: '%s'\n", shaderType, log);
+		}
+		glDetachShader(shaderID, stages[i]);
+		glDeleteShader(stages[i]);
+	}
+	if (!returnCode) {
+		GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
+		glGetProgramInfoLog(shaderID, sizeof(log), NULL, log); // Get error log
+		printf("Program linking error: '%s'\n", log);
+		return false;
+	}
+
+	// Program validation (last step in the pipeline)
+	glValidateProgram(shaderID);
+	returnCode = 0;
+	glGetProgramiv(shaderID, GL_VALIDATE_STATUS, &returnCode); // Returns the validation status to our returnCode variable
+	if (!returnCode) {
+		GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
+		glGetProgramInfoLog(shaderID, sizeof(log), NULL, log); // Get error log
+		printf("Program validation error: '%s'\n", log);
+		return false;
+	}
+
+	// Linked from the sources: stored for the next runs
+	if (pendingKey != 0) {
+		GLint binaryLength = 0;
+		glGetProgramiv(shaderID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		std::vector<unsigned char> binary((size_t)(binaryLength > 0 ? binaryLength : 0));
+		GLenum binaryFormat = 0;
+		GLsizei binarySize = 0;
+		if (!binary.empty()) {
+			glGetProgramBinary(shaderID, binaryLength, &binarySize, &binaryFormat, binary.data());
+		}
+		AssetCache* cache = AssetCache::getMounted();
+		if (binarySize > 0 && cache) {
+			AssetPackWriter writer;
+			writer.addProgram("program", binaryFormat, binary.data(), (size_t)binarySize);
+			cache->store(pendingKey, writer);
+		}
+		pendingKey = 0;
+	}
+	return true;
 }
 
 void Shader::CompileShader(GLenum shaderType, const char* shaderCode) {
@@ -168,43 +336,104 @@ void Shader::CompileShader(GLenum shaderType, const char* shaderCode) {
 	// Here we only have one code, but we could have multiple
 	glShaderSource(shader, 1, code, NULL);
 
-	// Compile the shader
+	// Compile the shader. Its status is only checked once the program is linked (FinishProgram), so with
+	// ARB_parallel_shader_compile the driver compiles in the background
 	glCompileShader(shader);
-	// Check if the compilation went OK
-	GLint returnCode = 0;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &returnCode); // Returns the compilation status to our returnCode variable
-	if (!returnCode) {
-		GLchar log[1024] = { 0 }; // 1024 is the standard max log size. Set to empty string
-		glGetShaderInfoLog(shader, sizeof(log), NULL, log); // Get error log
-		printf("%d shader compile error: '%s'\n", shaderType, log);
-		return;
-	}
 
 	// Attach the executable (shader) to the program (pShader)
 	glAttachShader(shaderID, shader);
 }
 
+/********************************
+*	Uniform uploads
+*********************************/
+bool Shader::ShadowChanged(const UniformHandle& uniform, const void* values, size_t bytes) {
+	if (uniform.location < 0) {
+		return false; // Not in the program, nothing to send
+	}
+	bool changed = uniforms.updateShadow(uniform, values, bytes / sizeof(GLuint));
+	RenderStats::addUniformSet(changed);
+	return changed;
+}
+
+void Shader::setUniform(const UniformHandle& uniform, GLint value) {
+	if (ShadowChanged(uniform, &value, sizeof(value))) {
+		glUniform1i(uniform.location, value);
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, GLuint value) {
+	if (ShadowChanged(uniform, &value, sizeof(value))) {
+		glUniform1ui(uniform.location, value);
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, GLfloat value) {
+	if (ShadowChanged(uniform, &value, sizeof(value))) {
+		glUniform1f(uniform.location, value);
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, const glm::vec2& value) {
+	if (ShadowChanged(uniform, glm::value_ptr(value), sizeof(value))) {
+		glUniform2fv(uniform.location, 1, glm::value_ptr(value));
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, const glm::vec3& value) {
+	if (ShadowChanged(uniform, glm::value_ptr(value), sizeof(value))) {
+		glUniform3fv(uniform.location, 1, glm::value_ptr(value));
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, const glm::vec4* values, GLsizei count) {
+	if (ShadowChanged(uniform, glm::value_ptr(values[0]), sizeof(glm::vec4) * count)) {
+		glUniform4fv(uniform.location, count, glm::value_ptr(values[0]));
+	}
+}
+
+void Shader::setUniform(const UniformHandle& uniform, const glm::mat4& value) {
+	if (ShadowChanged(uniform, glm::value_ptr(value), sizeof(value))) {
+		// Args: (location, number of matrices, should be transposed?, values)
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
 void Shader::setDirectionalLight(DirectionalLight* dLight) {
-	dLight->useLight(uniformDirectionalLight.uniformAmbientIntensity, uniformDirectionalLight.uniformAmbientColor,
-					uniformDirectionalLight.uniformDiffuseIntensity, uniformDirectionalLight.uniformDirection);
+	// Ambient
+	setUniform(uniformDirectionalLight.uniformAmbientIntensity, dLight->getAmbientIntensity());
+	setUniform(uniformDirectionalLight.uniformAmbientColor, dLight->getColor());
+	// Diffuse
+	setUniform(uniformDirectionalLight.uniformDiffuseIntensity, dLight->getDiffuseIntensity());
+	setUniform(uniformDirectionalLight.uniformDirection, dLight->getDirection());
 }
 
 void Shader::setPointLight(PointLight* pLight, unsigned int lightsCount) {
 	if (lightsCount > MAX_POINT_LIGHTS) lightsCount = MAX_POINT_LIGHTS;
-	glUniform1i(uniformPointLightsCount, lightsCount);
+	setUniform(uniformPointLightsCount, (GLint)lightsCount);
 	for (int i=0; i < lightsCount; i++) {
-		pLight[i].UseLight(uniformPointLights[i].uniformAmbientIntensity, uniformPointLights[i].uniformAmbientColor,
-						uniformPointLights[i].uniformDiffuseIntensity, uniformPointLights[i].uniformPosition,
-						uniformPointLights[i].uniformConstant, uniformPointLights[i].uniformLinear, uniformPointLights[i].uniformExponent);
+		setUniform(uniformPointLights[i].uniformAmbientIntensity, pLight[i].getAmbientIntensity());
+		setUniform(uniformPointLights[i].uniformAmbientColor, pLight[i].getColor());
+		setUniform(uniformPointLights[i].uniformDiffuseIntensity, pLight[i].getDiffuseIntensity());
+		setUniform(uniformPointLights[i].uniformPosition, pLight[i].getPosition());
+		setUniform(uniformPointLights[i].uniformConstant, pLight[i].getConstant());
+		setUniform(uniformPointLights[i].uniformLinear, pLight[i].getLinear());
+		setUniform(uniformPointLights[i].uniformExponent, pLight[i].getExponent());
 	}
 }
 
 void Shader::setSpotLight(SpotLight* sLight, unsigned int lightsCount) {
 	if (lightsCount > MAX_SPOT_LIGHTS) lightsCount = MAX_SPOT_LIGHTS;
-	glUniform1i(uniformSpotLightsCount, lightsCount);
+	setUniform(uniformSpotLightsCount, (GLint)lightsCount);
 	for (int i = 0; i < lightsCount; i++) {
-		sLight[i].UseLight(uniformSpotLights[i].uniformAmbientIntensity, uniformSpotLights[i].uniformAmbientColor,
-			uniformSpotLights[i].uniformDiffuseIntensity, uniformSpotLights[i].uniformPosition, uniformSpotLights[i].uniformDirection,
-			uniformSpotLights[i].uniformConstant, uniformSpotLights[i].uniformLinear, uniformSpotLights[i].uniformExponent, uniformSpotLights[i].uniformEdge);
+		setUniform(uniformSpotLights[i].uniformAmbientIntensity, sLight[i].getAmbientIntensity());
+		setUniform(uniformSpotLights[i].uniformAmbientColor, sLight[i].getColor());
+		setUniform(uniformSpotLights[i].uniformDiffuseIntensity, sLight[i].getDiffuseIntensity());
+		setUniform(uniformSpotLights[i].uniformPosition, sLight[i].getPosition());
+		setUniform(uniformSpotLights[i].uniformDirection, sLight[i].getDirection());
+		setUniform(uniformSpotLights[i].uniformConstant, sLight[i].getConstant());
+		setUniform(uniformSpotLights[i].uniformLinear, sLight[i].getLinear());
+		setUniform(uniformSpotLights[i].uniformExponent, sLight[i].getExponent());
+		setUniform(uniformSpotLights[i].uniformEdge, sLight[i].getEdgeCosine());
 	}
 }
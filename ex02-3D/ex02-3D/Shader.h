@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string>
 #include <GL\glew.h>
+#include <glm\glm.hpp>
 
 #include <iostream>
 #include <fstream>
@@ -10,6 +11,18 @@
 #include "DirectionalLight.h"
 #include "PointLight.h"
 #include "SpotLight.h"
+#include "AssetPack.h"
+#include "AssetCache.h"
+#include "UniformTable.h"
+
+// CPU mirror of the 'ObjectBlock' uniform block of the shaders (std140 layout, 80 bytes)
+struct ObjectBlock
+{
+	glm::mat4 model;
+	GLfloat specularIntensity;
+	GLfloat shininess;
+	GLfloat padding[2];
+};
 
 class Shader
 {
@@ -17,59 +30,108 @@ public:
 	Shader();
 	~Shader();
 	void CreateFromString(const char* vertexCode, const char* fragmentCode);
-	void CreateFromFile(const char* vertexLocation, const char* fragmentLocation);
+	// From the mounted asset pack when it has the files (AssetPack::mount), otherwise read from the disk, through the
+	// ShaderPreprocessor (#include, shared defines). 'variantDefines' builds a variant ("#define USE_FOG 1\n").
+	// With a mounted asset cache, programs linked by an earlier run are loaded as binaries instead of compiled
+	void CreateFromFile(const char* vertexLocation, const char* fragmentLocation, const char* variantDefines = NULL);
+	void CreateComputeFromFile(const char* computeLocation, const char* variantDefines = NULL); // Compute-only program (GL 4.3)
+	// Background build (hot reload): startCreate() compiles and links without waiting for the driver (it compiles
+	// on its own threads with ARB_parallel_shader_compile), isBuildComplete() tells when finishCreate() will not
+	// wait either. finishCreate() checks the program and looks its uniforms up. 'useCache' false: no program binary
+	// is looked up in or stored to the asset cache (file reads and writes a frame would wait for). GL thread only
+	bool startCreate(const char* vertexCode, const char* fragmentCode, const char* debugName, bool useCache = true);
+	bool startCreateCompute(const char* computeCode, const char* debugName, bool useCache = true);
+	bool isBuildComplete();
+	bool finishCreate(); // False when it did not compile or link (the errors are printed)
+	// Takes over the program and uniform locations of 'other' (built from the same files and defines), deleting the
+	// current program
+	void adoptProgram(Shader& other);
 	void UseProgram();
+	void ClearShader(); // Deletes the program (also done by the destructor)
 
+	// Any active uniform of the program, from the table read when it linked. 'expectedType' (GL_FLOAT_VEC3...) is
+	// checked against the declaration, a mismatch is printed. Look handles up once, after every (re)build
+	UniformHandle getUniform(const char* name, GLenum expectedType = 0) { return uniforms.find(name, expectedType); };
+	// Typed uploads to the program in use. A value equal to the one the uniform was last set to is not sent again
+	// (RenderStats counts the uploads issued and skipped)
+	void setUniform(const UniformHandle& uniform, GLint value);
+	void setUniform(const UniformHandle& uniform, GLuint value);
+	void setUniform(const UniformHandle& uniform, GLfloat value);
+	void setUniform(const UniformHandle& uniform, const glm::vec2& value);
+	void setUniform(const UniformHandle& uniform, const glm::vec3& value);
+	void setUniform(const UniformHandle& uniform, const glm::vec4* values, GLsizei count);
+	void setUniform(const UniformHandle& uniform, const glm::mat4& value);
+
+	void setProjection(const glm::mat4& projection) { setUniform(uniformProjection, projection); };
+	void setView(const glm::mat4& view) { setUniform(uniformView, view); };
 	void setDirectionalLight(DirectionalLight* dLight);
 	void setPointLight(PointLight* pLight, unsigned int lightsCount);
 	void setSpotLight(SpotLight* sLight, unsigned int lightsCount);
 
 	// Getters
-	GLuint getUniformProjection() { return uniformProjection; };
-	GLuint getUniformModel() { return uniformModel; };
-	GLuint getUniformView() { return uniformView; };
-	GLuint getUniformEyePosition() { return uniformEyePosition; };
-	GLuint getUniformSpecularIntensity() { return uniformSpecularIntensity; };
-	GLuint getUniformShininess() { return uniformShininess; };
+	GLuint getShaderID() { return shaderID; };
+	const std::string& getVariantDefines() { return variantDefines; };
+	GLuint getUniformProjection() { return uniformProjection.location; };
+	GLuint getUniformModel() { return uniformModel.location; };
+	GLuint getUniformView() { return uniformView.location; };
+	GLuint getUniformEyePosition() { return uniformEyePosition.location; };
+	GLuint getUniformSpecularIntensity() { return uniformSpecularIntensity.location; };
+	GLuint getUniformShininess() { return uniformShininess.location; };
+	GLuint getUniformBlockObject() { return uniformBlockObject; };
 
 private:
-	GLuint shaderID, uniformProjection, uniformModel, uniformView, uniformEyePosition,
+	GLuint shaderID, uniformBlockObject;
+	UniformHandle uniformProjection, uniformModel, uniformView, uniformEyePosition,
 		uniformSpecularIntensity, uniformShininess;
 
 	struct
 	{
-		GLuint uniformAmbientIntensity;
-		GLuint uniformAmbientColor;
-		GLuint uniformDiffuseIntensity;
-		GLuint uniformDirection;
+		UniformHandle uniformAmbientIntensity;
+		UniformHandle uniformAmbientColor;
+		UniformHandle uniformDiffuseIntensity;
+		UniformHandle uniformDirection;
 	} uniformDirectionalLight;
 
-	GLuint uniformPointLightsCount;
+	UniformHandle uniformPointLightsCount;
 	struct {
-		GLuint uniformAmbientIntensity;
-		GLuint uniformAmbientColor;
-		GLuint uniformDiffuseIntensity;
-		GLuint uniformPosition;
-		GLuint uniformConstant;
-		GLuint uniformLinear;
-		GLuint uniformExponent;
+		UniformHandle uniformAmbientIntensity;
+		UniformHandle uniformAmbientColor;
+		UniformHandle uniformDiffuseIntensity;
+		UniformHandle uniformPosition;
+		UniformHandle uniformConstant;
+		UniformHandle uniformLinear;
+		UniformHandle uniformExponent;
 	} uniformPointLights[MAX_POINT_LIGHTS]; // We can have more than one point light in a scene
 
-	GLuint uniformSpotLightsCount;
+	UniformHandle uniformSpotLightsCount;
 	struct {
-		GLuint uniformAmbientIntensity;
-		GLuint uniformAmbientColor;
-		GLuint uniformDiffuseIntensity;
-		GLuint uniformPosition;
-		GLuint uniformDirection;
-		GLuint uniformConstant;
-		GLuint uniformLinear;
-		GLuint uniformExponent;
-		GLuint uniformEdge;
+		UniformHandle uniformAmbientIntensity;
+		UniformHandle uniformAmbientColor;
+		UniformHandle uniformDiffuseIntensity;
+		UniformHandle uniformPosition;
+		UniformHandle uniformDirection;
+		UniformHandle uniformConstant;
+		UniformHandle uniformLinear;
+		UniformHandle uniformExponent;
+		UniformHandle uniformEdge;
 	} uniformSpotLights[MAX_SPOT_LIGHTS];
 
-	void CreateShader(const char *vertexCode, const char *fragmentCode);
+	// 'debugName' labels the program in the GPU memory tracker (and debuggers)
+	bool CreateShader(const char *vertexCode, const char *fragmentCode, const char* debugName);
+	bool CreateComputeShader(const char* computeCode, const char* debugName);
+	bool computeOnly;
+	std::string variantDefines; // Given to CreateFromFile, kept for the hot reloads
+	std::string programName; // 'debugName' of the build, for the uniform mismatch messages
+	UniformTable uniforms;
+	uint64_t pendingKey; // Asset cache key the binary is stored under once linked (0: not stored)
+
+	// Compiles and starts linking the stages ('stageCount' of them), or loads the binary of that program from the
+	// asset cache. FinishProgram() checks the result
+	void StartProgram(const GLenum* stageTypes, const char* const* stageCodes, int stageCount, bool useCache);
+	bool FinishProgram();
+	void GetUniformLocations();
+	// Whether a value of 'bytes' bytes has to be sent to 'uniform' (it changed), and counts the upload or the skip
+	bool ShadowChanged(const UniformHandle& uniform, const void* values, size_t bytes);
 	void CompileShader(GLenum shaderType, const char *shaderCode);
-	std::string ReadFile(const char* fileLocation);
 };
 
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include "ShaderPreprocessor.h"
+#include "AssetCache.h"
+#include "AssetPack.h"
+#include "CommonValues.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::mutex ShaderPreprocessor::cacheMutex;
+std::vector<ShaderPreprocessor::CachedSource> ShaderPreprocessor::cache;
+
+bool ShaderPreprocessor::expandFile(const char* fileLocation, const char* variantDefines, std::string& expanded,
+	std::vector<std::string>* dependencies, bool usePack) {
+	std::string key = std::string(fileLocation) + "\n" + (variantDefines ? variantDefines : "") + (usePack ? "\npack" : "\ndisk");
+
+	// A cached expansion stays right as long as none of its files changed
+	std::vector<std::string> cachedDependencies;
+	uint64_t cachedStampHash = 0;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		for (size_t i = 0; i < cache.size(); i++) {
+			if (cache[i].key == key) {
+				cachedDependencies = cache[i].dependencies;
+				cachedStampHash = cache[i].stampHash;
+			}
+		}
+	}
+	if (!cachedDependencies.empty()) {
+		uint64_t stampHash = 0;
+		for (size_t i = 0; i < cachedDependencies.size(); i++) {
+			uint64_t stamp = getStamp(cachedDependencies[i], usePack);
+			stampHash = AssetCache::hashBytes(&stamp, sizeof(stamp), stampHash);
+		}
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		for (size_t i = 0; i < cache.size(); i++) {
+			if (cache[i].key == key && cache[i].stampHash == stampHash && stampHash == cachedStampHash) {
+				expanded = cache[i].expanded;
+				if (dependencies) {
+					*dependencies = cache[i].dependencies;
+				}
+				return true;
+			}
+		}
+	}
+
+	// The constants the C++ side sizes its uniform lookups with, so the shaders cannot disagree with it
+	char commonDefines[128];
+	snprintf(commonDefines, sizeof(commonDefines), "#define MAX_POINT_LIGHTS %d\n#define MAX_SPOT_LIGHTS %d\n", MAX_POINT_LIGHTS, MAX_SPOT_LIGHTS);
+	std::string defines = commonDefines;
+	if (variantDefines && variantDefines[0]) {
+		defines += variantDefines;
+		if (defines.back() != '\n') {
+			defines += '\n';
+		}
+	}
+
+	CachedSource source;
+	source.key = key;
+	source.dependencies.push_back(fileLocation);
+	source.stampHash = 0;
+	std::vector<int> includeStack;
+	if (!expandInto(fileLocation, 0, defines, usePack, source.expanded, source.dependencies, includeStack, source.stampHash)) {
+		// The files reached, the broken or missing one included: watched until it is fixed
+		expanded.clear();
+		if (dependencies) {
+			*dependencies = source.dependencies;
+		}
+		return false;
+	}
+	expanded = source.expanded;
+	if (dependencies) {
+		*dependencies = source.dependencies;
+	}
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	for (size_t i = 0; i < cache.size(); i++) {
+		if (cache[i].key == key) {
+			cache[i] = source;
+			return true;
+		}
+	}
+	cache.push_back(source);
+	return true;
+}
+
+bool ShaderPreprocessor::expandInto(const std::string& fileLocation, int source, const std::string& defines, bool usePack,
+	std::string& expanded, std::vector<std::string>& dependencies, std::vector<int>& includeStack, uint64_t& stampHash) {
+	std::string text;
+	if (!readSource(fileLocation, usePack, text, stampHash)) {
+		return false;
+	}
+	includeStack.push_back(source);
+	size_t slash = fileLocation.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : fileLocation.substr(0, slash + 1);
+	char lineDirective[32];
+
+	// Without #version (GLSL 1.10) the defines go first
+	if (source == 0 && text.find("#version") == std::string::npos) {
+		expanded += defines;
+		expanded += "#line 1 0\n";
+	}
+
+	int lineNumber = 0;
+	for (size_t position = 0; position < text.size();) {
+		size_t end = text.find('\n', position);
+		if (end == std::string::npos) {
+			end = text.size();
+		}
+		lineNumber++;
+		const char* line = text.c_str() + position;
+		const char* directive = line + strspn(line, " \t");
+
+		if (source == 0 && strncmp(directive, "#version", 8) == 0) {
+			// The defines right after it: nothing but comments may come before #version
+			expanded.append(line, end - position);
+			expanded += '\n';
+			expanded += defines;
+			snprintf(lineDirective, sizeof(lineDirective), "#line %d 0\n", lineNumber + 1);
+			expanded += lineDirective;
+		}
+		else if (strncmp(directive, "#include", 8) == 0) {
+			const char* open = (const char*)memchr(directive, '"', text.c_str() + end - directive);
+			const char* close = open ? (const char*)memchr(open + 1, '"', text.c_str() + end - open - 1) : NULL;
+			if (!close) {
+				printf("%s(%d): #include needs a file name in quotes\n", fileLocation.c_str(), lineNumber);
+				return false;
+			}
+			std::string includedLocation = directory + std::string(open + 1, close);
+			int included = -1;
+			for (size_t i = 0; i < dependencies.size(); i++) {
+				if (dependencies[i] == includedLocation) {
+					included = (int)i;
+				}
+			}
+			if (included < 0) {
+				dependencies.push_back(includedLocation);
+				included = (int)dependencies.size() - 1;
+				snprintf(lineDirective, sizeof(lineDirective), "#line 1 %d\n", included);
+				expanded += lineDirective;
+				if (!expandInto(includedLocation, included, defines, usePack, expanded, dependencies, includeStack, stampHash)) {
+					printf("  included from %s(%d)\n", fileLocation.c_str(), lineNumber);
+					return false;
+				}
+				snprintf(lineDirective, sizeof(lineDirective), "#line %d %d\n", lineNumber + 1, source);
+				expanded += lineDirective;
+			}
+			else {
+				for (size_t i = 0; i < includeStack.size(); i++) {
+					if (includeStack[i] == included) {
+						printf("%s(%d): '%s' includes itself\n", fileLocation.c_str(), lineNumber, includedLocation.c_str());
+						return false;
+					}
+				}
+				expanded += '\n'; // Already in the source
+			}
+		}
+		else {
+			expanded.append(line, end - position);
+			expanded += '\n';
+		}
+		position = end + 1;
+	}
+	includeStack.pop_back();
+	return true;
+}
+
+bool ShaderPreprocessor::readSource(const std::string& fileLocation, bool usePack, std::string& text, uint64_t& stampHash) {
+	// Stamped before it is read: a file written in between is read again next time
+	uint64_t stamp = getStamp(fileLocation, usePack);
+	stampHash = AssetCache::hashBytes(&stamp, sizeof(stamp), stampHash);
+	if (stamp == 0) {
+		printf("Error while trying to open the following file: '%s'\n", fileLocation.c_str());
+		return false;
+	}
+	AssetPack* pack = usePack ? AssetPack::getMounted() : NULL;
+	const char* packed = pack ? pack->getShaderSource(fileLocation.c_str()) : NULL;
+	if (packed) {
+		text = packed;
+		return true;
+	}
+	text = readFile(fileLocation.c_str());
+	return true;
+}
+
+uint64_t ShaderPreprocessor::getStamp(const std::string& fileLocation, bool usePack) {
+	// A mounted pack does not change: where the source is mapped stands for its version
+	AssetPack* pack = usePack ? AssetPack::getMounted() : NULL;
+	const char* packed = pack ? pack->getShaderSource(fileLocation.c_str()) : NULL;
+	if (packed) {
+		return (uint64_t)(uintptr_t)packed;
+	}
+	uint64_t bytes, modified;
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileLocation.c_str(), GetFileExInfoStandard, &attributes) || (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		return 0;
+	}
+	bytes = (uint64_t)attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+	modified = (uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat status;
+	if (stat(fileLocation.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) {
+		return 0;
+	}
+	bytes = (uint64_t)status.st_size;
+	// Nanoseconds: an editor saving twice in a second still changes the stamp
+	modified = (uint64_t)status.st_mtim.tv_sec * 1000000000ULL + (uint64_t)status.st_mtim.tv_nsec;
+#endif
+	uint64_t stamp = AssetCache::hashBytes(&bytes, sizeof(bytes), modified);
+	return stamp != 0 ? stamp : 1;
+}
+
+std::string ShaderPreprocessor::readFile(const char* fileLocation) {
+	std::ifstream fileStream(fileLocation, std::ios::in | std::ios::binary);
+
+	if (!fileStream.is_open()) {
+		printf("Error while trying to open the following file: '%s'\n", fileLocation);
+		return "";
+	}
+
+	// The whole file in one read, sized up front
+	fileStream.seekg(0, std::ios::end);
+	std::string content((size_t)fileStream.tellg(), '\0');
+	fileStream.seekg(0, std::ios::beg);
+	fileStream.read(&content[0], content.size());
+
+	fileStream.close();
+	return content;
+}
+
+std::string ShaderPreprocessor::describeSources(const std::vector<std::string>& dependencies) {
+	std::string description;
+	for (size_t i = 0; i < dependencies.size(); i++) {
+		char number[16];
+		snprintf(number, sizeof(number), "%s%d '", i > 0 ? ", " : "", (int)i);
+		description += number + dependencies[i] + "'";
+	}
+	return description;
+}
+
+void ShaderPreprocessor::clearCache() {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.clear();
+}
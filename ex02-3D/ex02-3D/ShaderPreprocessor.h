@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+Every GLSL source goes through this before it is compiled (Shader::CreateFromFile, hot reloads):
+
+	#version 330
+	...
+	#include "Lighting.glsl" // Relative to the including file
+
+- #include "file" is replaced by the file. A file is included once per source however many files include it (as with
+  #pragma once), an include cycle is an error
+- The constants shared with the C++ side are inserted as #defines after #version (MAX_POINT_LIGHTS... of
+  CommonValues.h, the only place they are set), then the defines of the variant being built
+- #line directives keep the compile errors on the lines of the files: source string N is dependency N
+
+The files come from the mounted asset pack when it has them, otherwise from the disk. Expanded sources are cached
+in memory under their file and defines, and reused as long as the size and modification time of every file they
+were made of are the same (a reloaded program only preprocesses again the stage that changed)
+*/
+class ShaderPreprocessor
+{
+public:
+	// 'variantDefines': GLSL lines ("#define USE_FOG 1\n") added after the common defines, NULL for none.
+	// 'dependencies' receives the files of the source, 'fileLocation' first. 'usePack' false: the files on the disk
+	// even with a pack mounted (hot reload). False, with the error printed, when a file cannot be read or an include
+	// is wrong: 'dependencies' then has the files reached up to the failing one (included). Any thread
+	static bool expandFile(const char* fileLocation, const char* variantDefines, std::string& expanded,
+		std::vector<std::string>* dependencies = NULL, bool usePack = true);
+	// The whole file as a string (empty, with the error printed, when it cannot be read). Any thread
+	static std::string readFile(const char* fileLocation);
+	// "0 'Shaders/FragmentShader.glsl', 1 'Shaders/Lighting.glsl'": what the source string numbers of the compile
+	// errors refer to
+	static std::string describeSources(const std::vector<std::string>& dependencies);
+	static void clearCache();
+
+private:
+	struct CachedSource
+	{
+		std::string key; // File, variant defines and where the files come from
+		std::vector<std::string> dependencies;
+		uint64_t stampHash; // Sizes and modification times of the dependencies when they were read
+		std::string expanded;
+	};
+
+	static std::mutex cacheMutex;
+	static std::vector<CachedSource> cache;
+
+	// Appends 'fileLocation' (dependency 'source', already in 'dependencies') to 'expanded', its includes in place
+	static bool expandInto(const std::string& fileLocation, int source, const std::string& defines, bool usePack,
+		std::string& expanded, std::vector<std::string>& dependencies, std::vector<int>& includeStack, uint64_t& stampHash);
+	static bool readSource(const std::string& fileLocation, bool usePack, std::string& text, uint64_t& stampHash);
+	static uint64_t getStamp(const std::string& fileLocation, bool usePack); // 0 when the file is missing
+};
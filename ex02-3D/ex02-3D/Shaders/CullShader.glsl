@@ -0,0 +1,54 @@
+#version 430
+
+// One thread per object: tests the object's bounding sphere against the frustum
+// and writes instanceCount (1: draw, 0: skip) in its indirect command
+layout(local_size_x=64) in;
+
+struct ObjectData {
+	mat4 model;
+	vec4 boundingSphere;
+	float specularIntensity;
+	float shininess;
+	int textureLayer;
+	uint meshID;
+};
+
+struct DrawCommand {
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding=0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+};
+
+layout(std430, binding=1) buffer CommandBuffer {
+	DrawCommand commands[];
+};
+
+uniform vec4 frustumPlanes[6];
+uniform uint objectCount;
+
+void main() {
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= objectCount) {
+		return;
+	}
+
+	mat4 model = objects[index].model;
+	vec4 sphere = objects[index].boundingSphere;
+	vec3 center = (model * vec4(sphere.xyz, 1.0)).xyz;
+	float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+	float radius = sphere.w * scale;
+
+	uint visible = 1u;
+	for (int i = 0; i < 6; i++) {
+		if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius) {
+			visible = 0u;
+		}
+	}
+	commands[index].instanceCount = visible;
+}
@@ -0,0 +1,29 @@
+#version 430
+
+in vec4 vColor;
+in vec2 texCoord;
+in vec3 normal;
+in vec3 fragPos;
+flat in float specularIntensity;
+flat in float shininess;
+flat in int textureLayer;
+
+out vec4 color;
+
+#include "Material.glsl"
+
+Material material; // Filled from the object data in main()
+
+#include "Lighting.glsl"
+
+uniform sampler2DArray theTextures;
+
+void main() {
+	material.specularIntensity = specularIntensity;
+	material.shininess = shininess;
+
+	vec4 finalColor = CalcDirectionalLight();
+	finalColor += CalcPointLights();
+	finalColor += CalcSpotLights();
+	color = texture(theTextures, vec3(texCoord, textureLayer)) * finalColor;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 430
+
+layout(location=0) in vec3 pos;
+layout(location=1) in vec2 tex;
+layout(location=2) in vec3 norm;
+layout(location=3) in uint objectIndex; // Per-instance attribute, fetched at the command's baseInstance
+
+out vec4 vColor;
+out vec2 texCoord;
+out vec3 normal;
+out vec3 fragPos;
+flat out float specularIntensity;
+flat out float shininess;
+flat out int textureLayer;
+
+struct ObjectData {
+	mat4 model;
+	vec4 boundingSphere;
+	float specularIntensity;
+	float shininess;
+	int textureLayer;
+	uint meshID;
+};
+
+layout(std430, binding=0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+};
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main(){
+	ObjectData object = objects[objectIndex];
+	gl_Position = projection * view * object.model * vec4(pos, 1.0);
+	vColor = vec4(clamp(pos, 0.0f, 1.0f), 1.0f);
+	texCoord = tex;
+	normal = mat3(transpose(inverse(object.model))) * norm;
+	fragPos = (object.model * vec4(pos, 1.0)).xyz;
+
+	specularIntensity = object.specularIntensity;
+	shininess = object.shininess;
+	textureLayer = object.textureLayer;
+}
@@ -0,0 +1,5 @@
+// Specular material of an object
+struct Material {
+	float specularIntensity;
+	float shininess;
+};
\ No newline at end of file
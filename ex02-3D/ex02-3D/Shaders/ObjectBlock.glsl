@@ -0,0 +1,7 @@
+#include "Material.glsl"
+
+// Per-object constants, bound from the uniform ring buffer (Shader::GetUniformLocations attaches the block to its binding)
+layout(std140) uniform ObjectBlock {
+	mat4 model;
+	Material material;
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330
+
+in vec2 texCoord;
+in vec4 vColor;
+
+out vec4 color;
+
+uniform sampler2D glyphAtlas; // Single channel: 1 where the glyph is lit
+
+void main() {
+	color = vec4(vColor.rgb, vColor.a * texture(glyphAtlas, texCoord).r);
+}
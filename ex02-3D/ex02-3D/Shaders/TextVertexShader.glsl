@@ -0,0 +1,17 @@
+#version 330
+
+layout(location=0) in vec2 pos; // Pixels, origin at the top left corner
+layout(location=1) in vec2 tex;
+layout(location=2) in vec4 col;
+
+out vec2 texCoord;
+out vec4 vColor;
+
+uniform vec2 screenSize;
+
+void main() {
+	// Pixels to clip space (y points down on screen, up in clip space)
+	gl_Position = vec4(pos.x / screenSize.x * 2.0 - 1.0, 1.0 - pos.y / screenSize.y * 2.0, 0.0, 1.0);
+	texCoord = tex;
+	vColor = col;
+}
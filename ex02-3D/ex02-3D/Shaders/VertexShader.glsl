@@ -9,7 +9,8 @@ out vec2 texCoord;
 out vec3 normal;
 out vec3 fragPos;
 
-uniform mat4 model;
+#include "ObjectBlock.glsl"
+
 uniform mat4 projection;
 uniform mat4 view;
 
@@ -1,7 +1,20 @@
 #define STB_IMAGE_IMPLEMENTATION
+// Decoded images come from the scratch arena of the decoding thread, released once the textures are uploaded
+#define STBI_MALLOC(size) FrameArena::scratchMalloc(size)
+#define STBI_REALLOC(memory, size) FrameArena::scratchRealloc(memory, size)
+#define STBI_FREE(memory) FrameArena::scratchFree(memory)
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <math.h>
 
 #include <GL\glew.h>
 #include <GLFW\glfw3.h>
@@ -11,6 +24,7 @@
 #include <glm\gtc\type_ptr.hpp>
 
 #include "CommonValues.h"
+#include "FrameArena.h"
 #include "Mesh.h"
 #include "Shader.h"
 #include "Window.h"
@@ -20,247 +34,1111 @@
 #include "PointLight.h"
 #include "SpotLight.h"
 #include "Material.h"
+#include "IndirectRenderer.h"
+#include "TextureArray.h"
+#include "RenderStats.h"
+#include "UniformRingBuffer.h"
+#include "Benchmarks.h"
+#include "TransformHierarchy.h"
+#include "Scene.h"
+#include "Components.h"
+#include "SceneSystems.h"
+#include "JobSystem.h"
+#include "MeshUtils.h"
+#include "FramePacket.h"
+#include "TripleBuffer.h"
+#include "RenderCommandBuffer.h"
+#include "FixedTimestep.h"
+#include "RedrawTracker.h"
+#include "SystemStats.h"
+#include "FramePacer.h"
+#include "CameraPath.h"
+#include "BenchmarkRecorder.h"
+#include "InputRecorder.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "Hud.h"
+#include "GpuMemoryTracker.h"
+#include "AssetPack.h"
+#include "MeshImporter.h"
+#include "AssetCache.h"
+#include "AssetReloader.h"
+#include "ShaderPreprocessor.h"
 
 std::vector<Mesh*> meshList;
 std::vector<Shader> shaderList;
 Window mainWindow;
 Camera camera;
 
-DirectionalLight mainLight;
-PointLight pointLights[MAX_POINT_LIGHTS];
-SpotLight spotLights[MAX_SPOT_LIGHTS];
-
 Material metalMaterial;
 Material woodMaterial;
 
 Texture brickTexture;
 Texture dirtTexture;
 
+// GPU-driven path (F1 toggles it, F2 toggles compute culling)
+IndirectRenderer indirectRenderer;
+TextureArray textureArray;
+GLint brickLayer = 0, dirtLayer = 0;
+bool useIndirect = false;
+
+// Per-object uniforms of the classic path
+UniformRingBuffer objectRing;
+
+// Classic path draws are recorded on the workers (one buffer per job system thread) and replayed sorted
+std::vector<RenderCommandBuffer*> commandBuffers;
+std::vector<RenderPacket> sortedPackets;
+static const size_t PARALLEL_RECORD_DRAWS = 256; // Smaller draw lists are recorded inline
+
+// Object transforms. World matrices are cached and only rebuilt when a node (or one of its parents) moves
+TransformHierarchy sceneTransforms;
+
+// Scene entities (objects and lights). The systems turn them into a draw list and light arrays every frame
+Scene scene;
+std::vector<GLintptr> objectOffsets;
+unsigned long long simulationFrame = 0;
+
+// Threaded mode (--threaded): the update thread simulates and fills frame packets, the main thread only renders.
+// Both hand-offs are lock-free triple buffers
+bool threadedMode = false;
+TripleBuffer<FramePacket> framePackets; // Update thread -> GL thread
+TripleBuffer<InputSnapshot> inputSnapshots; // GL thread (GLFW events) -> update thread
+std::atomic<bool> updateRunning(false);
+std::atomic<unsigned long long> packetsProduced(0), packetsConsumed(0);
+
 // Old implementation of FPS control
 GLfloat deltaTime = 0.0f, lastTime = 0.0f;
 
+// Fixed-step simulation (--step-rate <Hz>, 60 by default). Rendering interpolates between the last two steps
+FixedTimestep simulationClock(60.0);
+Camera previousCamera; // Camera before the last step
+GLfloat pendingMouseX = 0.0f, pendingMouseY = 0.0f; // Mouse movement not consumed by a step yet
+bool lastStepChanged = true; // The last step moved something, so interpolated frames still differ
+
+// Render-on-demand (--on-demand): frames are only drawn when something changed, otherwise the loop sleeps
+static const double IDLE_WAIT_SECONDS = 0.5; // Longest sleep, keeps the once per second stats going
+
+// Frame pacing (--fps <limit>, --vsync <swap interval>) and frame time percentiles (--frame-csv <file> for every frame)
+FramePacer framePacer;
+
+// Stats overlay (F3 toggles it, --hud shows it from the start)
+Hud hud;
+
+// Hot reload (--hot-reload): shaders and textures are reloaded when their files are written
+AssetReloader assetReloader;
+static const double RELOAD_WAIT_SECONDS = 0.01; // Longest on-demand sleep while a reload is running
+
 static const char* vertexLocation = "Shaders/VertexShader.glsl";
 static const char* fragmentLocation = "Shaders/FragmentShader.glsl";
+static const char* indirectVertexLocation = "Shaders/IndirectVertexShader.glsl";
+static const char* indirectFragmentLocation = "Shaders/IndirectFragmentShader.glsl";
+static const char* cullLocation = "Shaders/CullShader.glsl";
+static const char* textVertexLocation = "Shaders/TextVertexShader.glsl";
+static const char* textFragmentLocation = "Shaders/TextFragmentShader.glsl";
+static const char* brickLocation = "Textures/brick.png";
+static const char* dirtLocation = "Textures/dirt.png";
+static const char* shaderLocations[] = { vertexLocation, fragmentLocation, indirectVertexLocation, indirectFragmentLocation, cullLocation,
+	textVertexLocation, textFragmentLocation };
 
-// Normal calculations (source: OpenGL)
-void CalcAverageNormal(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
-					unsigned int vLength, unsigned int normalOffset) {
-	for (int i=0; i < indexCount; i=i+3) {
-		unsigned int i0 = indices[i] * vLength;
-		unsigned int i1 = indices[i+1] * vLength;
-		unsigned int i2 = indices[i+2] * vLength;
+// Scene geometry. Every vertex is (x, y, z, u, v, nx, ny, nz), the pyramid normals are computed by GetSceneMeshes
+GLfloat pyramidVertices[] = {
+	 0.0f,  1.0f,  0.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, // Vertex 0 (x, y, z, u, v, nx, ny, nz)
+	 1.0f, -1.0f, -0.6f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // Vertex 1 (x, y, z, u, v, nx, ny, nz)
+	-1.0f, -1.0f, -0.6f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, // Vertex 2 (x, y, z, u, v, nx, ny, nz)
+	 0.0f, -1.0f,  1.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f  // Vertex 3 (x, y, z, u, v, nx, ny, nz)
+};
 
-		glm::vec3 v1(vertices[i1] - vertices[i0], vertices[i1 + 1] - vertices[i0 + 1], vertices[i1 + 2] - vertices[i0 + 2]);
-		glm::vec3 v2(vertices[i2] - vertices[i0], vertices[i2 + 1] - vertices[i0 + 1], vertices[i2 + 2] - vertices[i0 + 2]);
-		glm::vec3 normal = glm::normalize(glm::cross(v1, v2));
+unsigned int pyramidIndices[]{
+	0, 1, 2, // Pyramid front
+	0, 1, 3, // Pyramid right
+	0, 2, 3, // Pyramid left
+	1, 2, 3  // Pyramid base
+};
 
-		vertices[i0 + normalOffset] += normal.x; vertices[i0 + 1 + normalOffset] += normal.y; vertices[i0 + 2 + normalOffset] += normal.z;
-		vertices[i1 + normalOffset] += normal.x; vertices[i1 + 1 + normalOffset] += normal.y; vertices[i1 + 2 + normalOffset] += normal.z;
-		vertices[i2 + normalOffset] += normal.x; vertices[i2 + 1 + normalOffset] += normal.y; vertices[i2 + 2 + normalOffset] += normal.z;
-	}
+GLfloat floorVertices[] = {
+	-10.0, 0.0f, -10.0f,  0.0f,  0.0f, 0.0f, -1.0f, 0.0f,
+	 10.0, 0.0f, -10.0f, 10.0f,  0.0f, 0.0f, -1.0f, 0.0f,
+	-10.0, 0.0f,  10.0f,  0.0f, 10.0f, 0.0f, -1.0f, 0.0f,
+	 10.0, 0.0f,  10.0f, 10.0f, 10.0f, 0.0f, -1.0f, 0.0f
+};
+
+unsigned int floorIndices[] = {
+	0, 2, 1,
+	1, 2, 3
+};
 
-	for (int i=0; i < vertexCount / vLength; i++) {
-		unsigned int nOffset = i * vLength + normalOffset;
-		glm::vec3 vec(vertices[nOffset], vertices[nOffset + 1], vertices[nOffset + 2]);
-		vec = glm::normalize(vec);
-		vertices[nOffset] = vec.x;
-		vertices[nOffset+1] = vec.y;
-		vertices[nOffset+2] = vec.z;
+// The meshes of the scene, ready to upload: in place in the mounted asset pack when it has them (packed with
+// their normals), otherwise the arrays above once the normals are calculated
+void GetSceneMeshes(MeshData& pyramid, MeshData& floor) {
+	AssetPack* pack = AssetPack::getMounted();
+	if (pack && pack->getMesh("Meshes/pyramid", pyramid) && pack->getMesh("Meshes/floor", floor)) {
+		return;
 	}
+	static bool normalsCalculated = false;
+	if (!normalsCalculated) {
+		// Calculate the normals
+		CalcAverageNormal(pyramidIndices, 12, pyramidVertices, 32, 8, 5);
+		normalsCalculated = true;
+	}
+	pyramid = MeshData{ pyramidVertices, pyramidIndices, 32, 12 };
+	floor = MeshData{ floorVertices, floorIndices, 32, 6 };
 }
 
-
 // Function for creating a triangle (VAO and VBO)
 void CreateObject() {
-	GLfloat vertices[] = {
-		 0.0f,  1.0f,  0.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, // Vertex 0 (x, y, z, u, v, nx, ny, nz)
-		 1.0f, -1.0f, -0.6f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // Vertex 1 (x, y, z, u, v, nx, ny, nz)
-		-1.0f, -1.0f, -0.6f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, // Vertex 2 (x, y, z, u, v, nx, ny, nz)
-		 0.0f, -1.0f,  1.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f  // Vertex 3 (x, y, z, u, v, nx, ny, nz)
-	};
-
-	unsigned int indices[]{
-		0, 1, 2, // Pyramid front
-		0, 1, 3, // Pyramid right
-		0, 2, 3, // Pyramid left
-		1, 2, 3  // Pyramid base
-	};
-
-	GLfloat floorVertices[] = {
-		-10.0, 0.0f, -10.0f,  0.0f,  0.0f, 0.0f, -1.0f, 0.0f,
-		 10.0, 0.0f, -10.0f, 10.0f,  0.0f, 0.0f, -1.0f, 0.0f,
-		-10.0, 0.0f,  10.0f,  0.0f, 10.0f, 0.0f, -1.0f, 0.0f,
-		 10.0, 0.0f,  10.0f, 10.0f, 10.0f, 0.0f, -1.0f, 0.0f
-	};
-
-	unsigned int floorIndices[] = {
-		0, 2, 1,
-		1, 2, 3
-	};
-
-	// Calculate the normals
-	CalcAverageNormal(indices, 12, vertices, 32, 8, 5);
+	MeshData pyramid, floor;
+	GetSceneMeshes(pyramid, floor);
 
 	Mesh* obj1 = new Mesh();
-	obj1->CreateMesh(vertices, indices, 32, 12);
+	obj1->CreateMesh(pyramid.vertices, pyramid.indices, pyramid.vertexCount, pyramid.indexCount);
 	meshList.push_back(obj1);
 
 	Mesh* obj2 = new Mesh();
-	obj2->CreateMesh(vertices, indices, 32, 12);
+	obj2->CreateMesh(pyramid.vertices, pyramid.indices, pyramid.vertexCount, pyramid.indexCount);
 	meshList.push_back(obj2);
 
 	Mesh* obj3 = new Mesh();
-	obj3->CreateMesh(floorVertices, floorIndices, 32, 6);
+	obj3->CreateMesh(floor.vertices, floor.indices, floor.vertexCount, floor.indexCount);
 	meshList.push_back(obj3);
+
+	// Same meshes in the shared buffers of the indirect path (mesh IDs match the meshList indices)
+	if (IndirectRenderer::isSupported()) {
+		indirectRenderer.addMesh(pyramid.vertices, pyramid.indices, pyramid.vertexCount, pyramid.indexCount);
+		indirectRenderer.addMesh(pyramid.vertices, pyramid.indices, pyramid.vertexCount, pyramid.indexCount);
+		indirectRenderer.addMesh(floor.vertices, floor.indices, floor.vertexCount, floor.indexCount);
+	}
+}
+
+// --mesh <file.obj|file.glb>: one more mesh for the scene, from the mounted asset pack when it was packed with it,
+// or from the asset cache when an earlier run imported the same file.
+// Returns its meshList index (-1 when it could not be loaded) and the scale that fits it in a 3 unit wide sphere
+GLint AddImportedMesh(const char* fileLocation, GLfloat& fitScale) {
+	ImportedMesh imported;
+	MeshData mesh;
+	AssetPack cachedMesh;
+	AssetPack* pack = AssetPack::getMounted();
+	if (!pack || !pack->getMesh(fileLocation, mesh)) {
+		auto start = std::chrono::high_resolution_clock::now();
+		AssetCache* cache = AssetCache::getMounted();
+		uint64_t key = AssetCache::hashString(fileLocation, AssetCache::hashString("Imported mesh 1"));
+		bool cacheable = cache && AssetCache::hashFile(fileLocation, key);
+		bool cached = cacheable && cache->find(key, cachedMesh) && cachedMesh.getMesh(fileLocation, mesh);
+		if (!cached) {
+			if (!MeshImporter::importMesh(fileLocation, imported)) {
+				return -1;
+			}
+			mesh = imported.getMeshData();
+			if (cacheable) {
+				AssetPackWriter writer;
+				writer.addMesh(fileLocation, mesh);
+				cache->store(key, writer);
+			}
+		}
+		printf("%s '%s': %u vertices, %u triangles in %.1f ms\n", cached ? "Loaded cached" : "Imported", fileLocation,
+			mesh.vertexCount / 8, mesh.indexCount / 3, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+
+	glm::vec3 minPos(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]), maxPos = minPos;
+	for (unsigned int i = 0; i < mesh.vertexCount; i += 8) {
+		glm::vec3 pos(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]);
+		minPos = glm::min(minPos, pos);
+		maxPos = glm::max(maxPos, pos);
+	}
+	GLfloat radius = glm::length(maxPos - minPos) * 0.5f;
+	fitScale = radius > 0.0f ? 1.5f / radius : 1.0f;
+
+	Mesh* obj = new Mesh();
+	obj->CreateMesh(mesh.vertices, mesh.indices, mesh.vertexCount, mesh.indexCount);
+	meshList.push_back(obj);
+	if (IndirectRenderer::isSupported()) {
+		indirectRenderer.addMesh(mesh.vertices, mesh.indices, mesh.vertexCount, mesh.indexCount);
+	}
+	return (GLint)meshList.size() - 1;
 }
 
 void AddShader() {
-	Shader* shader1 = new Shader();
-	shader1->CreateFromFile(vertexLocation, fragmentLocation);
-	shaderList.push_back(*shader1);
+	// Created in place: a copy would share the program ID, and delete it with the copy
+	shaderList.push_back(Shader());
+	shaderList.back().CreateFromFile(vertexLocation, fragmentLocation);
+}
+
+// --build-pack <file> [--compress] [--mesh <file>]: the meshes, textures (mipmapped, BC1 with --compress) and shaders
+// of the scene in one asset pack, loaded with --pack <file>. CPU only, no window
+int BuildAssetPack(const char* packLocation, bool compress, const char* meshLocation) {
+	auto start = std::chrono::high_resolution_clock::now();
+	AssetPackWriter writer;
+	MeshData pyramid, floor;
+	GetSceneMeshes(pyramid, floor);
+	writer.addMesh("Meshes/pyramid", pyramid);
+	writer.addMesh("Meshes/floor", floor);
+	ImportedMesh imported;
+	if (meshLocation) {
+		if (!MeshImporter::importMesh(meshLocation, imported)) {
+			return 1;
+		}
+		writer.addMesh(meshLocation, imported.getMeshData());
+	}
+
+	// The shaders and every file they include, each once
+	bool success = true;
+	std::vector<std::string> shaderFiles;
+	for (size_t i = 0; i < sizeof(shaderLocations) / sizeof(shaderLocations[0]); i++) {
+		std::string expanded;
+		std::vector<std::string> dependencies;
+		success = ShaderPreprocessor::expandFile(shaderLocations[i], NULL, expanded, &dependencies) && success;
+		for (size_t d = 0; d < dependencies.size(); d++) {
+			if (std::find(shaderFiles.begin(), shaderFiles.end(), dependencies[d]) == shaderFiles.end()) {
+				shaderFiles.push_back(dependencies[d]);
+				success = writer.addShader(dependencies[d].c_str()) && success;
+			}
+		}
+	}
+	success = writer.addTexture(brickLocation, compress) && success;
+	success = writer.addTexture(dirtLocation, compress) && success;
+	// The texture array of the indirect path (same layers, same order as in main)
+	std::vector<const char*> layers = { brickLocation, dirtLocation };
+	success = writer.addTextureArray(TextureArray::getPackName(layers).c_str(), layers, compress) && success;
+	FrameArena::releaseScratch();
+	if (!success || !writer.write(packLocation)) {
+		return 1;
+	}
+
+	// Opened again, the way it will be loaded
+	AssetPack pack;
+	if (!pack.open(packLocation)) {
+		return 1;
+	}
+	printf("Asset pack '%s': %u assets, %.2f MB%s, built in %.0f ms\n", packLocation, pack.getAssetCount(), pack.getFileSize() / (1024.0 * 1024.0),
+		compress ? " (BC1 textures)" : "", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	return 0;
+}
+
+// --cold-start: the files startup reads (the pack, or every loose asset) are dropped from the OS file cache first,
+// so they come from the disk like after a reboot. Shader caches of the driver are not affected
+void EvictAssetFiles(const char* packLocation) {
+	std::vector<const char*> files(shaderLocations, shaderLocations + sizeof(shaderLocations) / sizeof(shaderLocations[0]));
+	files.push_back(brickLocation);
+	files.push_back(dirtLocation);
+	if (packLocation) {
+		files.assign(1, packLocation);
+	}
+	unsigned int evicted = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		evicted += AssetPack::evictFromCache(files[i]) ? 1 : 0;
+	}
+	printf("Cold start: %u of %u asset files dropped from the file cache\n", evicted, (unsigned int)files.size());
+}
+
+// Deletes every GL object the application created. Whatever the GPU memory tracker still holds after this is a leak
+void ReleaseGpuResources() {
+	for (size_t i = 0; i < meshList.size(); i++) {
+		delete meshList[i];
+	}
+	meshList.clear();
+	assetReloader.clearReloader(); // Reloads in flight own GL objects too
+	shaderList.clear();
+	brickTexture.clearTexture();
+	dirtTexture.clearTexture();
+	textureArray.clearTextureArray();
+	indirectRenderer.clearRenderer();
+	objectRing.clearRingBuffer();
+	hud.clearHud();
+	mainWindow.clearFramebuffer();
+}
+
+// Simulation of one frame: input, scene systems and the frame packet the renderer will consume.
+// Runs on the update thread in threaded mode, inline in the main loop otherwise
+void SimulateFrame(bool* keys, GLfloat xChange, GLfloat yChange, double frameSeconds, FramePacket& packet) {
+	PROFILE_FUNCTION();
+	auto start = std::chrono::high_resolution_clock::now();
+	pendingMouseX += xChange;
+	pendingMouseY += yChange;
+
+	// Zero, one or several steps depending on how much real time passed
+	unsigned int steps = simulationClock.advance(frameSeconds);
+	GLfloat dt = simulationClock.getStepSeconds();
+	unsigned int changesBefore = 0;
+	for (unsigned int step = 0; step < steps; step++) {
+		PROFILE_SCOPE("Simulation step");
+		simulationClock.beginStep();
+		if (step == steps - 1) {
+			previousCamera = camera; // Interpolation goes from here to the result of this step
+			changesBefore = RedrawTracker::getChangeCount();
+		}
+
+		// Set up keyboard and mouse control
+		camera.keyControl(keys, dt);
+		if (step == 0) {
+			camera.mouseControl(pendingMouseX, pendingMouseY, dt); // The mouse moved once this frame, not once per step
+			pendingMouseX = 0.0f;
+			pendingMouseY = 0.0f;
+		}
+
+		/********************************
+		*	Systems
+		*********************************/
+		// Update flashlight position
+		UpdateFlashlights(scene, camera);
+		// Model matrices (shared by both render paths). Only nodes that moved get recomputed
+		sceneTransforms.update();
+		simulationClock.endStep();
+	}
+
+	// Frames between two different steps show different interpolations: keep drawing until a step changes nothing
+	if (steps > 0) {
+		lastStepChanged = RedrawTracker::getChangeCount() != changesBefore;
+	}
+	if (lastStepChanged) {
+		RedrawTracker::markDirty();
+	}
+
+	// Render state: 'alpha' of the way between the last two steps
+	GLfloat alpha = simulationClock.getAlpha();
+	{
+		PROFILE_SCOPE("Build draw list");
+		BuildDrawList(scene, sceneTransforms, packet.drawList, alpha);
+		GatherLights(scene, packet.lights);
+	}
+
+	packet.view = camera.calculateViewMatrix(previousCamera, alpha);
+	packet.cameraPosition = previousCamera.getCameraPosition() + (camera.getCameraPosition() - previousCamera.getCameraPosition()) * alpha;
+	packet.frame = simulationFrame++;
+	packet.updateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void UpdateThreadLoop() {
+	PROFILE_THREAD("Update");
+	GLfloat lastMouseX = 0.0f, lastMouseY = 0.0f;
+	double lastUpdate = mainWindow.getTime();
+	while (updateRunning) {
+		// Latest input published by the main thread (the previous one again if nothing new came in)
+		inputSnapshots.acquire();
+		InputSnapshot& input = inputSnapshots.getReadBuffer();
+		double now = mainWindow.getTime();
+		double frameSeconds = now - lastUpdate;
+		lastUpdate = now;
+
+		SimulateFrame(input.keys, input.mouseX - lastMouseX, input.mouseY - lastMouseY, frameSeconds, framePackets.getWriteBuffer());
+		lastMouseX = input.mouseX;
+		lastMouseY = input.mouseY;
+		framePackets.publish();
+		packetsProduced++;
+
+		// Simulate frame N+1 while N is drawn, but not further ahead: packets nobody draws are wasted work
+		while (updateRunning && packetsProduced.load() != packetsConsumed.load()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+// Draws one frame packet with the active path
+void RenderFrame(FramePacket& packet, const glm::mat4& projection) {
+	PROFILE_FUNCTION();
+	std::vector<DrawItem>& drawList = packet.drawList;
+	SceneLights& lights = packet.lights;
+
+	if (useIndirect) {
+		/********************************
+		*	Indirect path: 1 draw call
+		*********************************/
+		Shader* indirectShader = indirectRenderer.getShader();
+		indirectShader->UseProgram();
+			indirectShader->setDirectionalLight(&lights.directionalLight);
+			indirectShader->setSpotLight(lights.spotLights, lights.spotLightsCount);
+			textureArray.useTextureArray(GL_TEXTURE0);
+
+			indirectRenderer.beginFrame();
+			for (size_t i = 0; i < drawList.size(); i++) {
+				indirectRenderer.addObject(drawList[i].mesh, drawList[i].model, *drawList[i].material, drawList[i].textureLayer);
+			}
+			{
+				PROFILE_SCOPE("Indirect render");
+				indirectRenderer.render(projection, packet.view);
+			}
+	}
+	else {
+		/********************************
+		*	Use Shader
+		*********************************/
+		shaderList[0].UseProgram();
+
+		// Set PROJECTION (Camera)
+		// Updates the projection variable in the shader in order to multiply/transform our vertex matrix
+		// (only sent when it changed: the projection is the same from one frame to the next)
+		shaderList[0].setProjection(projection);
+		shaderList[0].setView(packet.view);
+		
+			/********************************
+			*	Lights
+			*********************************/	
+			{
+				PROFILE_SCOPE("Light upload");
+				shaderList[0].setDirectionalLight(&lights.directionalLight);
+				//shaderList[0].setPointLight(lights.pointLights, lights.pointLightsCount);
+				shaderList[0].setSpotLight(lights.spotLights, lights.spotLightsCount);
+			}
+
+			/********************************
+			*	Per-object constants
+			*********************************/
+			// Written linearly into this frame's region of the ring, then bound by range before each draw
+			{
+				PROFILE_SCOPE("Object uniforms");
+				objectRing.beginFrame();
+				objectOffsets.resize(drawList.size());
+				for (size_t i = 0; i < drawList.size(); i++) {
+					ObjectBlock block;
+					block.model = drawList[i].model;
+					block.specularIntensity = drawList[i].material->getSpecularIntensity();
+					block.shininess = drawList[i].material->getShininess();
+					objectOffsets[i] = objectRing.write(&block, sizeof(ObjectBlock));
+				}
+				objectRing.flush();
+			}
+
+			/********************************
+			*	Objects
+			*********************************/
+			// Draw commands are recorded on the workers, each slice of the draw list into its own buffer,
+			// then replayed here sorted by program, texture and VAO (redundant binds are skipped)
+			GLuint program = shaderList[0].getShaderID();
+			GLuint ringBuffer = objectRing.getBufferID();
+			size_t sliceCount = drawList.size() < PARALLEL_RECORD_DRAWS ? 1 : commandBuffers.size();
+			JobSystem::parallelFor("Record draws", sliceCount, 1, [&](size_t begin, size_t end) {
+				for (size_t slice = begin; slice < end; slice++) {
+					RenderCommandBuffer* buffer = commandBuffers[slice];
+					buffer->reset();
+					size_t first = drawList.size() * slice / sliceCount, last = drawList.size() * (slice + 1) / sliceCount;
+					for (size_t i = first; i < last; i++) {
+						if (objectOffsets[i] < 0) {
+							continue; // Did not fit in the ring this frame
+						}
+						Mesh* mesh = meshList[drawList[i].mesh];
+						GLuint texture = drawList[i].texture->getTextureID();
+						buffer->beginPacket(RenderCommandBuffer::MakeSortKey(program, texture, mesh->getVAO()));
+						buffer->setProgram(program);
+						buffer->bindTexture(GL_TEXTURE0, GL_TEXTURE_2D, texture);
+						buffer->bindVertexArray(mesh->getVAO(), mesh->getIBO());
+						buffer->bindUniformRange(OBJECT_BLOCK_BINDING, ringBuffer, objectOffsets[i], sizeof(ObjectBlock)); // Model matrix + material
+						buffer->drawElements(GL_TRIANGLES, mesh->getIndexCount(), GL_UNSIGNED_INT, 0);
+						buffer->endPacket();
+					}
+				}
+			});
+			{
+				PROFILE_SCOPE("Draw submission");
+				GPU_PROFILE_SCOPE("Scene draws");
+				RenderCommandBuffer::Replay(commandBuffers.data(), sliceCount, sortedPackets);
+			}
+
+			objectRing.endFrame(); // Fence: this region is reused 'FRAMES_IN_FLIGHT' frames from now
+	}
+
+	glUseProgram(0); // Reset program pointer for the next program to be executed
+}
+
+// Value following 'option' on the command line (--step-rate 120), NULL when absent
+const char* GetOptionValue(int argc, char** argv, const char* option) {
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], option) == 0) {
+			return argv[i + 1];
+		}
+	}
+	return NULL;
 }
 
-int main() {
-	mainWindow = Window(1280, 720);
-	mainWindow.Initialize();
+// True when 'option' was passed on the command line
+bool HasOption(int argc, char** argv, const char* option) {
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], option) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char** argv) {
+	// Startup time, up to the main loop (printed before the first frame)
+	auto startupStart = std::chrono::high_resolution_clock::now();
+
+	// CPU-only benchmarks and tools (no window needed)
+	if (argc > 1 && strcmp(argv[1], "--bench-transforms") == 0) {
+		return RunTransformBenchmark(100000, 0.01f);
+	}
+	if (argc > 1 && strcmp(argv[1], "--bench-jobs") == 0) {
+		return RunJobBenchmark(HasOption(argc, argv, "--pin-threads"));
+	}
+	if (argc > 1 && strcmp(argv[1], "--bench-import") == 0) {
+		return RunImportBenchmark(argc > 2 && strncmp(argv[2], "--", 2) != 0 ? argv[2] : NULL);
+	}
+	const char* buildPack = GetOptionValue(argc, argv, "--build-pack");
+	if (buildPack) {
+		return BuildAssetPack(buildPack, HasOption(argc, argv, "--compress"), GetOptionValue(argc, argv, "--mesh"));
+	}
+
+	// CPU profiler zones (debug builds, or PROFILER_ENABLED=1): table every --profile-every <frames> (300 by default,
+	// 0 = off), --profile-trace <file> writes the last zones of every thread as a Chrome trace on exit
+	PROFILE_THREAD("Main");
+	const char* profileEvery = GetOptionValue(argc, argv, "--profile-every");
+	Profiler::setReportInterval(profileEvery ? (unsigned int)atoi(profileEvery) : 300);
+	const char* profileTrace = GetOptionValue(argc, argv, "--profile-trace");
+	if ((profileEvery || profileTrace) && !Profiler::isCompiledIn()) {
+		printf("Profiler zones are compiled out in this build (define PROFILER_ENABLED=1)\n");
+	}
+
+	// Worker threads for the systems (one per remaining core). --pin-threads keeps every thread on its own core
+	JobSystem::Initialize(-1, HasOption(argc, argv, "--pin-threads"));
+	for (unsigned int i = 0; i < JobSystem::getThreadCount(); i++) {
+		commandBuffers.push_back(new RenderCommandBuffer());
+	}
+
+	// --headless renders --frames N (600 by default) offscreen at --size WxH, no display needed
+	int windowWidth = 1280, windowHeight = 720;
+	const char* windowSize = GetOptionValue(argc, argv, "--size");
+	if (windowSize && sscanf(windowSize, "%dx%d", &windowWidth, &windowHeight) != 2) {
+		printf("--size expects WIDTHxHEIGHT, using 1280x720\n");
+		windowWidth = 1280;
+		windowHeight = 720;
+	}
+	// Input sessions: --record <file> saves every key and cursor event, --replay <file> plays one back instead of
+	// the live input (the run ends with the session, headless runs included)
+	InputRecorder inputRecorder;
+	InputReplay inputReplay;
+	const char* replayFile = GetOptionValue(argc, argv, "--replay");
+	if (replayFile && !inputReplay.loadReplay(replayFile)) {
+		JobSystem::Shutdown();
+		return 1;
+	}
+	mainWindow = Window(windowWidth, windowHeight);
+	if (HasOption(argc, argv, "--headless")) {
+		const char* frameCount = GetOptionValue(argc, argv, "--frames");
+		mainWindow.setHeadless(frameCount ? (unsigned int)atoi(frameCount) : replayFile ? UINT_MAX : 600);
+	}
+	if (mainWindow.Initialize() != 0) {
+		JobSystem::Shutdown();
+		return 1;
+	}
+	// GPU zones of the profiler (same build switch as the CPU zones)
+	if (Profiler::isCompiledIn()) {
+		GpuProfiler::Initialize();
+	}
+	if (replayFile) {
+		mainWindow.setInputReplay(&inputReplay);
+		printf("Replaying %u input events from '%s'\n", inputReplay.getEventCount(), replayFile);
+	}
+	const char* recordFile = GetOptionValue(argc, argv, "--record");
+	if (recordFile && inputRecorder.startRecording(recordFile)) {
+		mainWindow.setInputRecorder(&inputRecorder);
+		printf("Recording input to '%s'\n", recordFile);
+	}
+
+	// Assets from one memory-mapped pack (--pack <file>, made by --build-pack) instead of the loose files.
+	// Kept mapped until exit, a loader that does not find its asset in it reads the file as before
+	AssetPack assetPack;
+	const char* packFile = GetOptionValue(argc, argv, "--pack");
+	if (HasOption(argc, argv, "--cold-start")) {
+		EvictAssetFiles(packFile);
+	}
+	if (packFile && assetPack.open(packFile)) {
+		AssetPack::mount(&assetPack);
+		printf("Asset pack '%s': %u assets, %.2f MB mapped\n", packFile, assetPack.getAssetCount(), assetPack.getFileSize() / (1024.0 * 1024.0));
+	}
+	// Processed assets (mip chains, imported meshes, program binaries) from earlier runs: --cache <dir> (AssetCache by
+	// default), capped at --cache-size <MB> (256 by default), --no-cache processes everything at load as before
+	AssetCache assetCache;
+	if (!HasOption(argc, argv, "--no-cache")) {
+		const char* cacheDirectory = GetOptionValue(argc, argv, "--cache");
+		const char* cacheSize = GetOptionValue(argc, argv, "--cache-size");
+		if (assetCache.open(cacheDirectory ? cacheDirectory : "AssetCache", (size_t)(cacheSize ? atof(cacheSize) : 256.0) * 1024 * 1024)) {
+			AssetCache::mount(&assetCache);
+		}
+	}
 
 	// Create the objects
 	CreateObject(); // Set the data in the GPU memory
+	const char* meshFile = GetOptionValue(argc, argv, "--mesh");
+	GLfloat importedScale = 1.0f;
+	GLint importedMesh = meshFile ? AddImportedMesh(meshFile, importedScale) : -1;
 	AddShader(); // Create and compile the shaders through the shader class
+	// 64 KB of per-object constants per frame, 'FRAMES_IN_FLIGHT' frames deep
+	objectRing.Initialize(64 * 1024, FRAMES_IN_FLIGHT);
+	// Stats overlay, hidden unless --hud
+	if (hud.Initialize(textVertexLocation, textFragmentLocation)) {
+		hud.setVisible(HasOption(argc, argv, "--hud"));
+	}
+
+	// Benchmark modes (run and exit)
+	if (argc > 1 && strcmp(argv[1], "--bench-uniforms") == 0) {
+		int result = RunUniformBenchmark(meshList[0], 10000);
+		ReleaseGpuResources();
+		GpuMemoryTracker::reportLeaks();
+		JobSystem::Shutdown();
+		return result;
+	}
+	if (argc > 1 && strcmp(argv[1], "--bench-commands") == 0) {
+		int result = RunCommandBenchmark(meshList[0], 100000);
+		ReleaseGpuResources();
+		GpuMemoryTracker::reportLeaks();
+		JobSystem::Shutdown();
+		return result;
+	}
 
 	// CAMERA
 	//Args: (startPosition, startWorldUp, startYaw, startPitch, startMoveSpeed, startTurnSpeed)
 	camera = Camera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, 0.0f, 5.0f, 8.0f);
+	previousCamera = camera;
+	const char* stepRate = GetOptionValue(argc, argv, "--step-rate");
+	if (stepRate) {
+		simulationClock.setStepRate(atof(stepRate));
+	}
+	// A replay steps at the rate it was recorded with, or the same frame times would give other steps
+	if (replayFile && inputReplay.getStepRate() > 0.0 && fabs(inputReplay.getStepRate() - simulationClock.getStepRate()) > 0.001) {
+		if (stepRate) {
+			printf("--step-rate ignored: the replay was recorded at %.0f Hz\n", inputReplay.getStepRate());
+		}
+		simulationClock.setStepRate(inputReplay.getStepRate());
+	}
 
 	// MATERIAL
 	metalMaterial = Material(1.0f, 32.0f);
 	woodMaterial = Material(0.3f, 4.0f);
 
+	// TEXTURES
+	// Decoding runs on the workers, the GL upload has to stay on this thread
+	brickTexture = Texture((char*)brickLocation);
+	dirtTexture = Texture((char*)dirtLocation);
+	JobCounter decodeCounter;
+	JobSystem::Run("Decode brick.png", []() { brickTexture.decodeTexture(); }, &decodeCounter);
+	JobSystem::Run("Decode dirt.png", []() { dirtTexture.decodeTexture(); }, &decodeCounter);
+	JobSystem::Wait(&decodeCounter);
+	brickTexture.uploadTexture();
+	dirtTexture.uploadTexture();
+
+	// INDIRECT RENDERING
+	bool indirectReady = indirectRenderer.Initialize(indirectVertexLocation, indirectFragmentLocation, cullLocation);
+	if (indirectReady) {
+		indirectRenderer.uploadMeshes();
+		brickLayer = textureArray.addLayer(brickLocation);
+		dirtLayer = textureArray.addLayer(dirtLocation);
+		textureArray.loadTextures();
+	}
+	// Everything decoded is on the GPU now
+	FrameArena::releaseScratch();
+
+	// HOT RELOAD: every object made from a file is reloaded when the file is written again
+	if (HasOption(argc, argv, "--hot-reload")) {
+		bool watching = assetReloader.watchShader(&shaderList[0], vertexLocation, fragmentLocation) &&
+			assetReloader.watchTexture(&brickTexture, brickLocation) &&
+			assetReloader.watchTexture(&dirtTexture, dirtLocation);
+		if (watching && indirectReady) {
+			watching = assetReloader.watchShader(indirectRenderer.getShader(), indirectVertexLocation, indirectFragmentLocation) &&
+				assetReloader.watchTextureLayer(&textureArray, brickLayer, brickLocation) &&
+				assetReloader.watchTextureLayer(&textureArray, dirtLayer, dirtLocation);
+			if (watching && indirectRenderer.getCullShader()->getShaderID() != 0) {
+				// The renderer keeps the locations of the culling uniforms
+				watching = assetReloader.watchComputeShader(indirectRenderer.getCullShader(), cullLocation, []() { indirectRenderer.updateCullUniforms(); });
+			}
+		}
+		printf(watching ? "Hot reload: watching the shaders and textures of the scene\n" : "Hot reload: not available\n");
+	}
+	/********************************
+	*	Scene
+	*********************************/
+	// OBJECTS: transform node + mesh + material + texture
+	GLuint pyramid1Node = sceneTransforms.createNode(TransformHierarchy::NO_PARENT, glm::vec3(0.0f, 0.0f, -2.5f));
+	GLuint pyramid2Node = sceneTransforms.createNode(TransformHierarchy::NO_PARENT, glm::vec3(0.0f, 4.0f, -2.5f));
+	GLuint floorNode = sceneTransforms.createNode(TransformHierarchy::NO_PARENT, glm::vec3(0.0f, -1.0f, 0.0f));
+	scene.createEntity(Transform{ pyramid1Node }, MeshRef{ 0 }, MaterialRef{ &metalMaterial }, TextureRef{ &brickTexture, brickLayer });
+	scene.createEntity(Transform{ pyramid2Node }, MeshRef{ 1 }, MaterialRef{ &metalMaterial }, TextureRef{ &brickTexture, brickLayer });
+	scene.createEntity(Transform{ floorNode }, MeshRef{ 2 }, MaterialRef{ &woodMaterial }, TextureRef{ &dirtTexture, dirtLayer });
+	if (importedMesh >= 0) {
+		GLuint importedNode = sceneTransforms.createNode(TransformHierarchy::NO_PARENT, glm::vec3(4.0f, 0.5f, -2.5f),
+			glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(importedScale));
+		scene.createEntity(Transform{ importedNode }, MeshRef{ (GLuint)importedMesh }, MaterialRef{ &metalMaterial }, TextureRef{ &brickTexture, brickLayer });
+	}
+
 	// DIRECTIONAL LIGHT
-	mainLight = DirectionalLight(1.0f, 1.0f, 1.0f,		// RGB
-								 0.3f, 0.4f,			// ambient | diffuse intensities
-					            -8.0f, -8.0f, -2.0f);	// x, y, z
+	scene.createEntity(DirectionalLightComponent{ DirectionalLight(1.0f, 1.0f, 1.0f,		// RGB
+																	0.3f, 0.4f,				// ambient | diffuse intensities
+																	-8.0f, -8.0f, -2.0f) });	// x, y, z
 
 	// POINT LIGHTS
-	unsigned int pointLightsCount = 0;
-	pointLights[0] = PointLight(0.0f, 1.0f, 1.0f,		// RGB
-							    0.3f, 1.0f,				// ambient | diffuse intensities
-							   -2.0f, 1.0f, -2.0f,		// Position (x, y, z)
-							    0.3f, 0.2f, 0.1);		// constant, linear, exponent
-	pointLightsCount++;
-
-	pointLights[1] = PointLight(0.0f, 0.0f, 1.0f,		// RGB
-							    0.3f, 1.0f,				// ambient | diffuse intensities
-							    2.0f, 1.0f, -2.0f,		// Position (x, y, z)
-								0.3f, 0.2f, 0.1f);		// constant, linear, exponent
-	pointLightsCount++;
-
-	// SPOT LIGHTS
-	unsigned int spotLightsCount = 0;
-	spotLights[0] = SpotLight(1.0f, 1.0f, 1.0f,				// RGB
-						      0.5f, 0.5f,					// ambient | diffuse intensities
-						      0.0f, 1.0f, 5.0f,				// Position (x, y, z)
-					          0.0f, -1.0f, 0.0f,			// Direction (x, y, z)
-						      0.3f, 0.2f, 0.1f, 20.0f);		// constant, linear, exponent, edge
-	spotLightsCount++;
+	scene.createEntity(PointLightComponent{ PointLight(0.0f, 1.0f, 1.0f,		// RGB
+														0.3f, 1.0f,				// ambient | diffuse intensities
+														-2.0f, 1.0f, -2.0f,		// Position (x, y, z)
+														0.3f, 0.2f, 0.1f) });	// constant, linear, exponent
+	scene.createEntity(PointLightComponent{ PointLight(0.0f, 0.0f, 1.0f,		// RGB
+														0.3f, 1.0f,				// ambient | diffuse intensities
+														2.0f, 1.0f, -2.0f,		// Position (x, y, z)
+														0.3f, 0.2f, 0.1f) });	// constant, linear, exponent
 
-	// TEXTURES
-	brickTexture = Texture((char*)"Textures/brick.png");
-	brickTexture.loadTexture();
-	dirtTexture = Texture((char*)"Textures/dirt.png");
-	dirtTexture.loadTexture();
+	// SPOT LIGHTS (flashlight attached to the camera)
+	scene.createEntity(SpotLightComponent{ SpotLight(1.0f, 1.0f, 1.0f,				// RGB
+													0.5f, 0.5f,					// ambient | diffuse intensities
+													0.0f, 1.0f, 5.0f,			// Position (x, y, z)
+													0.0f, -1.0f, 0.0f,			// Direction (x, y, z)
+													0.3f, 0.2f, 0.1f, 20.0f),	// constant, linear, exponent, edge
+											true });
+
+	bool toggleIndirectHeld = false, toggleCullingHeld = false, toggleHudHeld = false;
+	GLfloat statsTimer = 0.0f;
+	unsigned int statsFrames = 0;
+	// Frame time statistics (per second and for the whole run)
+	double statsSum = 0.0, statsSumSquares = 0.0, totalSum = 0.0, totalSumSquares = 0.0, worstFrame = 0.0;
+	unsigned long long totalFrames = 0, statsUpdates = 0;
 
 	// Calculate the 3D PROJECTION
 	// Args: (fovy, display/window aspect ratio, virtual near clip depth, virtual far clip depth)
 	glm::mat4 projection = glm::perspective(glm::radians(45.0f), mainWindow.getBufferWidth() / mainWindow.getBufferHeight(), 0.1f, 100.0f);
 
+	// Single-threaded mode simulates into this packet right before drawing it
+	FramePacket localPacket;
+	GLfloat mouseTotalX = 0.0f, mouseTotalY = 0.0f;
+	std::thread updateThread;
+	// Benchmark mode (--benchmark): the camera follows --camera-path <file> (an orbit by default) or the --replay
+	// session with a fixed time step, live input is ignored. Results go to --bench-out <name>.json/.csv,
+	// --baseline <file> checks them
+	bool benchmarkMode = HasOption(argc, argv, "--benchmark");
+	CameraPath benchmarkPath;
+	BenchmarkRecorder benchmarkRecorder;
+	GLfloat benchmarkTime = 0.0f;
+	bool noInput[1024] = { false };
+	if (benchmarkMode) {
+		const char* pathFile = GetOptionValue(argc, argv, "--camera-path");
+		if (replayFile) {
+			printf("Benchmark: replayed input and frame times, steps of %.2f ms\n", simulationClock.getStepSeconds() * 1000.0f);
+		}
+		else if (!pathFile) {
+			benchmarkPath.createOrbit(glm::vec3(0.0f, 1.0f, -2.5f), 6.0f, 1.5f, 20.0f);
+		}
+		else if (!benchmarkPath.loadPath(pathFile)) {
+			JobSystem::Shutdown();
+			return 1;
+		}
+		if (!replayFile) {
+			printf("Benchmark: %.1f s camera path, fixed step of %.2f ms\n", benchmarkPath.getDuration(), simulationClock.getStepSeconds() * 1000.0f);
+		}
+	}
+	threadedMode = HasOption(argc, argv, "--threaded");
+	if (threadedMode && benchmarkMode) {
+		printf("--threaded is not available with --benchmark (frames would depend on thread timing), ignored\n");
+		threadedMode = false;
+	}
+	if (threadedMode) {
+		printf("Threaded mode: simulation on the update thread, rendering on the main thread\n");
+		updateRunning = true;
+		updateThread = std::thread(UpdateThreadLoop);
+		// Nothing to draw before the first packet
+		while (!framePackets.acquire()) {
+			std::this_thread::yield();
+		}
+		packetsConsumed++;
+	}
+	const char* swapInterval = GetOptionValue(argc, argv, "--vsync");
+	if (swapInterval && mainWindow.isHeadless()) {
+		printf("--vsync is not available with --headless (nothing is presented), ignored\n");
+	}
+	else if (swapInterval) {
+		framePacer.setSwapInterval(atoi(swapInterval));
+	}
+	const char* fpsLimit = GetOptionValue(argc, argv, "--fps");
+	if (fpsLimit) {
+		framePacer.setTargetFps(atof(fpsLimit));
+		printf("Frame rate limited to %.0f FPS\n", framePacer.getTargetFps());
+	}
+	bool onDemand = HasOption(argc, argv, "--on-demand");
+	if (onDemand && threadedMode) {
+		printf("--on-demand is not available with --threaded (the update thread runs continuously), ignored\n");
+		onDemand = false;
+	}
+	if (onDemand && (mainWindow.isHeadless() || benchmarkMode)) {
+		printf("--on-demand is not available with --headless or --benchmark (every frame is drawn), ignored\n");
+		onDemand = false;
+	}
+	unsigned int statsWakeups = 0;
+	double statsCpuStart = GetProcessCpuSeconds();
+	// Iterations that drew nothing (--on-demand): their wall time, the part of it spent asleep and their CPU time
+	double statsIdleSeconds = 0.0, statsSleepSeconds = 0.0, statsIdleCpu = 0.0;
+	unsigned long long statsHeapAllocations = 0, statsWorstHeapAllocations = 0;
+
+	// Everything is loaded: wait for the uploads the driver deferred so they count too
+	glFinish();
+	printf("Startup: %.1f ms (%s)\n", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count(),
+		AssetPack::getMounted() ? "asset pack" : "loose files");
+	if (AssetCache::getMounted()) {
+		assetCache.printSummary();
+	}
+
 	// Run till window gets closed
 	while (!mainWindow.getWindowShouldClose()) {
+		// Reuses the oldest frame's arenas and counts the heap allocations of the previous iteration
+		FrameArena::beginFrame();
+		statsHeapAllocations += FrameArena::getFrameHeapAllocations();
+		statsWorstHeapAllocations = FrameArena::getFrameHeapAllocations() > statsWorstHeapAllocations ? FrameArena::getFrameHeapAllocations() : statsWorstHeapAllocations;
+
 		// Old implementation of FPS control
-		GLfloat now = glfwGetTime();
+		GLfloat now = mainWindow.getTime();
 		deltaTime = now - lastTime;
 		lastTime = now;
+		GLfloat iterationStart = now;
+		double iterationCpuStart = onDemand ? GetProcessCpuSeconds() : 0.0;
 
 		// Activate inputs and events (mouse and keyboard input, for instance)
-		glfwPollEvents();
+		// Nothing to draw in on-demand mode: sleep until an event (or the timeout)
+		{
+			PROFILE_SCOPE("Poll events");
+			mainWindow.pollEvents(onDemand && !RedrawTracker::isDirty() ? (assetReloader.isBusy() ? RELOAD_WAIT_SECONDS : IDLE_WAIT_SECONDS) : 0.0);
+		}
+		// Changed files start reloading, finished reloads are swapped in before this frame is drawn
+		assetReloader.update();
+		statsWakeups++;
+		// Time spent asleep is not frame time: the simulation and the frame stats start again from the wake-up
+		// (a key that woke the loop is not held for the whole sleep)
+		GLfloat sleptTime = 0.0f;
+		if (onDemand) {
+			now = mainWindow.getTime();
+			sleptTime = now - lastTime;
+			lastTime = now;
+		}
 
-		// Set up keyboard and mouse control
-		camera.keyControl(mainWindow.getKeys(), deltaTime);
-		camera.mouseControl(mainWindow.getXChange(), mainWindow.getYChange(), deltaTime);
+		// Time simulated this frame. A replay uses the frame's recorded time (a fixed step for old logs under
+		// --benchmark), so it steps exactly like the recorded run whatever its own frame rate
+		GLfloat frameSeconds = benchmarkMode ? simulationClock.getStepSeconds() : deltaTime;
+		if (replayFile && mainWindow.getReplayFrameSeconds() >= 0.0f) {
+			frameSeconds = mainWindow.getReplayFrameSeconds();
+		}
+		else if (replayFile && inputReplay.getStepRate() > 0.0) {
+			frameSeconds = 0.0f; // Past the recorded frames (the one that ends the session)
+		}
 
-		/********************************
-		*	Background Color
-		*********************************/
-		// Clear window and select a new color
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		// Load the selected color in the GPU memory buffer
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // With the pipe operator both parameters are passed
+		if (benchmarkMode) {
+			if (!replayFile && benchmarkTime > benchmarkPath.getDuration()) {
+				break; // End of the camera path (a replay ends with its session)
+			}
+			benchmarkRecorder.beginFrame();
+		}
 
-		/********************************
-		*	Use Shader
-		*********************************/
-		shaderList[0].UseProgram();
+		FramePacket* packet;
+		if (threadedMode) {
+			// Hand this frame's input to the update thread
+			InputSnapshot& input = inputSnapshots.getWriteBuffer();
+			memcpy(input.keys, mainWindow.getKeys(), sizeof(input.keys));
+			mouseTotalX += mainWindow.getXChange();
+			mouseTotalY += mainWindow.getYChange();
+			input.mouseX = mouseTotalX;
+			input.mouseY = mouseTotalY;
+			inputSnapshots.publish();
 
-		// Set PROJECTION (Camera)
-		// Updates the projection variable in the shader in order to multiply/transform our vertex matrix
-		// Args: (projection, number of projections, should be transposed?, projection values)
-		glUniformMatrix4fv(shaderList[0].getUniformProjection(), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(shaderList[0].getUniformView(), 1, GL_FALSE, glm::value_ptr(camera.calculateViewMatrix()));
-			
-			/********************************
-			*	Lights
-			*********************************/	
-			shaderList[0].setDirectionalLight(&mainLight);
-			//shaderList[0].setPointLight(pointLights, pointLightsCount);
-			// Update flashlight position
-			spotLights[0].SetFlash(camera.getCameraPosition(), camera.getCameraDirection());
-			shaderList[0].setSpotLight(spotLights, spotLightsCount);
+			// Newest finished packet. If the update thread is still busy the previous one is drawn again
+			if (framePackets.acquire()) {
+				packetsConsumed++;
+			}
+			packet = &framePackets.getReadBuffer();
+		}
+		else if (benchmarkMode) {
+			// Scripted camera or replayed input and a fixed time step: every run simulates and draws the same frames
+			if (replayFile) {
+				SimulateFrame(mainWindow.getKeys(), mainWindow.getXChange(), mainWindow.getYChange(), frameSeconds, localPacket);
+			}
+			else {
+				glm::vec3 pathPosition;
+				GLfloat pathYaw, pathPitch;
+				benchmarkPath.sample(benchmarkTime, pathPosition, pathYaw, pathPitch);
+				camera.setPose(pathPosition, pathYaw, pathPitch);
+				SimulateFrame(noInput, 0.0f, 0.0f, frameSeconds, localPacket);
+			}
+			benchmarkTime += frameSeconds;
+			packet = &localPacket;
+		}
+		else {
+			SimulateFrame(mainWindow.getKeys(), mainWindow.getXChange(), mainWindow.getYChange(), frameSeconds, localPacket);
+			packet = &localPacket;
+		}
+		// The update thread steps on its own clock: --threaded sessions have no frame times
+		if (inputRecorder.isRecording() && !threadedMode) {
+			inputRecorder.recordFrame(mainWindow.getEventFrame() - 1, (float)mainWindow.getTime(), frameSeconds, simulationClock.getStepRate());
+		}
 
+		// Without changes the last frame stays on screen: no clear, no draw, no swap
+		bool drawFrame = !onDemand || RedrawTracker::consumeDirty();
+		if (drawFrame) {
+			GpuProfiler::beginFrame();
 			/********************************
-			*	Object 1
+			*	Background Color
 			*********************************/
-			glm::mat4 model(1.0f); // Fill the (4x4) model matrix with 1's
-			model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.5f)); // glm::vec3 returns the specified vector in the correct format
-			//model = glm::scale(model, glm::vec3(0.4f, 0.4f, 0.4f));
-			//model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f)); 
-			// Args: (shader model, number of matrices, should be transposed?, offset model values)
-			glUniformMatrix4fv(shaderList[0].getUniformModel(), 1, GL_FALSE, glm::value_ptr(model)); // Assigns the new offset model to the shader uniModel
-			brickTexture.useTexture(); // Uses the active texture in the buffer
-			metalMaterial.useMaterial(shaderList[0].getUniformSpecularIntensity(), shaderList[0].getUniformShininess());
-			// Render object
-			meshList[0]->RenderMesh(); 
+			// Clear window and select a new color
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			// Load the selected color in the GPU memory buffer
+			{
+				GPU_PROFILE_SCOPE("Clear");
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // With the pipe operator both parameters are passed
+			}
 
-			/********************************
-			*	Object 2
-			*********************************/
-			model = glm::mat4(1.0f); // Creates a 4x4 matrix with 1.0f in every entry
-			model = glm::translate(model, glm::vec3(0.0f, 4.0f, -2.5f));
-			//model = glm::scale(model, glm::vec3(0.4f, 0.4f, 0.4f));
-			glUniformMatrix4fv(shaderList[0].getUniformModel(), 1, GL_FALSE, glm::value_ptr(model));
-			brickTexture.useTexture(); // Uses the active texture in the buffer
-			metalMaterial.useMaterial(shaderList[0].getUniformSpecularIntensity(), shaderList[0].getUniformShininess());
-			// Render object 
-			meshList[1]->RenderMesh();
+			// Toggle between the classic loop and the indirect path (on key press only, not while held)
+			bool* keys = mainWindow.getKeys();
+			if (keys[GLFW_KEY_F1] && !toggleIndirectHeld && IndirectRenderer::isSupported()) {
+				useIndirect = !useIndirect;
+				printf("Render path: %s\n", useIndirect ? "multi-draw indirect" : "classic per-object loop");
+			}
+			if (keys[GLFW_KEY_F2] && !toggleCullingHeld) {
+				indirectRenderer.setGpuCulling(!indirectRenderer.getGpuCulling());
+				printf("Indirect culling: %s\n", indirectRenderer.getGpuCulling() ? "compute shader" : "CPU");
+			}
+			if (keys[GLFW_KEY_F3] && !toggleHudHeld) {
+				hud.setVisible(!hud.isVisible());
+			}
+			toggleIndirectHeld = keys[GLFW_KEY_F1];
+			toggleCullingHeld = keys[GLFW_KEY_F2];
+			toggleHudHeld = keys[GLFW_KEY_F3];
+
+			RenderStats::beginFrame();
+			RenderFrame(*packet, projection);
+
+			// Over the scene, after its stats are final
+			hud.addFrameTime(deltaTime * 1000.0);
+			{
+				PROFILE_SCOPE("HUD");
+				GPU_PROFILE_SCOPE("HUD");
+				hud.render(mainWindow.getBufferWidth(), mainWindow.getBufferHeight(), useIndirect ? "Indirect" : "Classic");
+			}
+			GpuProfiler::endFrame();
 
 			/********************************
-			*	Object 3 FLOOR
+			*	Update Screen
 			*********************************/
-			model = glm::mat4(1.0f); // Creates a 4x4 matrix with 1.0f in every entry
-			model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0f));
-			glUniformMatrix4fv(shaderList[0].getUniformModel(), 1, GL_FALSE, glm::value_ptr(model));
-			dirtTexture.useTexture(); // Uses the active texture in the buffer
-			woodMaterial.useMaterial(shaderList[0].getUniformSpecularIntensity(), shaderList[0].getUniformShininess());
-			// Render object 
-			meshList[2]->RenderMesh();
+			// Hold the frame until its slot when the frame rate is limited
+			{
+				PROFILE_SCOPE("Frame pacing");
+				framePacer.wait();
+			}
+			// Swap buffer -> Executes the instructions queued in the memory buffer
+			{
+				PROFILE_SCOPE("Swap buffers");
+				mainWindow.swapBuffer();
+			}
+			framePacer.endFrame();
+			PROFILE_FRAME();
+			if (benchmarkMode) {
+				benchmarkRecorder.endFrame(RenderStats::getDrawCalls(), RenderStats::getTriangles());
+			}
+		}
 
-		glUseProgram(0); // Reset program pointer for the next program to be executed
+		// Draw calls per frame of the active path, frame time spread and simulation rate, once per second
+		// Only drawn frames count, the idle waits of --on-demand are not frame time
+		if (drawFrame) {
+			double frameMs = deltaTime * 1000.0;
+			statsSum += frameMs;
+			statsSumSquares += frameMs * frameMs;
+			totalSum += frameMs;
+			totalSumSquares += frameMs * frameMs;
+			worstFrame = frameMs > worstFrame ? frameMs : worstFrame;
+			totalFrames++;
+			statsFrames++;
+		}
+		else if (onDemand) {
+			statsIdleSeconds += mainWindow.getTime() - iterationStart;
+			statsSleepSeconds += sleptTime;
+			statsIdleCpu += GetProcessCpuSeconds() - iterationCpuStart;
+		}
+		statsTimer += deltaTime + sleptTime;
+		if (statsTimer >= 1.0f) {
+			double mean = statsFrames > 0 ? statsSum / statsFrames : 0.0;
+			double deviation = statsFrames > 0 ? sqrt(fmax(statsSumSquares / statsFrames - mean * mean, 0.0)) : 0.0;
+			unsigned long long updates = threadedMode ? packetsProduced.load() - statsUpdates : statsWakeups;
+			statsUpdates = packetsProduced.load();
+			printf("%s: %u draw calls/frame, %u objects, %u triangles (%.1f FPS, %.2f +- %.2f ms, %.0f updates/s, update %.2f ms)\n",
+				useIndirect ? "Indirect" : "Classic", RenderStats::getDrawCalls(), RenderStats::getObjects(),
+				RenderStats::getTriangles(), statsFrames / statsTimer, mean, deviation, updates / statsTimer, packet->updateMs);
+			printf("  uniforms: %u uploads, %u skipped as unchanged (last frame)\n", RenderStats::getUniformUploads(), RenderStats::getUniformsSkipped());
+			unsigned int droppedCommands = RenderCommandBuffer::takeDroppedCommands();
+			if (droppedCommands > 0) {
+				printf("  render commands: %u dropped (packet full or no packet open)\n", droppedCommands);
+			}
+			unsigned int steps, droppedSteps;
+			double stepMs, maxStepMs;
+			simulationClock.takeStats(steps, stepMs, maxStepMs, droppedSteps);
+			printf("Simulation: %u steps at %.0f Hz, %.3f ms/step (worst %.3f ms), %u steps dropped\n",
+				steps, simulationClock.getStepRate(), stepMs, maxStepMs, droppedSteps);
+			// Idle cost: how often the loop woke up and how much CPU the process used (100% = one core)
+			double cpuNow = GetProcessCpuSeconds();
+			printf("Main loop: %.0f wakeups/s, %u frames drawn, CPU %.1f%%", statsWakeups / statsTimer, statsFrames,
+				(cpuNow - statsCpuStart) / statsTimer * 100.0);
+			if (onDemand) {
+				printf(" (render on demand: idle %.0f%% of the time, asleep %.0f%%, CPU while idle %.1f%%)",
+					statsIdleSeconds / statsTimer * 100.0, statsSleepSeconds / statsTimer * 100.0,
+					statsIdleSeconds > 0.0 ? statsIdleCpu / statsIdleSeconds * 100.0 : 0.0);
+			}
+			printf("\n");
+			// Heap allocations per loop iteration: zero in the steady state, the transient data lives in the frame arenas
+			printf("Memory: %.1f heap allocations/frame (worst %llu), frame arena %.1f KB/frame, %.1f KB reserved\n",
+				statsWakeups > 0 ? (double)statsHeapAllocations / statsWakeups : 0.0, statsWorstHeapAllocations,
+				FrameArena::getFrameBytes() / 1024.0, FrameArena::getReservedBytes() / 1024.0);
+			statsCpuStart = cpuNow;
+			statsWakeups = 0;
+			statsIdleSeconds = 0.0;
+			statsSleepSeconds = 0.0;
+			statsIdleCpu = 0.0;
+			statsHeapAllocations = 0;
+			statsWorstHeapAllocations = 0;
+			statsTimer = 0.0f;
+			statsFrames = 0;
+			statsSum = 0.0;
+			statsSumSquares = 0.0;
+		}
+	}
 
-		/********************************
-		*	Update Screen
-		*********************************/
-		// Swap buffer -> Executes the instructions queued in the memory buffer
-		mainWindow.swapBuffer();
+	if (threadedMode) {
+		updateRunning = false;
+		updateThread.join();
+	}
+	if (inputRecorder.isRecording()) {
+		inputRecorder.stopRecording(mainWindow.getEventFrame(), (float)mainWindow.getTime());
+		printf("Recorded %u input events to '%s'\n", inputRecorder.getEventCount(), recordFile);
+	}
+	if (totalFrames > 0) {
+		double mean = totalSum / totalFrames;
+		printf("%s loop: %llu frames, frame time %.2f ms mean, %.2f ms std dev, %.2f ms worst\n",
+			threadedMode ? "Threaded" : "Single-threaded", totalFrames, mean,
+			sqrt(fmax(totalSumSquares / totalFrames - mean * mean, 0.0)), worstFrame);
+	}
+	if (framePacer.getFrameCount() > 0) {
+		printf("Frame pacing: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, %.0f ms spent waiting\n", framePacer.getPercentile(50.0),
+			framePacer.getPercentile(95.0), framePacer.getPercentile(99.0), framePacer.getWaitedMs());
+		const char* frameCsv = GetOptionValue(argc, argv, "--frame-csv");
+		if (frameCsv && framePacer.dumpCsv(frameCsv)) {
+			printf("Frame times written to '%s'\n", frameCsv);
+		}
 	}
 
-	return 0;
+	GpuProfiler::Shutdown(); // Before the context goes away with the window
+	if (profileTrace && Profiler::isCompiledIn()) {
+		Profiler::writeTrace(profileTrace);
+	}
+
+	int exitCode = 0;
+	if (benchmarkMode) {
+		benchmarkRecorder.finish();
+		std::string outName = GetOptionValue(argc, argv, "--bench-out") ? GetOptionValue(argc, argv, "--bench-out") : "benchmark";
+		if (benchmarkRecorder.writeJson((outName + ".json").c_str()) && benchmarkRecorder.writeCsv((outName + ".csv").c_str())) {
+			printf("Benchmark: %u frames written to '%s.json' and '%s.csv'\n", benchmarkRecorder.getFrameCount(), outName.c_str(), outName.c_str());
+		}
+		const char* baseline = GetOptionValue(argc, argv, "--baseline");
+		const char* tolerance = GetOptionValue(argc, argv, "--tolerance");
+		if (baseline && !benchmarkRecorder.compareBaseline(baseline, tolerance ? atof(tolerance) : 10.0)) {
+			exitCode = 2; // Lets CI tell a regression from a crash
+		}
+	}
+
+	// GPU memory: peaks of the run, then everything is released and what is left is reported.
+	// --gpu-memory <file> writes the same as JSON (the objects listed are the leaked ones)
+	GpuMemoryTracker::printSummary();
+	ReleaseGpuResources();
+	GpuMemoryTracker::reportLeaks();
+	const char* gpuMemoryFile = GetOptionValue(argc, argv, "--gpu-memory");
+	if (gpuMemoryFile && GpuMemoryTracker::writeJson(gpuMemoryFile)) {
+		printf("GPU memory report written to '%s'\n", gpuMemoryFile);
+	}
+
+	JobSystem::Shutdown();
+	return exitCode;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "SpotLight.h"
+#include "RedrawTracker.h"
 
 SpotLight::SpotLight() : PointLight() {
 	direction = glm::vec3(0.0f, -1.0f, 0.0f); // Setting y to -1 to prevent division by 0
@@ -18,26 +19,10 @@ SpotLight::SpotLight(GLfloat red, GLfloat green, GLfloat blue,
 
 SpotLight::~SpotLight() {}
 
-void SpotLight::UseLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-						GLuint diffuseIntensityLocation, GLuint positionLocation, GLuint directionalLocation,
-						GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation, GLuint edgeLocation) {
-		// Ambient
-		glUniform1f(ambientIntensityLocation, ambientIntensity);
-		glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-		// Diffuse
-		glUniform1f(diffuseIntensityLocation, diffuseIntensity);
-		glUniform3f(positionLocation, position.x, position.y, position.z);
-
-		glUniform3f(directionalLocation, direction.x, direction.y, direction.z);
-
-		glUniform1f(constantLocation, constant);
-		glUniform1f(linearLocation, linear);
-		glUniform1f(exponentLocation, exponent);
-
-		glUniform1f(edgeLocation, edgeProc);
-}
-
 void SpotLight::SetFlash(glm::vec3 pos, glm::vec3 dir) {
+	if (pos != position || dir != direction) {
+		RedrawTracker::markDirty();
+	}
 	position = pos;
 	direction = dir;
 }
@@ -10,9 +10,15 @@ public:
 			GLfloat xPos, GLfloat yPos, GLfloat zPos, GLfloat xDir, GLfloat yDir, GLfloat zDir,
 			GLfloat con, GLfloat lin, GLfloat exp, GLfloat edg);
 	~SpotLight();
-	void UseLight(GLuint ambientIntensityLocation, GLuint ambientColorLocation,
-				GLuint diffuseIntensityLocation, GLuint positionLocation, GLuint directionalLocation,
-				GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation, GLuint edgeLocation);
+	using PointLight::getColor;
+	using PointLight::getAmbientIntensity;
+	using PointLight::getDiffuseIntensity;
+	using PointLight::getPosition;
+	using PointLight::getConstant;
+	using PointLight::getLinear;
+	using PointLight::getExponent;
+	glm::vec3 getDirection() const { return direction; };
+	GLfloat getEdgeCosine() const { return edgeProc; }; // What the shader compares against
 	void SetFlash(glm::vec3 pos, glm::vec3 dir);
 
 private:
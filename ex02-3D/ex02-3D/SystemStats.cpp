@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include "SystemStats.h"
+
+/********************************
+*	Heap allocations
+*********************************/
+// The global operator new/delete are replaced to count the allocations. The array, nothrow and sized forms
+// all end up in these two
+static std::atomic<unsigned long long> heapAllocations(0);
+
+void* operator new(size_t size) {
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(size > 0 ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+unsigned long long GetHeapAllocationCount() {
+	return heapAllocations.load(std::memory_order_relaxed);
+}
+
+/********************************
+*	CPU time
+*********************************/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+double GetProcessCpuSeconds() {
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+		return 0.0;
+	}
+	// FILETIME counts 100 ns intervals
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernelTime.dwLowDateTime;
+	kernel.HighPart = kernelTime.dwHighDateTime;
+	user.LowPart = userTime.dwLowDateTime;
+	user.HighPart = userTime.dwHighDateTime;
+	return (kernel.QuadPart + user.QuadPart) * 1e-7;
+}
+#else
+#include <time.h>
+
+double GetProcessCpuSeconds() {
+	timespec time;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) {
+		return 0.0;
+	}
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+#endif
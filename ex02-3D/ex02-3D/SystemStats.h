@@ -0,0 +1,9 @@
+#pragma once
+
+// CPU time used by the whole process (every thread) since it started, in seconds.
+// Sampled twice, the difference over the wall time gives the CPU usage
+double GetProcessCpuSeconds();
+
+// Heap allocations (every operator new, arena blocks included) since the process started.
+// The difference between two frames is what the frame allocated
+unsigned long long GetHeapAllocationCount();
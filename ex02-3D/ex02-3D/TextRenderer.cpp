@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stddef.h>
+#include "TextRenderer.h"
+#include "GpuMemoryTracker.h"
+
+// Hand-drawn 6 x 11 bitmap font for ASCII 32 to 126. One byte per row from top to bottom, bit 5 is the leftmost
+// pixel
+static const unsigned char FONT_GLYPHS[95][TextRenderer::GLYPH_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+	{ 0x00, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x00, 0x0C, 0x00, 0x00, 0x00 }, // '!'
+	{ 0x00, 0x0C, 0x0C, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '"'
+	{ 0x00, 0x0A, 0x0A, 0x3F, 0x0A, 0x3F, 0x14, 0x14, 0x00, 0x00, 0x00 }, // '#'
+	{ 0x00, 0x00, 0x1E, 0x10, 0x1C, 0x06, 0x06, 0x1E, 0x00, 0x00, 0x00 }, // '$'
+	{ 0x00, 0x18, 0x28, 0x1A, 0x0C, 0x16, 0x05, 0x06, 0x00, 0x00, 0x00 }, // '%'
+	{ 0x00, 0x1C, 0x10, 0x18, 0x1D, 0x27, 0x32, 0x1F, 0x00, 0x00, 0x00 }, // '&'
+	{ 0x00, 0x0C, 0x0C, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // quote
+	{ 0x04, 0x04, 0x08, 0x08, 0x08, 0x08, 0x08, 0x04, 0x04, 0x00, 0x00 }, // '('
+	{ 0x08, 0x08, 0x04, 0x04, 0x04, 0x04, 0x04, 0x08, 0x08, 0x00, 0x00 }, // ')'
+	{ 0x00, 0x12, 0x0C, 0x0C, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '*'
+	{ 0x00, 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00, 0x00, 0x00 }, // '+'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x08, 0x00 }, // ','
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '-'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00 }, // '.'
+	{ 0x00, 0x02, 0x02, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x00, 0x00 }, // '/'
+	{ 0x00, 0x0C, 0x12, 0x12, 0x1E, 0x12, 0x12, 0x0C, 0x00, 0x00, 0x00 }, // '0'
+	{ 0x00, 0x1C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x1E, 0x00, 0x00, 0x00 }, // '1'
+	{ 0x00, 0x1C, 0x12, 0x02, 0x04, 0x08, 0x10, 0x1E, 0x00, 0x00, 0x00 }, // '2'
+	{ 0x00, 0x1C, 0x12, 0x02, 0x0C, 0x02, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // '3'
+	{ 0x00, 0x06, 0x0E, 0x06, 0x16, 0x3F, 0x06, 0x06, 0x00, 0x00, 0x00 }, // '4'
+	{ 0x00, 0x1E, 0x10, 0x1C, 0x02, 0x02, 0x02, 0x1C, 0x00, 0x00, 0x00 }, // '5'
+	{ 0x00, 0x0E, 0x10, 0x10, 0x1E, 0x12, 0x12, 0x0E, 0x00, 0x00, 0x00 }, // '6'
+	{ 0x00, 0x1E, 0x02, 0x06, 0x04, 0x04, 0x08, 0x08, 0x00, 0x00, 0x00 }, // '7'
+	{ 0x00, 0x1E, 0x12, 0x12, 0x1E, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // '8'
+	{ 0x00, 0x1C, 0x12, 0x12, 0x1E, 0x02, 0x06, 0x1C, 0x00, 0x00, 0x00 }, // '9'
+	{ 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00 }, // ':'
+	{ 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x08, 0x00 }, // ';'
+	{ 0x00, 0x00, 0x03, 0x0C, 0x30, 0x0C, 0x03, 0x00, 0x00, 0x00, 0x00 }, // '<'
+	{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '='
+	{ 0x00, 0x00, 0x30, 0x0C, 0x03, 0x0C, 0x30, 0x00, 0x00, 0x00, 0x00 }, // '>'
+	{ 0x00, 0x1E, 0x02, 0x06, 0x0C, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00 }, // '?'
+	{ 0x00, 0x0E, 0x13, 0x27, 0x29, 0x29, 0x29, 0x27, 0x10, 0x0E, 0x00 }, // '@'
+	{ 0x00, 0x0C, 0x0C, 0x0E, 0x12, 0x1E, 0x12, 0x21, 0x00, 0x00, 0x00 }, // 'A'
+	{ 0x00, 0x1E, 0x12, 0x12, 0x1E, 0x12, 0x13, 0x1E, 0x00, 0x00, 0x00 }, // 'B'
+	{ 0x00, 0x0E, 0x18, 0x10, 0x10, 0x10, 0x18, 0x0E, 0x00, 0x00, 0x00 }, // 'C'
+	{ 0x00, 0x1C, 0x12, 0x12, 0x12, 0x12, 0x12, 0x1C, 0x00, 0x00, 0x00 }, // 'D'
+	{ 0x00, 0x1E, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1E, 0x00, 0x00, 0x00 }, // 'E'
+	{ 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00 }, // 'F'
+	{ 0x00, 0x0E, 0x12, 0x10, 0x36, 0x12, 0x12, 0x0E, 0x00, 0x00, 0x00 }, // 'G'
+	{ 0x00, 0x12, 0x12, 0x12, 0x1E, 0x12, 0x12, 0x12, 0x00, 0x00, 0x00 }, // 'H'
+	{ 0x00, 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00, 0x00, 0x00 }, // 'I'
+	{ 0x00, 0x0E, 0x02, 0x02, 0x02, 0x02, 0x06, 0x1C, 0x00, 0x00, 0x00 }, // 'J'
+	{ 0x00, 0x13, 0x16, 0x1C, 0x1C, 0x14, 0x12, 0x13, 0x00, 0x00, 0x00 }, // 'K'
+	{ 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00, 0x00, 0x00 }, // 'L'
+	{ 0x00, 0x33, 0x33, 0x2D, 0x2D, 0x21, 0x21, 0x21, 0x00, 0x00, 0x00 }, // 'M'
+	{ 0x00, 0x12, 0x1A, 0x1A, 0x1E, 0x16, 0x16, 0x12, 0x00, 0x00, 0x00 }, // 'N'
+	{ 0x00, 0x1E, 0x12, 0x12, 0x33, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'O'
+	{ 0x00, 0x1E, 0x13, 0x13, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00 }, // 'P'
+	{ 0x00, 0x1E, 0x12, 0x12, 0x33, 0x12, 0x12, 0x1E, 0x02, 0x00, 0x00 }, // 'Q'
+	{ 0x00, 0x1E, 0x12, 0x12, 0x1C, 0x16, 0x12, 0x11, 0x00, 0x00, 0x00 }, // 'R'
+	{ 0x00, 0x1C, 0x12, 0x10, 0x0C, 0x02, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'S'
+	{ 0x00, 0x3F, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x00, 0x00, 0x00 }, // 'T'
+	{ 0x00, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'U'
+	{ 0x00, 0x33, 0x12, 0x12, 0x12, 0x0C, 0x0C, 0x0C, 0x00, 0x00, 0x00 }, // 'V'
+	{ 0x00, 0x21, 0x21, 0x2D, 0x2D, 0x1E, 0x12, 0x12, 0x00, 0x00, 0x00 }, // 'W'
+	{ 0x00, 0x13, 0x12, 0x0C, 0x0C, 0x0C, 0x12, 0x33, 0x00, 0x00, 0x00 }, // 'X'
+	{ 0x00, 0x33, 0x12, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x00, 0x00, 0x00 }, // 'Y'
+	{ 0x00, 0x1F, 0x02, 0x04, 0x04, 0x08, 0x10, 0x1F, 0x00, 0x00, 0x00 }, // 'Z'
+	{ 0x0C, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0C, 0x00, 0x00 }, // '['
+	{ 0x00, 0x10, 0x10, 0x08, 0x08, 0x04, 0x04, 0x02, 0x02, 0x00, 0x00 }, // backslash
+	{ 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0C, 0x00, 0x00 }, // ']'
+	{ 0x00, 0x0C, 0x1E, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '^'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F, 0x00 }, // '_'
+	{ 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '`'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x02, 0x1E, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'a'
+	{ 0x10, 0x10, 0x10, 0x1E, 0x12, 0x13, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'b'
+	{ 0x00, 0x00, 0x00, 0x0E, 0x10, 0x10, 0x10, 0x0E, 0x00, 0x00, 0x00 }, // 'c'
+	{ 0x02, 0x02, 0x02, 0x1E, 0x12, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'd'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x1F, 0x10, 0x1E, 0x00, 0x00, 0x00 }, // 'e'
+	{ 0x06, 0x0C, 0x08, 0x1E, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00 }, // 'f'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x12, 0x12, 0x1E, 0x02, 0x1C, 0x00 }, // 'g'
+	{ 0x10, 0x10, 0x10, 0x1E, 0x12, 0x12, 0x12, 0x12, 0x00, 0x00, 0x00 }, // 'h'
+	{ 0x04, 0x00, 0x00, 0x1C, 0x04, 0x04, 0x04, 0x1E, 0x00, 0x00, 0x00 }, // 'i'
+	{ 0x04, 0x00, 0x00, 0x1C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x18, 0x00 }, // 'j'
+	{ 0x10, 0x10, 0x10, 0x12, 0x14, 0x1C, 0x16, 0x13, 0x00, 0x00, 0x00 }, // 'k'
+	{ 0x18, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x06, 0x00, 0x00, 0x00 }, // 'l'
+	{ 0x00, 0x00, 0x00, 0x3E, 0x3F, 0x25, 0x25, 0x25, 0x00, 0x00, 0x00 }, // 'm'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x12, 0x12, 0x12, 0x00, 0x00, 0x00 }, // 'n'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'o'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x12, 0x12, 0x1E, 0x10, 0x10, 0x00 }, // 'p'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x12, 0x12, 0x12, 0x1E, 0x02, 0x02, 0x00 }, // 'q'
+	{ 0x00, 0x00, 0x00, 0x0F, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00 }, // 'r'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x10, 0x0E, 0x02, 0x1E, 0x00, 0x00, 0x00 }, // 's'
+	{ 0x00, 0x08, 0x08, 0x1E, 0x08, 0x08, 0x08, 0x0E, 0x00, 0x00, 0x00 }, // 't'
+	{ 0x00, 0x00, 0x00, 0x12, 0x12, 0x12, 0x12, 0x1E, 0x00, 0x00, 0x00 }, // 'u'
+	{ 0x00, 0x00, 0x00, 0x12, 0x12, 0x12, 0x0C, 0x0C, 0x00, 0x00, 0x00 }, // 'v'
+	{ 0x00, 0x00, 0x00, 0x21, 0x21, 0x1E, 0x1E, 0x12, 0x00, 0x00, 0x00 }, // 'w'
+	{ 0x00, 0x00, 0x00, 0x12, 0x0C, 0x0C, 0x0E, 0x12, 0x00, 0x00, 0x00 }, // 'x'
+	{ 0x00, 0x00, 0x00, 0x13, 0x12, 0x0A, 0x0C, 0x0C, 0x08, 0x18, 0x00 }, // 'y'
+	{ 0x00, 0x00, 0x00, 0x1E, 0x02, 0x04, 0x08, 0x1E, 0x00, 0x00, 0x00 }, // 'z'
+	{ 0x06, 0x04, 0x0C, 0x0C, 0x18, 0x0C, 0x0C, 0x04, 0x06, 0x00, 0x00 }, // '{'
+	{ 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x00 }, // '|'
+	{ 0x18, 0x08, 0x0C, 0x0C, 0x06, 0x0C, 0x0C, 0x08, 0x18, 0x00, 0x00 }, // '}'
+	{ 0x00, 0x00, 0x00, 0x00, 0x19, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '~'
+};
+
+static const int SOLID_CELL = 95; // Fully lit cell after the glyphs, used by the rectangles
+
+TextRenderer::TextRenderer() {
+	VAO = 0;
+	VBO = 0;
+	atlasID = 0;
+	uniformScreenSize = NO_UNIFORM;
+	uniformAtlas = NO_UNIFORM;
+	bufferCapacity = 0;
+}
+
+bool TextRenderer::Initialize(const char* vertexLocation, const char* fragmentLocation) {
+	shader.CreateFromFile(vertexLocation, fragmentLocation);
+	if (shader.getShaderID() == 0) {
+		printf("Text renderer not available: the shaders did not build\n");
+		return false;
+	}
+	uniformScreenSize = shader.getUniform("screenSize", GL_FLOAT_VEC2);
+	uniformAtlas = shader.getUniform("glyphAtlas", GL_SAMPLER_2D);
+
+	createAtlas();
+
+	glGenVertexArrays(1, &VAO);
+	glBindVertexArray(VAO);
+	GpuMemoryTracker::trackObject(GL_VERTEX_ARRAY, VAO, GPU_MEMORY_GEOMETRY, 0, "Text VAO");
+		glGenBuffers(1, &VBO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			// Storage is allocated by draw(), sized to the quads of the frame
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, x));
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, u));
+			// Colors are bytes, normalized to 0..1 by the vertex fetch
+			glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex), (void*)offsetof(TextVertex, r));
+			glEnableVertexAttribArray(0);
+			glEnableVertexAttribArray(1);
+			glEnableVertexAttribArray(2);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	return true;
+}
+
+// Expands the 1 bit font into a single channel texture, 16 cells per row
+void TextRenderer::createAtlas() {
+	const int atlasWidth = ATLAS_COLUMNS * GLYPH_WIDTH, atlasHeight = ATLAS_ROWS * GLYPH_HEIGHT;
+	std::vector<unsigned char> pixels((size_t)atlasWidth * atlasHeight, 0);
+	for (int cell = 0; cell <= SOLID_CELL; cell++) {
+		int cellX = (cell % ATLAS_COLUMNS) * GLYPH_WIDTH, cellY = (cell / ATLAS_COLUMNS) * GLYPH_HEIGHT;
+		for (int y = 0; y < GLYPH_HEIGHT; y++) {
+			for (int x = 0; x < GLYPH_WIDTH; x++) {
+				bool lit = cell == SOLID_CELL || (FONT_GLYPHS[cell][y] >> (GLYPH_WIDTH - 1 - x)) & 1;
+				pixels[(size_t)(cellY + y) * atlasWidth + cellX + x] = lit ? 255 : 0;
+			}
+		}
+	}
+
+	glGenTextures(1, &atlasID);
+	glBindTexture(GL_TEXTURE_2D, atlasID);
+		// Pixel font: no filtering, no mipmaps
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows of single bytes
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GpuMemoryTracker::trackObject(GL_TEXTURE, atlasID, GPU_MEMORY_TEXTURE, (long long)atlasWidth * atlasHeight, "Font atlas");
+}
+
+/********************************
+*	Batching
+*********************************/
+void TextRenderer::begin() {
+	vertices.clear(); // Keeps the capacity
+}
+
+void TextRenderer::addQuad(GLfloat x, GLfloat y, GLfloat width, GLfloat height, int cell, GLuint color) {
+	GLfloat u0 = (GLfloat)(cell % ATLAS_COLUMNS) / ATLAS_COLUMNS, v0 = (GLfloat)(cell / ATLAS_COLUMNS) / ATLAS_ROWS;
+	GLfloat u1 = u0 + 1.0f / ATLAS_COLUMNS, v1 = v0 + 1.0f / ATLAS_ROWS;
+	GLubyte r = (GLubyte)(color >> 24), g = (GLubyte)(color >> 16), b = (GLubyte)(color >> 8), a = (GLubyte)color;
+	TextVertex corners[4] = {
+		{ x, y, u0, v0, r, g, b, a }, // Top left
+		{ x + width, y, u1, v0, r, g, b, a }, // Top right
+		{ x, y + height, u0, v1, r, g, b, a }, // Bottom left
+		{ x + width, y + height, u1, v1, r, g, b, a } // Bottom right
+	};
+	// Two triangles, no index buffer
+	vertices.push_back(corners[0]);
+	vertices.push_back(corners[2]);
+	vertices.push_back(corners[1]);
+	vertices.push_back(corners[1]);
+	vertices.push_back(corners[2]);
+	vertices.push_back(corners[3]);
+}
+
+GLfloat TextRenderer::addText(GLfloat x, GLfloat y, const char* text, GLuint color, GLfloat scale) {
+	GLfloat penX = x;
+	for (const char* c = text; *c; c++) {
+		if (*c > 32 && *c < 127) { // Spaces only move the pen
+			addQuad(penX, y, GLYPH_WIDTH * scale, GLYPH_HEIGHT * scale, *c - 32, color);
+		}
+		penX += GLYPH_WIDTH * scale;
+	}
+	return penX - x;
+}
+
+void TextRenderer::addRect(GLfloat x, GLfloat y, GLfloat width, GLfloat height, GLuint color) {
+	addQuad(x, y, width, height, SOLID_CELL, color);
+}
+
+void TextRenderer::draw(GLfloat screenWidth, GLfloat screenHeight) {
+	if (vertices.empty() || shader.getShaderID() == 0) {
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		GLsizeiptr size = (GLsizeiptr)(sizeof(TextVertex) * vertices.size());
+		if (size > bufferCapacity) {
+			bufferCapacity = size * 2; // Room to grow without reallocating every frame
+			glBufferData(GL_ARRAY_BUFFER, bufferCapacity, NULL, GL_STREAM_DRAW);
+			GpuMemoryTracker::trackObject(GL_BUFFER, VBO, GPU_MEMORY_GEOMETRY, bufferCapacity, "Text vertices");
+		}
+		else {
+			// Orphan last frame's storage (the GPU may still read it) and write the new quads
+			glBufferData(GL_ARRAY_BUFFER, bufferCapacity, NULL, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	shader.UseProgram();
+	shader.setUniform(uniformScreenSize, glm::vec2(screenWidth, screenHeight));
+	shader.setUniform(uniformAtlas, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasID);
+	glBindVertexArray(VAO);
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (!blend) {
+		glDisable(GL_BLEND);
+	}
+}
+
+void TextRenderer::clearTextRenderer() {
+	if (VAO != 0) {
+		GpuMemoryTracker::releaseObject(GL_VERTEX_ARRAY, VAO);
+		glDeleteVertexArrays(1, &VAO);
+		VAO = 0;
+	}
+	if (VBO != 0) {
+		GpuMemoryTracker::releaseObject(GL_BUFFER, VBO);
+		glDeleteBuffers(1, &VBO);
+		VBO = 0;
+	}
+	if (atlasID != 0) {
+		GpuMemoryTracker::releaseObject(GL_TEXTURE, atlasID);
+		glDeleteTextures(1, &atlasID);
+		atlasID = 0;
+	}
+	bufferCapacity = 0;
+	shader.ClearShader();
+}
+
+TextRenderer::~TextRenderer() {
+	clearTextRenderer();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+
+#include "Shader.h"
+
+// Screen-space quad corner: position in pixels (top left origin), atlas coordinates and color
+struct TextVertex
+{
+	GLfloat x, y;
+	GLfloat u, v;
+	GLubyte r, g, b, a;
+};
+
+// Text and filled rectangles for overlays. Everything added between begin() and draw() goes to one
+// dynamic vertex buffer and is drawn with a single call: glyphs are cells of a built-in bitmap font atlas,
+// rectangles use a solid cell of the same atlas, so there is no texture or program switch in between.
+// Only printable ASCII (32 to 126) is drawn, anything else shows as a space
+class TextRenderer
+{
+public:
+	static const int GLYPH_WIDTH = 6; // Pixels at scale 1 (monospaced)
+	static const int GLYPH_HEIGHT = 11;
+
+	TextRenderer();
+	~TextRenderer();
+
+	bool Initialize(const char* vertexLocation, const char* fragmentLocation);
+	void clearTextRenderer(); // Deletes the GL objects (also done by the destructor)
+
+	void begin(); // Drops the quads of the previous frame
+	// Colors are 0xRRGGBBAA. Returns the width of the text in pixels
+	GLfloat addText(GLfloat x, GLfloat y, const char* text, GLuint color, GLfloat scale);
+	void addRect(GLfloat x, GLfloat y, GLfloat width, GLfloat height, GLuint color);
+	// Uploads the quads and draws them over the current framebuffer (alpha blended, no depth test)
+	void draw(GLfloat screenWidth, GLfloat screenHeight);
+
+	GLsizei getQuadCount() { return (GLsizei)(vertices.size() / 6); };
+
+private:
+	static const int ATLAS_COLUMNS = 16;
+	static const int ATLAS_ROWS = 6; // 95 glyphs and the solid cell
+
+	Shader shader;
+	GLuint VAO, VBO, atlasID;
+	UniformHandle uniformScreenSize, uniformAtlas;
+	GLsizeiptr bufferCapacity; // Bytes allocated for the VBO
+	std::vector<TextVertex> vertices;
+
+	void addQuad(GLfloat x, GLfloat y, GLfloat width, GLfloat height, int cell, GLuint color);
+	void createAtlas();
+};
@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "GpuMemoryTracker.h"
 
 Texture::Texture() {
 	textureID = 0;
@@ -6,6 +7,9 @@ Texture::Texture() {
 	height = 0;
 	bitDepth = 0;
 	fileLocation = NULL;
+	texData = NULL;
+	packedImage = NULL;
+	cachedImage = NULL;
 }
 
 Texture::Texture(char* fileLoc) {
@@ -14,15 +18,101 @@ Texture::Texture(char* fileLoc) {
 	height = 0;
 	bitDepth = 0;
 	fileLocation = fileLoc;
+	texData = NULL;
+	packedImage = NULL;
+	cachedImage = NULL;
 }
 
 void Texture::loadTexture() {
+	decodeTexture();
+	uploadTexture();
+}
+
+bool Texture::decodeTexture(bool usePack) {
+	// Already decoded, mipmapped (and maybe compressed) in the mounted asset pack
+	AssetPack* pack = usePack ? AssetPack::getMounted() : NULL;
+	packedImage = pack ? pack->findAsset(fileLocation, ASSET_TEXTURE) : NULL;
+	if (packedImage && AssetPack::isTextureSupported(packedImage)) {
+		width = (int)packedImage->width;
+		height = (int)packedImage->height;
+		return true;
+	}
+	packedImage = NULL;
+	// Mipmapped by an earlier run (or now, once for the next ones) in the asset cache
+	AssetCache* cache = AssetCache::getMounted();
+	if (cache && decodeCachedTexture(cache)) {
+		return true;
+	}
+
 	// 'stbi_load' stores the width, height and bit depth of the loaded image in the addresses passed to it
 	/* Args: (file location, address where w will be returned, address where h will be returned, address where the bitD
 	will be returned, desired channel) */
-	unsigned char* texData = stbi_load(fileLocation, &width, &height, &bitDepth, 0);
+	texData = stbi_load(fileLocation, &width, &height, &bitDepth, 0);
 	if (!texData) {
 		printf("Failed to load image: '%s'\n", fileLocation);
+		return false;
+	}
+	return true;
+}
+
+// The same RGBA8 mip chain an asset pack has, keyed by the bytes of the image file
+bool Texture::decodeCachedTexture(AssetCache* cache) {
+	uint64_t key = AssetCache::hashString(fileLocation, AssetCache::hashString("Texture RGBA8 mipmaps 1"));
+	if (!AssetCache::hashFile(fileLocation, key)) {
+		return false;
+	}
+	cachedImage = new AssetPack();
+	if (!cache->find(key, *cachedImage)) {
+		// Not stored (disk full...): decoded the usual way instead
+		AssetPackWriter writer;
+		if (writer.addTexture(fileLocation, false)) {
+			cache->store(key, writer, cachedImage);
+		}
+	}
+	packedImage = cachedImage->findAsset(fileLocation, ASSET_TEXTURE);
+	if (!packedImage) {
+		delete cachedImage;
+		cachedImage = NULL;
+		return false;
+	}
+	width = (int)packedImage->width;
+	height = (int)packedImage->height;
+	return true;
+}
+
+// Every level of the packed chain, straight from the mapped pages
+void Texture::uploadPackedLevels(AssetPack* pack) {
+	GLenum internalFormat = AssetPack::getInternalFormat(packedImage);
+	for (unsigned int level = 0; level < packedImage->mipCount; level++) {
+		GLsizei levelSize, levelWidth, levelHeight;
+		const void* pixels = pack->getTextureLevel(packedImage, level, levelSize, levelWidth, levelHeight);
+		if (packedImage->format == ASSET_TEXTURE_RGBA8) {
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0, levelSize, pixels);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)packedImage->mipCount - 1);
+}
+
+void Texture::uploadTexture() {
+	AssetPack* pack = cachedImage ? cachedImage : AssetPack::getMounted();
+	if (packedImage && pack) {
+		glGenTextures(1, &textureID);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		// Same filters as below
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		uploadPackedLevels(pack);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		GpuMemoryTracker::trackObject(GL_TEXTURE, textureID, GPU_MEMORY_TEXTURE, (long long)packedImage->size, fileLocation);
+		packedImage = NULL;
+		delete cachedImage;
+		cachedImage = NULL;
+		return;
 	}
 
 	glGenTextures(1, &textureID); // Generates texture and returns an ID
@@ -40,7 +130,10 @@ void Texture::loadTexture() {
 		glGenerateMipmap(GL_TEXTURE_2D); // Generate mipmaps
 
 	glBindTexture(GL_TEXTURE_2D, 0); // Reset texture pointer for the next texture to be processed
+	// RGBA8 plus the mipmaps (a third more)
+	GpuMemoryTracker::trackObject(GL_TEXTURE, textureID, GPU_MEMORY_TEXTURE, (long long)width * height * 4 * 4 / 3, fileLocation);
 	stbi_image_free(texData); // Free RAM allocation for the loaded image
+	texData = NULL;
 }
 
 void Texture::useTexture() {
@@ -50,12 +143,28 @@ void Texture::useTexture() {
 }
 
 void Texture::clearTexture() {
+	if (texData) {
+		stbi_image_free(texData); // Decoded but never uploaded
+		texData = NULL;
+	}
+	GpuMemoryTracker::releaseObject(GL_TEXTURE, textureID);
 	glDeleteTextures(1, &textureID);
 	textureID = 0;
 	width = 0;
 	height = 0;
 	bitDepth = 0;
 	fileLocation = NULL;
+	packedImage = NULL;
+	cachedImage = NULL;
+}
+
+void Texture::adoptTexture(Texture& other) {
+	clearTexture();
+	*this = other;
+	// Owned here now, not deleted with 'other'
+	other.textureID = 0;
+	other.texData = NULL;
+	other.cachedImage = NULL;
 }
 
 Texture::~Texture() {
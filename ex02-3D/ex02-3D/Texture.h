@@ -1,6 +1,8 @@
 #pragma once
 #include <GL\glew.h>
 #include "stb_image.h"
+#include "AssetPack.h"
+#include "AssetCache.h"
 
 class Texture
 {
@@ -9,13 +11,27 @@ public:
 	Texture(char* fileLoc);
 	~Texture();
 
-	void loadTexture();
+	void loadTexture(); // decodeTexture() + uploadTexture()
+	// Reads and decodes the file (nothing to do when the mounted asset pack has it and 'usePack', the mip chain comes
+	// from the mounted asset cache when there is one). No GL calls, safe to run on a worker thread
+	bool decodeTexture(bool usePack = true);
+	void uploadTexture(); // Sends the decoded image (or the packed / cached mip chain) to the GPU (GL thread only)
 	void useTexture();
 	void clearTexture();
+	// Takes over the uploaded texture of 'other' (hot reload), deleting the current one
+	void adoptTexture(Texture& other);
+
+	GLuint getTextureID() { return textureID; };
 
 private:
 	GLuint textureID;
 	int width, height, bitDepth;
 	char* fileLocation;
+	unsigned char* texData; // Decoded pixels waiting for uploadTexture()
+	const AssetPackEntry* packedImage; // In the mounted pack instead, uploaded from the mapped file
+	AssetPack* cachedImage; // Entry of the asset cache 'packedImage' is in, if it came from there
+
+	bool decodeCachedTexture(AssetCache* cache);
+	void uploadPackedLevels(AssetPack* pack);
 };
 
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include "TextureArray.h"
+#include "JobSystem.h"
+#include "RenderStats.h"
+#include "GpuMemoryTracker.h"
+#include "stb_image.h"
+
+TextureArray::TextureArray() {
+	textureID = 0;
+	width = 0;
+	height = 0;
+	internalFormat = GL_RGBA8;
+}
+
+GLint TextureArray::addLayer(const char* fileLoc) {
+	fileLocations.push_back(fileLoc);
+	return (GLint)fileLocations.size() - 1;
+}
+
+std::string TextureArray::getPackName(const std::vector<const char*>& layerLocations) {
+	std::string name = "array:";
+	for (size_t layer = 0; layer < layerLocations.size(); layer++) {
+		name += (layer > 0 ? "|" : "") + std::string(layerLocations[layer]);
+	}
+	return name;
+}
+
+void TextureArray::resizeLayer(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight) {
+	for (int y = 0; y < dstHeight; y++) {
+		int sy = y * srcHeight / dstHeight;
+		for (int x = 0; x < dstWidth; x++) {
+			int sx = x * srcWidth / dstWidth;
+			const unsigned char* s = src + (sy * srcWidth + sx) * 4;
+			unsigned char* d = dst + (y * dstWidth + x) * 4;
+			d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+		}
+	}
+}
+
+// Every level of the packed array (all the layers at once) from the mapped pages, nothing decoded.
+// False (nothing created) when the pack does not have this exact list of layers
+bool TextureArray::loadPackedTextures(AssetPack* pack) {
+	const AssetPackEntry* packed = pack ? pack->findAsset(getPackName(fileLocations).c_str(), ASSET_TEXTURE) : NULL;
+	if (!packed || packed->layers != fileLocations.size() || !AssetPack::isTextureSupported(packed)) {
+		return false;
+	}
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	width = (int)packed->width;
+	height = (int)packed->height;
+	internalFormat = AssetPack::getInternalFormat(packed);
+	for (unsigned int level = 0; level < packed->mipCount; level++) {
+		GLsizei levelSize, levelWidth, levelHeight;
+		const void* pixels = pack->getTextureLevel(packed, level, levelSize, levelWidth, levelHeight);
+		if (packed->format == ASSET_TEXTURE_RGBA8) {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, levelWidth, levelHeight, (GLsizei)packed->layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		else {
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, levelWidth, levelHeight, (GLsizei)packed->layers, 0, levelSize, pixels);
+		}
+	}
+
+	// Same filters as below, the mipmaps come from the pack
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)packed->mipCount - 1);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	GpuMemoryTracker::trackObject(GL_TEXTURE, textureID, GPU_MEMORY_TEXTURE, (long long)packed->size, "Texture array");
+	return true;
+}
+
+// The array as an asset pack has it (resized layers, RGBA8 mip chain), keyed by the bytes of every layer file
+bool TextureArray::loadCachedTextures(AssetCache* cache) {
+	std::string name = getPackName(fileLocations);
+	uint64_t key = AssetCache::hashString(name.c_str(), AssetCache::hashString("Texture array RGBA8 mipmaps 1"));
+	for (size_t layer = 0; layer < fileLocations.size(); layer++) {
+		if (!AssetCache::hashFile(fileLocations[layer], key)) {
+			return false;
+		}
+	}
+	AssetPack entry;
+	if (!cache->find(key, entry)) {
+		AssetPackWriter writer;
+		if (!writer.addTextureArray(name.c_str(), fileLocations, false) || !cache->store(key, writer, &entry)) {
+			return false;
+		}
+	}
+	return loadPackedTextures(&entry);
+}
+
+bool TextureArray::loadTextures() {
+	if (fileLocations.empty()) {
+		return false;
+	}
+	if (loadPackedTextures(AssetPack::getMounted())) {
+		return true; // Ready to upload in the mounted asset pack
+	}
+	AssetCache* cache = AssetCache::getMounted();
+	if (cache && loadCachedTextures(cache)) {
+		return true;
+	}
+
+	// Decode every file in parallel (no GL involved), then upload them one by one on this thread
+	struct DecodedLayer { unsigned char* data; int width, height; };
+	std::vector<DecodedLayer> decoded(fileLocations.size());
+	JobSystem::parallelFor("Decode texture layer", fileLocations.size(), 1, [this, &decoded](size_t begin, size_t end) {
+		for (size_t layer = begin; layer < end; layer++) {
+			int bitDepth;
+			// Force 4 channels so every layer shares the same RGBA8 format
+			decoded[layer].data = stbi_load(fileLocations[layer], &decoded[layer].width, &decoded[layer].height, &bitDepth, 4);
+		}
+	});
+
+	bool success = true;
+	for (size_t layer = 0; layer < decoded.size(); layer++) {
+		if (!decoded[layer].data) {
+			printf("Failed to load image: '%s'\n", fileLocations[layer]);
+			success = false;
+		}
+	}
+	if (!success) {
+		for (size_t layer = 0; layer < decoded.size(); layer++) {
+			stbi_image_free(decoded[layer].data);
+		}
+		return false;
+	}
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+	// The first texture defines the size of every layer
+	width = decoded[0].width;
+	height = decoded[0].height;
+	internalFormat = GL_RGBA8;
+	// Args: (target, mip level, internal format, w, h, layer count, border, format, type, data)
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, (GLsizei)fileLocations.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	for (size_t layer = 0; layer < decoded.size(); layer++) {
+		const DecodedLayer& image = decoded[layer];
+		if (image.width == width && image.height == height) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
+		}
+		else {
+			std::vector<unsigned char> resized((size_t)width * height * 4);
+			resizeLayer(image.data, image.width, image.height, resized.data(), width, height);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, resized.data());
+		}
+		stbi_image_free(image.data);
+	}
+
+		// Same filters as the single 2D textures
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	// RGBA8 layers plus their mipmaps (a third more)
+	GpuMemoryTracker::trackObject(GL_TEXTURE, textureID, GPU_MEMORY_TEXTURE, (long long)width * height * 4 * getLayerCount() * 4 / 3, "Texture array");
+	return true;
+}
+
+bool TextureArray::replaceLayer(GLint layer, const unsigned char* pixels) {
+	if (internalFormat != GL_RGBA8) {
+		return false;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return true;
+}
+
+void TextureArray::useTextureArray(GLenum textureUnit) {
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	RenderStats::addStateChange();
+}
+
+void TextureArray::clearTextureArray() {
+	GpuMemoryTracker::releaseObject(GL_TEXTURE, textureID);
+	glDeleteTextures(1, &textureID);
+	textureID = 0;
+	width = 0;
+	height = 0;
+	internalFormat = GL_RGBA8;
+	fileLocations.clear();
+}
+
+TextureArray::~TextureArray() {
+	clearTextureArray();
+}
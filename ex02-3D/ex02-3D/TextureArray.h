@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <GL\glew.h>
+
+#include "AssetPack.h"
+#include "AssetCache.h"
+
+// All the scene textures in a single GL_TEXTURE_2D_ARRAY, so objects can select theirs by layer
+// instead of rebinding a texture between draws
+class TextureArray
+{
+public:
+	TextureArray();
+	~TextureArray();
+
+	// Queues a file and returns the layer it will occupy
+	GLint addLayer(const char* fileLoc);
+	// Decodes every queued file and uploads them. Layers are resized to the size of the first one.
+	// When the mounted asset pack has the array (same layers), it is uploaded from there instead, otherwise from the
+	// mounted asset cache (processed into it on a miss)
+	bool loadTextures();
+	void useTextureArray(GLenum textureUnit);
+	void clearTextureArray();
+
+	// Replaces level 0 of a layer (RGBA8 at the size of the array) and rebuilds the mipmaps. False for a compressed
+	// array (from a BC1 asset pack), which cannot take RGBA8 texels
+	bool replaceLayer(GLint layer, const unsigned char* pixels);
+
+	GLint getLayerCount() { return (GLint)fileLocations.size(); };
+	int getWidth() { return width; };
+	int getHeight() { return height; };
+
+	// Name of the array in an asset pack: its layers, in order ("array:Textures/brick.png|Textures/dirt.png")
+	static std::string getPackName(const std::vector<const char*>& layerLocations);
+	// Nearest neighbour resize (RGBA8), how a layer of another size is fitted to the array
+	static void resizeLayer(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight);
+
+private:
+	GLuint textureID;
+	int width, height;
+	GLenum internalFormat;
+	std::vector<const char*> fileLocations;
+
+	bool loadPackedTextures(AssetPack* pack);
+	bool loadCachedTextures(AssetCache* cache);
+};
+
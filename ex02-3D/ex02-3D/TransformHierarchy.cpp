@@ -0,0 +1,225 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include "RedrawTracker.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define TRANSFORM_USE_SSE
+#endif
+
+TransformHierarchy::TransformHierarchy() {
+	firstDirty = 0;
+	updatedCount = 0;
+	settledCount = 0;
+}
+
+void TransformHierarchy::reserve(size_t nodeCount) {
+	parents.reserve(nodeCount);
+	depths.reserve(nodeCount);
+	localPositions.reserve(nodeCount);
+	localRotations.reserve(nodeCount);
+	localScales.reserve(nodeCount);
+	localMatrices.reserve(nodeCount);
+	worldMatrices.reserve(nodeCount);
+	previousWorldMatrices.reserve(nodeCount);
+	localDirty.reserve(nodeCount);
+	worldDirty.reserve(nodeCount);
+}
+
+GLuint TransformHierarchy::createNode(GLuint parent, glm::vec3 position, glm::quat rotation, glm::vec3 scale) {
+	GLuint node = (GLuint)parents.size();
+	parents.push_back(parent);
+	depths.push_back(parent == NO_PARENT ? 0 : depths[parent] + 1);
+	localPositions.push_back(position);
+	localRotations.push_back(rotation);
+	localScales.push_back(scale);
+	localMatrices.push_back(glm::mat4(1.0f));
+	worldMatrices.push_back(glm::mat4(1.0f));
+	previousWorldMatrices.push_back(glm::mat4(1.0f));
+	localDirty.push_back(0);
+	worldDirty.push_back(0);
+	markDirty(node);
+	return node;
+}
+
+void TransformHierarchy::markDirty(GLuint node) {
+	RedrawTracker::markDirty();
+	if (!localDirty[node]) {
+		localDirty[node] = 1;
+		if (node < firstDirty) {
+			firstDirty = node;
+		}
+	}
+}
+
+void TransformHierarchy::setLocalPosition(GLuint node, const glm::vec3& position) {
+	localPositions[node] = position;
+	markDirty(node);
+}
+
+void TransformHierarchy::setLocalRotation(GLuint node, const glm::quat& rotation) {
+	localRotations[node] = rotation;
+	markDirty(node);
+}
+
+void TransformHierarchy::setLocalScale(GLuint node, const glm::vec3& scale) {
+	localScales[node] = scale;
+	markDirty(node);
+}
+
+// Local matrix = T * R * S written directly (no intermediate matrix products)
+void TransformHierarchy::composeLocal(GLuint node) {
+	const glm::quat& q = localRotations[node];
+	const glm::vec3& s = localScales[node];
+	const glm::vec3& t = localPositions[node];
+	GLfloat xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	GLfloat xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	GLfloat wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	glm::mat4& m = localMatrices[node];
+	m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+	m[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+	m[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+	m[3] = glm::vec4(t, 1.0f);
+}
+
+void TransformHierarchy::update() {
+	updatedCount = 0;
+	GLuint count = (GLuint)parents.size();
+
+	// What moved in the previous update is now at rest at its current matrix
+	for (size_t i = 0; i < movedNodes.size(); i++) {
+		previousWorldMatrices[movedNodes[i]] = worldMatrices[movedNodes[i]];
+	}
+	movedNodes.clear();
+	if (firstDirty >= count) {
+		return; // Nothing moved since the last update
+	}
+
+	// Propagation: parents come first, so one forward pass marks every node below a dirty one.
+	// Dirty nodes are bucketed by depth; each bucket is then a batch of independent matrix products
+	for (size_t i = 0; i < levels.size(); i++) {
+		levels[i].clear();
+	}
+	for (GLuint node = firstDirty; node < count; node++) {
+		GLuint parent = parents[node];
+		worldDirty[node] = localDirty[node] | (parent != NO_PARENT ? worldDirty[parent] : 0);
+		if (!worldDirty[node]) {
+			continue;
+		}
+		if (localDirty[node]) {
+			composeLocal(node);
+			localDirty[node] = 0;
+		}
+		if (depths[node] >= levels.size()) {
+			levels.resize(depths[node] + 1);
+		}
+		levels[depths[node]].push_back(node);
+	}
+
+	updateLevels();
+	for (GLuint node = firstDirty; node < count; node++) {
+		worldDirty[node] = 0;
+	}
+	firstDirty = count;
+
+	for (size_t depth = 0; depth < levels.size(); depth++) {
+		movedNodes.insert(movedNodes.end(), levels[depth].begin(), levels[depth].end());
+	}
+	// New nodes appear where they are, there is nothing to interpolate from
+	for (GLuint node = settledCount; node < count; node++) {
+		previousWorldMatrices[node] = worldMatrices[node];
+	}
+	settledCount = count;
+}
+
+glm::mat4 TransformHierarchy::getInterpolatedMatrix(GLuint node, GLfloat alpha) {
+	if (alpha >= 1.0f) {
+		return worldMatrices[node];
+	}
+	return InterpolateMatrix(previousWorldMatrices[node], worldMatrices[node], alpha);
+}
+
+void TransformHierarchy::updateLevels() {
+	for (size_t depth = 0; depth < levels.size(); depth++) {
+		const std::vector<GLuint>& level = levels[depth];
+		// Nodes of one level are independent: large levels are split across the job system
+		JobSystem::parallelFor("Transform level", level.size(), PARALLEL_GRAIN, [this, &level](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				GLuint node = level[i];
+				GLuint parent = parents[node];
+				if (parent == NO_PARENT) {
+					worldMatrices[node] = localMatrices[node];
+				}
+				else {
+					MultiplyMatrices(worldMatrices[parent], localMatrices[node], worldMatrices[node]);
+				}
+			}
+		});
+		updatedCount += (unsigned int)level.size();
+	}
+}
+
+void TransformHierarchy::updateAll() {
+	GLuint count = (GLuint)parents.size();
+	for (GLuint node = 0; node < count; node++) {
+		composeLocal(node);
+		localDirty[node] = 0;
+		GLuint parent = parents[node];
+		if (parent == NO_PARENT) {
+			worldMatrices[node] = localMatrices[node];
+		}
+		else {
+			MultiplyMatrices(worldMatrices[parent], localMatrices[node], worldMatrices[node]);
+		}
+	}
+	updatedCount = count;
+	firstDirty = count;
+	previousWorldMatrices = worldMatrices; // Full recompute: no interpolation
+	movedNodes.clear();
+	settledCount = count;
+}
+
+glm::mat4 InterpolateMatrix(const glm::mat4& from, const glm::mat4& to, GLfloat alpha) {
+	glm::mat4 result(1.0f);
+	for (int c = 0; c < 3; c++) {
+		glm::vec3 a(from[c].x, from[c].y, from[c].z);
+		glm::vec3 b(to[c].x, to[c].y, to[c].z);
+		glm::vec3 column = a + (b - a) * alpha;
+		GLfloat length = glm::length(column);
+		GLfloat scale = glm::length(a) + (glm::length(b) - glm::length(a)) * alpha;
+		// A lerped rotation shrinks the basis: restore the interpolated scale
+		if (length > 0.0f) {
+			column = column * (scale / length);
+		}
+		result[c] = glm::vec4(column, 0.0f);
+	}
+	glm::vec3 fromPosition(from[3].x, from[3].y, from[3].z);
+	glm::vec3 toPosition(to[3].x, to[3].y, to[3].z);
+	result[3] = glm::vec4(fromPosition + (toPosition - fromPosition) * alpha, 1.0f);
+	return result;
+}
+
+void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef TRANSFORM_USE_SSE
+	// Column j of the result = sum over k of (column k of a) * b[j][k]
+	const float* pa = &a[0][0];
+	const float* pb = &b[0][0];
+	float* po = &out[0][0];
+	__m128 a0 = _mm_loadu_ps(pa);
+	__m128 a1 = _mm_loadu_ps(pa + 4);
+	__m128 a2 = _mm_loadu_ps(pa + 8);
+	__m128 a3 = _mm_loadu_ps(pa + 12);
+	for (int j = 0; j < 4; j++) {
+		__m128 r = _mm_mul_ps(a0, _mm_set1_ps(pb[j * 4]));
+		r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(pb[j * 4 + 1])));
+		r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(pb[j * 4 + 2])));
+		r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(pb[j * 4 + 3])));
+		_mm_storeu_ps(po + j * 4, r);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+TransformHierarchy::~TransformHierarchy() {}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+/*
+Parent/child transforms stored as contiguous arrays (SoA), one entry per node. A node is always created after
+its parent, so parents come first in every array and a single forward pass can update the whole hierarchy.
+
+Setters only mark the node dirty; update() recomputes the local matrix of the changed nodes and the world
+matrix of their whole subtree. Static nodes (the floor, for instance) keep their cached world matrix
+*/
+class TransformHierarchy
+{
+public:
+	static const GLuint NO_PARENT = 0xFFFFFFFF;
+
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	void reserve(size_t nodeCount);
+	// Args: (parent node or NO_PARENT, local position, local rotation, local scale)
+	GLuint createNode(GLuint parent, glm::vec3 position = glm::vec3(0.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+					glm::vec3 scale = glm::vec3(1.0f));
+
+	void setLocalPosition(GLuint node, const glm::vec3& position);
+	void setLocalRotation(GLuint node, const glm::quat& rotation);
+	void setLocalScale(GLuint node, const glm::vec3& scale);
+
+	glm::vec3 getLocalPosition(GLuint node) { return localPositions[node]; };
+	GLuint getParent(GLuint node) { return parents[node]; };
+	const glm::mat4& getWorldMatrix(GLuint node) { return worldMatrices[node]; };
+	// World matrix 'alpha' of the way from before the last update() to now (render interpolation)
+	glm::mat4 getInterpolatedMatrix(GLuint node, GLfloat alpha);
+	size_t getNodeCount() { return parents.size(); };
+	// Nodes whose world matrix was recomputed by the last update()
+	unsigned int getUpdatedCount() { return updatedCount; };
+
+	void update(); // Recomputes the dirty subtrees
+	void updateAll(); // Recomputes every node (reference for the benchmark)
+
+private:
+	static const size_t PARALLEL_GRAIN = 4096; // Nodes per job when a level is split across threads
+
+	// Hierarchy
+	std::vector<GLuint> parents;
+	std::vector<GLuint> depths; // 0 for roots. Nodes of the same depth never depend on each other
+
+	// Local TRS
+	std::vector<glm::vec3> localPositions;
+	std::vector<glm::quat> localRotations;
+	std::vector<glm::vec3> localScales;
+
+	// Cached matrices
+	std::vector<glm::mat4> localMatrices;
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<glm::mat4> previousWorldMatrices; // World matrices before the last update()
+	std::vector<GLuint> movedNodes; // Nodes whose previous and current world matrix differ
+	GLuint settledCount; // Nodes that existed at the last update(). Newer ones have no previous matrix yet
+
+	// Dirty tracking
+	std::vector<unsigned char> localDirty; // TRS changed since the last update
+	std::vector<unsigned char> worldDirty; // Scratch flags used while propagating
+	GLuint firstDirty; // Lowest dirty index. Nothing before it needs to be visited
+	std::vector<std::vector<GLuint> > levels; // Dirty nodes grouped by depth (reused between updates)
+	unsigned int updatedCount;
+
+	void markDirty(GLuint node);
+	void composeLocal(GLuint node);
+	void updateLevels();
+};
+
+// Blends two affine matrices: translation and basis columns are interpolated, column lengths (scale) kept
+glm::mat4 InterpolateMatrix(const glm::mat4& from, const glm::mat4& to, GLfloat alpha);
+
+// out = a * b (column-major 4x4). SSE when available, glm otherwise
+void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
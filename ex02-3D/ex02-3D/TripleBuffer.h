@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+
+/*
+Lock-free single producer / single consumer hand-off of the latest value. Three slots: the producer owns one
+(back), the consumer owns one (front) and the third (middle) is swapped atomically between them, so neither
+side ever waits for the other. The consumer always gets the most recent complete value; values the
+consumer was too slow to pick up are simply overwritten.
+
+	T& packet = buffer.getWriteBuffer(); ... buffer.publish();		// Producer thread
+	if (buffer.acquire()) { use(buffer.getReadBuffer()); }			// Consumer thread
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() {
+		back = 0;
+		state = 1; // Middle slot, nothing published yet
+		front = 2;
+	}
+
+	// Producer side
+	T& getWriteBuffer() { return slots[back]; };
+	void publish() {
+		// Hand the back slot over as the new middle and take the old middle to write the next value
+		unsigned int previous = state.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+		back = previous & INDEX_MASK;
+	}
+
+	// Consumer side. Returns false (and keeps the current front) when nothing new was published
+	bool acquire() {
+		if (!(state.load(std::memory_order_acquire) & FRESH_BIT)) {
+			return false;
+		}
+		unsigned int previous = state.exchange(front, std::memory_order_acq_rel);
+		front = previous & INDEX_MASK;
+		return true;
+	}
+	T& getReadBuffer() { return slots[front]; };
+
+private:
+	static const unsigned int INDEX_MASK = 3;
+	static const unsigned int FRESH_BIT = 4; // Set when the middle slot holds a value the consumer has not seen
+
+	T slots[3];
+	std::atomic<unsigned int> state; // Middle slot index | FRESH_BIT
+	unsigned int back; // Only touched by the producer
+	unsigned int front; // Only touched by the consumer
+};
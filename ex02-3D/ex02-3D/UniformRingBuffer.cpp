@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include "UniformRingBuffer.h"
+#include "GpuMemoryTracker.h"
+
+UniformRingBuffer::UniformRingBuffer() {
+	bufferID = 0;
+	mappedData = NULL;
+	persistent = false;
+	frameSize = 0;
+	alignment = 256;
+	framesInFlight = 0;
+	frameIndex = 0;
+	head = 0;
+	fenceWaits = 0;
+}
+
+bool UniformRingBuffer::Initialize(GLsizeiptr bytesPerFrame, unsigned int frames) {
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	// Every region has to start on an aligned offset as well
+	frameSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+	framesInFlight = frames > 0 ? frames : 1;
+	fences.assign(framesInFlight, (GLsync)0);
+
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+	persistent = GLEW_ARB_buffer_storage != 0;
+	if (persistent) {
+		// Immutable storage mapped once for the lifetime of the buffer. COHERENT: writes are seen without explicit flushes
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, frameSize * framesInFlight, NULL, flags);
+		mappedData = (GLubyte*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, frameSize * framesInFlight, flags);
+		if (!mappedData) {
+			printf("Failed to map the uniform ring buffer\n");
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			return false;
+		}
+	}
+	else {
+		glBufferData(GL_UNIFORM_BUFFER, frameSize * framesInFlight, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GpuMemoryTracker::trackObject(GL_BUFFER, bufferID, GPU_MEMORY_BUFFER, frameSize * framesInFlight, "Object uniform ring");
+	return true;
+}
+
+void UniformRingBuffer::beginFrame() {
+	frameIndex = (frameIndex + 1) % framesInFlight;
+	head = 0;
+
+	// The GPU may still be reading the region written 'framesInFlight' frames ago
+	if (fences[frameIndex]) {
+		GLenum result = glClientWaitSync(fences[frameIndex], 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			fenceWaits++;
+			// Args: (fence, flush the command queue, timeout in ns)
+			glClientWaitSync(fences[frameIndex], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		}
+		glDeleteSync(fences[frameIndex]);
+		fences[frameIndex] = 0;
+	}
+
+	if (!persistent) {
+		// Unsynchronized: the fence above already guarantees the region is free
+		glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		mappedData = (GLubyte*)glMapBufferRange(GL_UNIFORM_BUFFER, frameSize * frameIndex, frameSize,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
+
+GLintptr UniformRingBuffer::write(const void* data, GLsizeiptr size) {
+	if (head + size > frameSize) {
+		printf("Uniform ring buffer full (%ld bytes per frame)\n", (long)frameSize);
+		return -1;
+	}
+
+	GLubyte* regionStart = persistent ? mappedData + frameSize * frameIndex : mappedData;
+	if (!regionStart) {
+		printf("Uniform ring buffer written after flush()\n");
+		return -1;
+	}
+	memcpy(regionStart + head, data, size);
+
+	GLintptr offset = frameSize * frameIndex + head;
+	head += (size + alignment - 1) / alignment * alignment; // Next block starts on an aligned offset
+	return offset;
+}
+
+void UniformRingBuffer::flush() {
+	if (!persistent && mappedData) {
+		glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		mappedData = NULL;
+	}
+}
+
+void UniformRingBuffer::bindRange(GLuint bindingPoint, GLintptr offset, GLsizeiptr size) {
+	// Args: (target, binding point declared in the shader, buffer, offset, size)
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, bufferID, offset, size);
+}
+
+void UniformRingBuffer::endFrame() {
+	flush();
+	fences[frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UniformRingBuffer::clearRingBuffer() {
+	for (size_t i = 0; i < fences.size(); i++) {
+		if (fences[i]) {
+			glDeleteSync(fences[i]);
+		}
+	}
+	fences.clear();
+	if (bufferID != 0) {
+		if (persistent) {
+			glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+		GpuMemoryTracker::releaseObject(GL_BUFFER, bufferID);
+		glDeleteBuffers(1, &bufferID);
+		bufferID = 0;
+	}
+	mappedData = NULL;
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+	clearRingBuffer();
+}
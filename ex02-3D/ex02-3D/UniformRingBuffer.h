@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <GL\glew.h>
+
+/*
+Per-frame ring of uniform data. The buffer is split in 'framesInFlight' regions; every frame writes its
+per-object blocks linearly in its own region and binds them with glBindBufferRange. A fence placed at the
+end of the frame keeps the CPU from overwriting a region the GPU is still reading.
+
+Persistently mapped when GL_ARB_buffer_storage is available, otherwise the region is mapped unsynchronized
+every frame (the fences still protect it)
+*/
+class UniformRingBuffer
+{
+public:
+	UniformRingBuffer();
+	~UniformRingBuffer();
+
+	// Args: (bytes available per frame, number of frames in flight)
+	bool Initialize(GLsizeiptr bytesPerFrame, unsigned int framesInFlight);
+
+	void beginFrame(); // Waits (if needed) for the GPU to release the region of this frame
+	// Copies the block and returns its offset in the buffer, or -1 when the frame region is full
+	GLintptr write(const void* data, GLsizeiptr size);
+	void flush(); // Makes the writes visible to the GL. Call before the draws that use them
+	void bindRange(GLuint bindingPoint, GLintptr offset, GLsizeiptr size);
+	void endFrame(); // Fences the region of this frame
+
+	bool isPersistent() { return persistent; };
+	GLuint getBufferID() { return bufferID; };
+	unsigned int getFenceWaits() { return fenceWaits; }; // Times the CPU had to wait for the GPU
+	void clearRingBuffer();
+
+private:
+	GLuint bufferID;
+	GLubyte* mappedData; // Start of the current frame region while it is mapped
+	bool persistent;
+	GLsizeiptr frameSize;
+	GLint alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	unsigned int framesInFlight, frameIndex;
+	GLintptr head; // Write offset inside the current frame region
+	std::vector<GLsync> fences;
+	unsigned int fenceWaits;
+};
+
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "UniformTable.h"
+#include "AssetCache.h"
+
+UniformTable::UniformTable() {
+	program = 0;
+	mismatchCount = 0;
+}
+
+void UniformTable::reflect(GLuint program, const char* debugName) {
+	clearTable();
+	this->program = program;
+	this->debugName = debugName ? debugName : "";
+
+	if (GLEW_ARB_program_interface_query) {
+		// Type, size and location of every uniform in one query each
+		GLint uniformCount = 0, maxNameLength = 0;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+		std::vector<char> name((size_t)maxNameLength + 1);
+		const GLenum properties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+		for (GLint i = 0; i < uniformCount; i++) {
+			GLint values[3] = { 0, 0, -1 };
+			glGetProgramResourceiv(program, GL_UNIFORM, i, 3, properties, 3, NULL, values);
+			if (values[2] < 0) {
+				continue; // Member of a uniform block, set through its buffer
+			}
+			glGetProgramResourceName(program, GL_UNIFORM, i, (GLsizei)name.size(), NULL, name.data());
+			addEntry(name.data(), (GLenum)values[0], values[1], values[2]);
+		}
+	}
+	else {
+		GLint uniformCount = 0, maxNameLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<char> name((size_t)maxNameLength + 1);
+		for (GLint i = 0; i < uniformCount; i++) {
+			GLint arraySize = 0;
+			GLenum type = 0;
+			glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), NULL, &arraySize, &type, name.data());
+			GLint location = glGetUniformLocation(program, name.data());
+			if (location < 0) {
+				continue;
+			}
+			addEntry(name.data(), type, arraySize, location);
+		}
+	}
+
+	// At most half full, so a probe rarely goes past its first slot
+	size_t slotCount = 16;
+	while (slotCount < entries.size() * 2) {
+		slotCount *= 2;
+	}
+	slots.assign(slotCount, -1);
+	for (size_t i = 0; i < entries.size(); i++) {
+		size_t slot = (size_t)hashName(entries[i].name.c_str(), entries[i].name.size()) & (slotCount - 1);
+		while (slots[slot] >= 0) {
+			slot = (slot + 1) & (slotCount - 1);
+		}
+		slots[slot] = (int)i;
+	}
+	// Shadows of the whole uniforms, unknown until the first upload
+	size_t shadowWords = 0;
+	for (size_t i = 0; i < entries.size(); i++) {
+		entries[i].shadowOffset = shadowWords;
+		entries[i].shadowWords = typeWords(entries[i].handle.type) * (size_t)entries[i].handle.arraySize;
+		shadowWords += entries[i].shadowWords;
+	}
+	shadow.assign(shadowWords, 0);
+	std::sort(variables.begin(), variables.end());
+	variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+}
+
+void UniformTable::addEntry(const char* name, GLenum type, GLint arraySize, GLint location) {
+	Entry entry;
+	entry.name = name;
+	// Arrays are reported as their first element: "frustumPlanes[0]" is kept as "frustumPlanes"
+	size_t length = entry.name.size();
+	if (length > 3 && entry.name.compare(length - 3, 3, "[0]") == 0) {
+		entry.name.resize(length - 3);
+	}
+	entry.handle.location = location;
+	entry.handle.type = type;
+	entry.handle.arraySize = arraySize;
+	entry.handle.index = (int)entries.size();
+	entry.shadowOffset = 0;
+	entry.shadowWords = 0;
+	entry.knownWords = 0;
+	entries.push_back(entry);
+	variables.push_back(hashName(name, variableLength(name)));
+}
+
+UniformHandle UniformTable::find(const char* name, GLenum expectedType) {
+	UniformHandle handle = { -1, 0, 0, -1 };
+	size_t length = strlen(name);
+	if (length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+		length -= 3; // The whole array, as glGetUniformLocation takes it
+	}
+	int entry = findEntry(name, length);
+	if (entry >= 0) {
+		handle = entries[entry].handle;
+	}
+	else if (length > 0 && name[length - 1] == ']') {
+		// A later element of an array of values: only the first one is in the table, the driver knows the others
+		const char* bracket = name + length - 1;
+		while (bracket > name && *bracket != '[') {
+			bracket--;
+		}
+		int array = findEntry(name, (size_t)(bracket - name));
+		GLint index = (GLint)atoi(bracket + 1);
+		if (array >= 0 && index < entries[array].handle.arraySize) {
+			handle = entries[array].handle;
+			handle.location = glGetUniformLocation(program, name);
+			handle.arraySize -= index;
+			handle.index = -1; // The shadow covers the array from its first element
+		}
+	}
+
+	if (handle.location < 0) {
+		uint64_t variable = hashName(name, variableLength(name));
+		if (std::binary_search(variables.begin(), variables.end(), variable)) {
+			printf("Shader '%s': no uniform '%s', but the program has '%.*s' (misspelt, or past the end of the array?)\n",
+				debugName.c_str(), name, (int)variableLength(name), name);
+			mismatchCount++;
+		}
+		return handle;
+	}
+	if (expectedType != 0 && handle.type != expectedType) {
+		printf("Shader '%s': uniform '%s' is of type 0x%04X in the program, the code sets a 0x%04X\n",
+			debugName.c_str(), name, handle.type, expectedType);
+		mismatchCount++;
+	}
+	return handle;
+}
+
+bool UniformTable::updateShadow(const UniformHandle& uniform, const void* values, size_t words) {
+	if (uniform.index < 0 || (size_t)uniform.index >= entries.size()) {
+		return true;
+	}
+	Entry& entry = entries[uniform.index];
+	if (words > entry.shadowWords) {
+		entry.knownWords = 0; // More than the uniform holds: the driver decides what is kept
+		return true;
+	}
+	GLuint* shadowValues = shadow.data() + entry.shadowOffset;
+	if (words <= entry.knownWords && memcmp(shadowValues, values, words * sizeof(GLuint)) == 0) {
+		return false;
+	}
+	memcpy(shadowValues, values, words * sizeof(GLuint));
+	entry.knownWords = std::max(entry.knownWords, words); // The elements after the ones set keep their values
+	return true;
+}
+
+int UniformTable::findEntry(const char* name, size_t length) {
+	if (slots.empty()) {
+		return -1;
+	}
+	size_t slot = (size_t)hashName(name, length) & (slots.size() - 1);
+	while (slots[slot] >= 0) {
+		const std::string& entryName = entries[slots[slot]].name;
+		if (entryName.size() == length && entryName.compare(0, length, name, length) == 0) {
+			return slots[slot];
+		}
+		slot = (slot + 1) & (slots.size() - 1);
+	}
+	return -1;
+}
+
+uint64_t UniformTable::hashName(const char* name, size_t length) {
+	return AssetCache::hashBytes(name, length, 0);
+}
+
+size_t UniformTable::variableLength(const char* name) {
+	return strcspn(name, ".[");
+}
+
+size_t UniformTable::typeWords(GLenum type) {
+	switch (type) {
+	case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+	case GL_SAMPLER_2D: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+		return 1;
+	case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2:
+		return 2;
+	case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3:
+		return 3;
+	case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_FLOAT_MAT2:
+		return 4;
+	case GL_FLOAT_MAT3:
+		return 9;
+	case GL_FLOAT_MAT4:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+void UniformTable::clearTable() {
+	program = 0;
+	entries.clear();
+	slots.clear();
+	shadow.clear();
+	variables.clear();
+	mismatchCount = 0;
+}
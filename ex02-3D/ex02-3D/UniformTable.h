@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+
+// A uniform of a linked program, looked up once (Shader::getUniform) and kept for the glUniform* calls
+struct UniformHandle
+{
+	GLint location; // -1 when the program does not have it (glUniform* then does nothing)
+	GLenum type; // GL_FLOAT_VEC3, GL_SAMPLER_2D... 0 when the program does not have it
+	GLint arraySize; // 1 for a single value
+	int index; // Entry of the uniform in the table of its program, -1 when its value is not shadowed
+};
+
+// Handle of no uniform: what members hold until their program is built and looked up
+static const UniformHandle NO_UNIFORM = { -1, 0, 0, -1 };
+
+/*
+The active uniforms of a program, read once after it links (ARB_program_interface_query, glGetActiveUniform without
+it) into a table hashed by name. Looking a name up is then a hash probe instead of a driver call per name, and the
+names the driver does not know are the only ones it is asked about.
+
+find() also checks what the C++ side expects against what the program declares, so mismatches show up at load:
+- a uniform of another type than expected
+- a name the program does not have while it has its variable ('spotLights[0].base.color' with a 'spotLights' array):
+  a misspelt member or an index past the array of the shader
+A name without its variable in the program is not reported, the shader does not use it (or the compiler removed it)
+
+The table also shadows the values last uploaded to each uniform (uniform values are state of the program, they stay
+between glUseProgram calls): Shader::setUniform only calls glUniform* when the value changed
+*/
+class UniformTable
+{
+public:
+	UniformTable();
+
+	// Reads the active uniforms of 'program' (linked). 'debugName' names the program in the mismatch messages
+	void reflect(GLuint program, const char* debugName);
+	// 'name' as in GLSL ("pointLights[1].base.color", "frustumPlanes" or "frustumPlanes[0]" for a whole array).
+	// 'expectedType' 0: any type
+	UniformHandle find(const char* name, GLenum expectedType = 0);
+	// True when 'values' ('words' 32-bit words) differ from the value the uniform was last set to, which they then
+	// replace. Always true for a handle without a shadow (the upload cannot be skipped)
+	bool updateShadow(const UniformHandle& uniform, const void* values, size_t words);
+	void clearTable();
+
+	size_t getUniformCount() { return entries.size(); };
+	unsigned int getMismatchCount() { return mismatchCount; };
+
+private:
+	struct Entry
+	{
+		std::string name; // Without the "[0]" the driver adds to arrays
+		UniformHandle handle;
+		size_t shadowOffset; // In 'shadow'
+		size_t shadowWords; // Room for the whole uniform (all its array elements), 0 for types not shadowed
+		size_t knownWords; // Leading words of the shadow that hold uploaded values
+	};
+
+	GLuint program;
+	std::string debugName;
+	std::vector<Entry> entries;
+	std::vector<int> slots; // Open addressing on the hash of the name: index in 'entries', -1 when empty
+	std::vector<GLuint> shadow; // Compared and copied as raw bits, whatever the type
+	std::vector<uint64_t> variables; // Hashes of the variable names ('spotLights' for 'spotLights[0].edge'), sorted
+	unsigned int mismatchCount;
+
+	void addEntry(const char* name, GLenum type, GLint arraySize, GLint location);
+	int findEntry(const char* name, size_t length);
+	static uint64_t hashName(const char* name, size_t length);
+	static size_t variableLength(const char* name); // Characters up to the first '.' or '['
+	static size_t typeWords(GLenum type); // 32-bit words of one value of 'type' (0: not shadowed)
+};
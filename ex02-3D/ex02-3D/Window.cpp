@@ -1,4 +1,11 @@
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include "Window.h"
+#include "RedrawTracker.h"
+#include "GpuMemoryTracker.h"
 
 Window::Window() {
 	width = 800;
@@ -12,6 +19,22 @@ Window::Window() {
 	xChange = 0.0f;
 	yChange = 0.0f;
 	mouseFirstMove = true;
+
+	mainWindow = NULL;
+	headless = false;
+	frameLimit = 0;
+	framesRendered = 0;
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	eglDisplay = NULL;
+	eglContext = NULL;
+
+	inputRecorder = NULL;
+	inputReplay = NULL;
+	eventFrame = 0;
+	replayFrameSeconds = -1.0f;
+	closeRequested = false;
 }
 
 Window::Window(GLint windowWidth, GLint windowHeight) {
@@ -26,15 +49,48 @@ Window::Window(GLint windowWidth, GLint windowHeight) {
 	xChange = 0.0f;
 	yChange = 0.0f;
 	mouseFirstMove = true;
+
+	mainWindow = NULL;
+	headless = false;
+	frameLimit = 0;
+	framesRendered = 0;
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	eglDisplay = NULL;
+	eglContext = NULL;
+
+	inputRecorder = NULL;
+	inputReplay = NULL;
+	eventFrame = 0;
+	replayFrameSeconds = -1.0f;
+	closeRequested = false;
 }
 
 Window::~Window() {
+	clearFramebuffer();
+#ifdef __linux__
+	if (eglDisplay) {
+		eglMakeCurrent((EGLDisplay)eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext((EGLDisplay)eglDisplay, (EGLContext)eglContext);
+		eglTerminate((EGLDisplay)eglDisplay);
+	}
+#endif
 	glfwDestroyWindow(mainWindow);
 	glfwTerminate();
 }
 
+void Window::setHeadless(unsigned int frameCount) {
+	headless = true;
+	frameLimit = frameCount;
+}
+
 
 int Window::Initialize() {
+	if (headless) {
+		return initializeHeadless();
+	}
+
 	/********************************
 	*	Guarantee Compatibility
 	*********************************/
@@ -103,12 +159,60 @@ int Window::Initialize() {
 	The pointer is 'this', the current class
 	*/
 	glfwSetWindowUserPointer(mainWindow, this); 
+
+	return 0;
 }
 
 void Window::swapBuffer() {
+	if (headless) {
+		// Nothing to present: wait for the frame to finish so frame times include the rendering
+		glFinish();
+		framesRendered++;
+		return;
+	}
 	glfwSwapBuffers(mainWindow);
 }
 
+void Window::pollEvents(double timeout) {
+	// Headless has no input of its own. During a replay GLFW events are still processed (window close, refresh)
+	if (!headless) {
+		if (timeout > 0.0 && !inputReplay) {
+			glfwWaitEventsTimeout(timeout);
+		}
+		else {
+			glfwPollEvents();
+		}
+	}
+
+	// Recorded events of this frame go through the same path as live ones
+	if (inputReplay) {
+		InputEvent event;
+		replayFrameSeconds = -1.0f;
+		while (inputReplay->nextEvent(eventFrame, event)) {
+			if (event.type == INPUT_KEY) {
+				processKey(event.key, event.action);
+			}
+			else if (event.type == INPUT_CURSOR) {
+				processCursor(event.x, event.y);
+			}
+			else if (event.type == INPUT_END) {
+				closeRequested = true;
+			}
+			else if (event.type == INPUT_FRAME) {
+				replayFrameSeconds = event.x;
+			}
+		}
+	}
+	eventFrame++;
+}
+
+double Window::getTime() {
+	if (headless) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	return glfwGetTime();
+}
+
 // Args are automatically filled in by the 'glfwSetKeyCallback()' function
 // Args: (window, key, code related to the key, action (press, release etc.), mode related to the action)
 void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int mode) {
@@ -117,21 +221,32 @@ void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int m
 	The type returned is generic so a casting to <Window*> is necessary.
 	*/
 	Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+	if (theWindow->inputReplay) {
+		return; // Live input is ignored during a replay
+	}
+	if (theWindow->inputRecorder) {
+		theWindow->inputRecorder->recordKey(theWindow->eventFrame, (float)theWindow->getTime(), key, action);
+	}
+	theWindow->processKey(key, action);
+}
+
+void Window::processKey(int key, int action) {
+	RedrawTracker::markDirty();
 
 	// Close the window when 'esc' is pressed
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-		glfwSetWindowShouldClose(window, GL_TRUE);
+		closeRequested = true;
 		return;
 	}
 
 	// Store key presses/releases in the keys array
-	if (key >= 0 && key <= 1024) { 	// Guarantees conformity to our UTF-8 array size
+	if (key >= 0 && key < 1024) { 	// Guarantees conformity to our UTF-8 array size
 		if (action == GLFW_PRESS) {
-			theWindow->keys[key] = true;
+			keys[key] = true;
 			//printf("Pressed %d\n", key);
 		}
 		else if (action == GLFW_RELEASE) {
-			theWindow->keys[key] = false;
+			keys[key] = false;
 			//printf("Released %d\n", key);
 		}
 	}
@@ -139,26 +254,43 @@ void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int m
 
 void Window::handleMouse(GLFWwindow* window, double xPos, double yPos) {
 	Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+	if (theWindow->inputReplay) {
+		return;
+	}
+	if (theWindow->inputRecorder) {
+		theWindow->inputRecorder->recordCursor(theWindow->eventFrame, (float)theWindow->getTime(), xPos, yPos);
+	}
+	theWindow->processCursor(xPos, yPos);
+}
 
-	if (theWindow->mouseFirstMove) {
-		theWindow->xLast = xPos;
-		theWindow->yLast = yPos;
-		theWindow->mouseFirstMove = false;
+void Window::processCursor(double xPos, double yPos) {
+	RedrawTracker::markDirty();
+
+	if (mouseFirstMove) {
+		xLast = xPos;
+		yLast = yPos;
+		mouseFirstMove = false;
 	}
 
-	theWindow->xChange = xPos - theWindow->xLast;
-	theWindow->yChange = theWindow->yLast - yPos;
+	xChange = xPos - xLast;
+	yChange = yLast - yPos;
 
-	theWindow->xLast = xPos;
-	theWindow->yLast = yPos;
+	xLast = xPos;
+	yLast = yPos;
 
-	//printf("x: %.2f y: %.2f\n", theWindow->xChange, theWindow->yChange);
+	//printf("x: %.2f y: %.2f\n", xChange, yChange);
 }
 
 
 void Window::createCallbacks() {
 	glfwSetKeyCallback(mainWindow, handleKeys);
 	glfwSetCursorPosCallback(mainWindow, handleMouse);
+	glfwSetWindowRefreshCallback(mainWindow, handleRefresh);
+}
+
+// The window was uncovered/restored and its contents have to be drawn again (render-on-demand mode)
+void Window::handleRefresh(GLFWwindow* window) {
+	RedrawTracker::markDirty();
 }
 
 GLfloat Window::getXChange() {
@@ -174,3 +306,154 @@ GLfloat Window::getYChange() {
 }
 
 
+
+/********************************
+*	Headless mode
+*********************************/
+/*
+No display needed: on Linux a surfaceless EGL context (works with Mesa's llvmpipe on machines without a GPU).
+Elsewhere, or when EGL is not available, an invisible GLFW window provides the context.
+Either way everything is drawn into an offscreen framebuffer of the requested size
+*/
+int Window::initializeHeadless() {
+	startTime = std::chrono::steady_clock::now();
+	bufferWidth = width;
+	bufferHeight = height;
+
+	if (createEGLContext()) {
+		// glewInit() also looks for a GLX/WGL display, which does not exist here. Load the GL functions only
+		glewExperimental = GL_TRUE;
+		if (glewContextInit() != GLEW_OK) {
+			printf("GLEW did not initialize");
+			return 1;
+		}
+	}
+	else {
+		if (!glfwInit()) {
+			printf("GLFW was not initialized");
+			return 1;
+		}
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+		mainWindow = glfwCreateWindow(width, height, "Headless", NULL, NULL);
+		if (!mainWindow) {
+			printf("Neither EGL nor GLFW could create a headless context");
+			glfwTerminate();
+			return 1;
+		}
+		glfwMakeContextCurrent(mainWindow);
+		glewExperimental = GL_TRUE;
+		if (glewInit() != GLEW_OK) {
+			printf("GLEW did not initialize");
+			return 1;
+		}
+	}
+
+	if (!createFramebuffer()) {
+		return 1;
+	}
+	printf("Headless: %d x %d offscreen, %u frames, renderer '%s', OpenGL %s\n", width, height, frameLimit,
+		(const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, bufferWidth, bufferHeight);
+	return 0;
+}
+
+bool Window::createEGLContext() {
+#ifdef __linux__
+	// Surfaceless platform first (no X11/Wayland/GBM device needed), then whatever the default display is
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		printf("EGL: no display available\n");
+		return false;
+	}
+
+	// Desktop OpenGL core: 4.3 first (indirect path and compute culling), 3.3 like the windowed context otherwise
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	const EGLint versions[][2] = { { 4, 3 }, { 3, 3 } };
+	EGLConfig config;
+	EGLint configCount = 0;
+	EGLContext context = EGL_NO_CONTEXT;
+	if (eglBindAPI(EGL_OPENGL_API) && eglChooseConfig(display, configAttributes, &config, 1, &configCount) && configCount > 0) {
+		for (int i = 0; i < 2 && context == EGL_NO_CONTEXT; i++) {
+			const EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, versions[i][0],
+				EGL_CONTEXT_MINOR_VERSION, versions[i][1],
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE
+			};
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		}
+	}
+	// No surface at all: the context only ever draws into our framebuffer (EGL_KHR_surfaceless_context)
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		printf("EGL %d.%d: could not create a surfaceless OpenGL core context (4.3 or 3.3)\n", major, minor);
+		if (context != EGL_NO_CONTEXT) {
+			eglDestroyContext(display, context);
+		}
+		eglTerminate(display);
+		return false;
+	}
+	eglDisplay = display;
+	eglContext = context;
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Window::createFramebuffer() {
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	GpuMemoryTracker::trackObject(GL_RENDERBUFFER, colorBuffer, GPU_MEMORY_RENDER_TARGET, (long long)width * height * 4, "Offscreen color");
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	GpuMemoryTracker::trackObject(GL_RENDERBUFFER, depthBuffer, GPU_MEMORY_RENDER_TARGET, (long long)width * height * 4, "Offscreen depth/stencil");
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	GpuMemoryTracker::trackObject(GL_FRAMEBUFFER, framebuffer, GPU_MEMORY_RENDER_TARGET, 0, "Offscreen framebuffer");
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	// Stays bound: it takes the place of the window's default framebuffer
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Offscreen framebuffer is incomplete");
+		return false;
+	}
+	return true;
+}
+
+void Window::clearFramebuffer() {
+	if (framebuffer == 0) {
+		return;
+	}
+	GpuMemoryTracker::releaseObject(GL_FRAMEBUFFER, framebuffer);
+	GpuMemoryTracker::releaseObject(GL_RENDERBUFFER, colorBuffer);
+	GpuMemoryTracker::releaseObject(GL_RENDERBUFFER, depthBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+}
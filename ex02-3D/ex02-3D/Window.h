@@ -1,20 +1,41 @@
 #pragma once
 #include <stdio.h>
+#include <chrono>
 #include <GL\glew.h>
 #include <GLFW\glfw3.h>
 
+#include "InputRecorder.h"
+
 class Window
 {
 public:
 	Window();
 	Window(GLint windowWidth, GLint windowHeight);
 	~Window();
+	// Render N frames into an offscreen framebuffer instead of a window (call before Initialize)
+	void setHeadless(unsigned int frameCount);
 	int Initialize();
 	void swapBuffer();
+	// Deletes the offscreen framebuffer of headless mode (also done by the destructor). Nothing can be drawn after it
+	void clearFramebuffer();
+	// Processes pending input events. With a timeout, sleeps up to that many seconds until one arrives
+	void pollEvents(double timeout = 0.0);
+	// Seconds since initialization
+	double getTime();
+	// Number of pollEvents() calls so far: the frame input events belong to
+	unsigned int getEventFrame() { return eventFrame; };
+
+	// Every key/cursor event is also written to 'recorder' (NULL to stop)
+	void setInputRecorder(InputRecorder* recorder) { inputRecorder = recorder; };
+	// Events come from 'replay' instead of the keyboard and mouse (NULL to go back to live input)
+	void setInputReplay(InputReplay* replay) { inputReplay = replay; };
+	// Time the replayed frame simulated when it was recorded, negative when the log does not have it
+	GLfloat getReplayFrameSeconds() { return replayFrameSeconds; };
 
 	GLfloat getBufferWidth() { return (GLfloat)bufferWidth; };
 	GLfloat getBufferHeight() { return (GLfloat)bufferHeight; };
-	bool getWindowShouldClose() { return glfwWindowShouldClose(mainWindow); };
+	bool getWindowShouldClose() { return closeRequested || (headless ? framesRendered >= frameLimit : glfwWindowShouldClose(mainWindow) != 0); };
+	bool isHeadless() { return headless; };
 	bool* getKeys() { return keys; };
 	GLfloat getXChange();
 	GLfloat getYChange();
@@ -25,16 +46,39 @@ private:
 	GLint width, height;
 	GLint bufferWidth, bufferHeight;
 
+	// Headless mode: no window and no input, frames go to 'framebuffer'
+	bool headless;
+	unsigned int frameLimit, framesRendered;
+	GLuint framebuffer, colorBuffer, depthBuffer;
+	void* eglDisplay; // EGLDisplay/EGLContext, kept opaque so this header does not need EGL
+	void* eglContext;
+	std::chrono::steady_clock::time_point startTime;
+
+	int initializeHeadless();
+	bool createEGLContext();
+	bool createFramebuffer();
+
 	// Keyboard/mouse callback config
 	void createCallbacks();
 
 	// Keyboard config
 	bool keys[1024]; // UTF-8
 	static void handleKeys(GLFWwindow* window, int key, int code, int action, int mode);
+	void processKey(int key, int action);
 	
 	// Mouse config
 	bool mouseFirstMove; // Check if it is the first move (React based off offset)
 	GLfloat xLast, yLast, xChange, yChange;
 	static void handleMouse(GLFWwindow* window, double xPos, double yPos);
+	void processCursor(double xPos, double yPos);
+
+	// Input recording/replay
+	InputRecorder* inputRecorder;
+	InputReplay* inputReplay;
+	unsigned int eventFrame;
+	GLfloat replayFrameSeconds;
+	bool closeRequested; // Escape pressed (live or replayed) or the replay ended
+
+	static void handleRefresh(GLFWwindow* window);
 };
 